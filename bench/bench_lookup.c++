@@ -0,0 +1,110 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** bench_lookup.c++ --- per code point cost of the table lookups
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Built three times (see bench/CMakeLists.txt): against the shared library, against the static
+ * library with LTO and with LIBUNI_HEADER_ONLY.  Compare the output of the three binaries to see
+ * what the call into the library costs.  Use a Release build!
+ */
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+#include <libuni/segmentation.hpp>
+#include <libuni/utf32.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+#ifndef BENCH_VARIANT
+#define BENCH_VARIANT "unknown"
+#endif
+
+namespace {
+  volatile std::size_t sink;
+
+  /// Runs of ASCII, Latin-1/Latin Extended, Cyrillic, CJK and Hangul text.
+  std::u32string
+  sample_text(std::size_t size) {
+    static libuni::codepoint_t const bases[] = { 0x20, 0xC0, 0x400, 0x4E00, 0xAC00 };
+    std::u32string text;
+    text.reserve(size);
+    std::uint32_t x = 2463534242u;
+    while(text.size() < size) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      libuni::codepoint_t const base = bases[x % (sizeof(bases)/sizeof(bases[0]))];
+      for(std::size_t run = 4 + (x >> 8) % 12; run > 0 and text.size() < size; --run) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        text.push_back(base + x % 0x5F);
+      }
+    }
+    return text;
+  }
+
+  template<typename F>
+  void
+  run(char const *name, std::u32string const &text, F f) {
+    double best = 1e300;
+    for(std::size_t rep = 0; rep < 11; ++rep) {
+      auto const start = std::chrono::steady_clock::now();
+      sink = f(text);
+      auto const stop = std::chrono::steady_clock::now();
+      best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    std::printf("%-8s %-24s %8.3f ns/codepoint\n", BENCH_VARIANT, name, best / text.size());
+  }
+}
+
+int
+main() {
+#ifndef NDEBUG
+  std::printf("# assertions enabled, numbers are meaningless for a Debug build\n");
+#endif
+  std::u32string const text = sample_text(1 << 20);
+
+  run("get_quick_check", text, [](std::u32string const &s) {
+      std::size_t acc = 0;
+      for(auto i = s.cbegin(); i != s.cend(); ++i) {
+        acc += libuni::helper::get_quick_check(*i);
+      }
+      return acc;
+    });
+  run("get_decomp_mapping", text, [](std::u32string const &s) {
+      std::size_t acc = 0;
+      for(auto i = s.cbegin(); i != s.cend(); ++i) {
+        std::size_t prefix;
+        libuni::codepoint_t const *begin, *end;
+        acc += libuni::helper::get_decomp_mapping(*i, prefix, begin, end);
+      }
+      return acc;
+    });
+  run("get_word_breaks", text, [](std::u32string const &s) {
+      std::size_t acc = 0;
+      for(auto i = s.cbegin(); i != s.cend(); ++i) {
+        acc += libuni::helper::get_word_breaks(*i);
+      }
+      return acc;
+    });
+  run("uppercase_mapping", text, [](std::u32string const &s) {
+      std::size_t acc = 0;
+      for(auto i = s.cbegin(); i != s.cend(); ++i) {
+        acc += libuni::uppercase_mapping(*i);
+      }
+      return acc;
+    });
+  run("isNFC", text, [](std::u32string const &s) { // sample_text is in NFC, no early exit
+      return std::size_t(libuni::isNFC(s));
+    });
+  run("toUppercase", text, [](std::u32string const &s) {
+      return libuni::toUppercase(s).size();
+    });
+}
@@ -0,0 +1,324 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** bench_throughput.c++ --- throughput of the main libuni operations per script
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Runs every benchmark on every corpus (see corpus.hpp) and prints a table.  With --json the
+ * results are also written as JSON, e.g., to diff two builds:
+ *
+ *   make bench  # writes bench.json in the build directory
+ *
+ * Throughput is always relative to the size of the UTF-8 input, even for next_word which works
+ * on code points (the decoding is not measured).  sort_key generates the keys of 32 byte pieces of
+ * the corpus into a buffer, sort_key(string) returns them as strings.  find searches for a pattern
+ * which does not occur.  to_upper_inplace includes copying the corpus.  nfkd+words splits toLowercase(toNFKD(s)) into words, view::words does the same with
+ * lazy views (see view.hpp).  get_properties and lookup_properties classify the decoded corpus.
+ * Note that the isNFC result for arabic is an early exit: that corpus is not in canonical order.
+ * Use a Release build!  Set LIBUNI_SIMD to compare the SIMD levels (see simd.hpp).
+ */
+#include "harness.hpp"
+#include "corpus.hpp"
+
+#include <libuni/utf8.hpp>
+#include <libuni/utf_convert.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+#include <libuni/segmentation.hpp>
+#include <libuni/collation.hpp>
+#include <libuni/search.hpp>
+#include <libuni/hash.hpp>
+#include <libuni/cache.hpp>
+#include <libuni/view.hpp>
+#include <libuni/properties.hpp>
+#include <libuni/simd.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+namespace bench {
+  volatile std::size_t sink;
+
+  namespace {
+    void
+    json_string(std::ostream &out, std::string const &s) {
+      out << '"';
+      for(std::string::const_iterator i = s.begin(); i != s.end(); ++i) {
+        if(*i == '"' or *i == '\\') {
+          out << '\\' << *i;
+        }
+        else if(static_cast<unsigned char>(*i) < 0x20) {
+          char buf[8];
+          std::sprintf(buf, "\\u%04x", unsigned(*i));
+          out << buf;
+        }
+        else {
+          out << *i;
+        }
+      }
+      out << '"';
+    }
+  }
+
+  void
+  print_json(std::ostream &out, std::vector<result> const &results) {
+    out << "{\n  \"build\": \"" <<
+#ifdef NDEBUG
+      "release"
+#else
+      "debug"
+#endif
+        << "\",\n  \"simd\": \"" << libuni::simd::level_name(libuni::simd::active_level())
+        << "\",\n  \"results\": [\n";
+    for(std::size_t i = 0; i < results.size(); ++i) {
+      result const &r = results[i];
+      out << "    {\"benchmark\": ";
+      json_string(out, r.benchmark);
+      out << ", \"corpus\": ";
+      json_string(out, r.corpus);
+      out << ", \"bytes\": " << r.bytes
+          << ", \"repetitions\": " << r.repetitions
+          << ", \"median_ns\": " << r.median_ns
+          << ", \"p99_ns\": " << r.p99_ns
+          << ", \"min_ns\": " << r.min_ns
+          << ", \"mb_per_s\": " << r.mb_per_s()
+          << ", \"cycles_per_byte\": ";
+      if(r.cycles_per_byte < 0) {
+        out << "null";
+      }
+      else {
+        out << r.cycles_per_byte;
+      }
+      out << (i + 1 == results.size() ? "}\n" : "},\n");
+    }
+    out << "  ]\n}\n";
+  }
+
+  void
+  print_table(std::ostream &out, std::vector<result> const &results) {
+    out << "# simd: " << libuni::simd::level_name(libuni::simd::active_level()) << '\n';
+    out << std::left << std::setw(16) << "benchmark" << std::setw(12) << "corpus"
+        << std::right << std::setw(12) << "MB/s" << std::setw(12) << "cycles/B"
+        << std::setw(14) << "median ms" << std::setw(14) << "p99 ms" << '\n';
+    for(std::vector<result>::const_iterator r = results.begin(); r != results.end(); ++r) {
+      out << std::left << std::setw(16) << r->benchmark << std::setw(12) << r->corpus << std::right
+          << std::fixed << std::setprecision(1) << std::setw(12) << r->mb_per_s()
+          << std::setprecision(2) << std::setw(12) << r->cycles_per_byte
+          << std::setprecision(3) << std::setw(14) << r->median_ns / 1e6
+          << std::setw(14) << r->p99_ns / 1e6 << '\n';
+    }
+  }
+}
+
+namespace {
+  void
+  usage(char const *argv0) {
+    std::cerr <<
+      "usage: " << argv0 << " [options] [files...]\n"
+      "Runs the throughput benchmarks on the synthetic corpora and on the UTF-8 files given.\n\n"
+      "  --json FILE     also write the results as JSON to FILE (- for stdout)\n"
+      "  --size BYTES    size of each synthetic corpus [1048576]\n"
+      "  --reps N        measured repetitions [21]\n"
+      "  --warmup N      warmup runs [3]\n"
+      "  --filter TEXT   only run benchmarks or corpora whose name contains TEXT\n"
+      "  --no-synthetic  only use the files given\n";
+  }
+
+  /// Splits s at code point boundaries into keys of about size bytes (like the entries of an index).
+  std::vector<std::string>
+  split_keys(std::string const &s, std::size_t size) {
+    std::vector<std::string> ret;
+    std::string::size_type begin = 0;
+    while(begin < s.size()) {
+      std::string::size_type end = std::min(begin + size, s.size());
+      while(end < s.size() and (static_cast<unsigned char>(s[end]) & 0xC0) == 0x80) {
+        ++end;
+      }
+      ret.push_back(s.substr(begin, end - begin));
+      begin = end;
+    }
+    return ret;
+  }
+
+  /// Measures f on corpus c unless filtered out.
+  template<typename F>
+  void
+  run(std::vector<bench::result> &results, std::string const &benchmark, bench::corpus const &c,
+      bench::options const &opt, std::string const &filter, F f)
+  {
+    if(filter.empty() or
+       benchmark.find(filter) != std::string::npos or c.name.find(filter) != std::string::npos)
+    {
+      results.push_back(bench::measure(benchmark, c.name, c.utf8.size(), f, opt));
+    }
+  }
+}
+
+int
+main(int argc, char **argv) {
+  using namespace bench;
+
+  options opt;
+  std::size_t size = 1 << 20;
+  std::string json;
+  std::string filter;
+  bool synthetic = true;
+  std::vector<corpus> corpora;
+  for(int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if(i + 1 < argc and arg == "--json") {
+      json = argv[++i];
+    }
+    else if(i + 1 < argc and arg == "--size") {
+      size = std::strtoul(argv[++i], 0, 10);
+    }
+    else if(i + 1 < argc and arg == "--reps") {
+      opt.repetitions = std::max(1ul, std::strtoul(argv[++i], 0, 10));
+    }
+    else if(i + 1 < argc and arg == "--warmup") {
+      opt.warmup = std::strtoul(argv[++i], 0, 10);
+    }
+    else if(i + 1 < argc and arg == "--filter") {
+      filter = argv[++i];
+    }
+    else if(arg == "--no-synthetic") {
+      synthetic = false;
+    }
+    else if(arg.empty() or arg[0] == '-') {
+      usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+    else {
+      corpus c;
+      if(not load_corpus(arg, c)) {
+        std::cerr << "Failed to read `" << arg << "'\n";
+        return 1;
+      }
+      corpora.push_back(c);
+    }
+  }
+  if(synthetic) {
+    std::vector<corpus> const s = synthetic_corpora(size);
+    corpora.insert(corpora.begin(), s.begin(), s.end());
+  }
+
+#ifndef NDEBUG
+  std::cerr << "# assertions enabled, numbers are meaningless for a Debug build\n";
+#endif
+
+  std::vector<result> results;
+  for(std::vector<corpus>::const_iterator c = corpora.begin(); c != corpora.end(); ++c) {
+    std::string const &s = c->utf8;
+    std::u32string const s32 = libuni::utf8_to_utf32(s);
+    std::string const nfd = libuni::toNFD(s);
+    std::vector<std::string> const keys = split_keys(s, 32);
+    libuni::normalization_cache cache(1 << 16);
+    std::vector<libuni::character_properties> properties(s32.size() + 1);
+    libuni::searcher const absent(std::string("Zw\xC3\xB6lf\xE2\x98\x83")); // scans the whole corpus
+
+    libuni::char8_t const *const bytes = reinterpret_cast<libuni::char8_t const*>(s.data());
+
+    run(results, "is_wellformed", *c, opt, filter, [&]() -> std::size_t {
+        return libuni::utf8::is_wellformed(bytes, bytes + s.size());
+      });
+    run(results, "utf8_to_utf32", *c, opt, filter, [&]() { return libuni::utf8_to_utf32(s).size(); });
+    run(results, "toNFD", *c, opt, filter, [&]() { return libuni::toNFD(s).size(); });
+    run(results, "toNFKD", *c, opt, filter, [&]() { return libuni::toNFKD(s).size(); });
+    run(results, "isNFC", *c, opt, filter, [&]() -> std::size_t { return libuni::isNFC(s); });
+    run(results, "toNFC", *c, opt, filter, [&]() { return libuni::toNFC(s).size(); });
+    run(results, "nfc_hash", *c, opt, filter, [&]() { return libuni::nfc_hash(s); });
+    run(results, "nfc_hash(nfd)", *c, opt, filter, [&]() { return libuni::nfc_hash(nfd); });
+    run(results, "toUppercase", *c, opt, filter, [&]() { return libuni::toUppercase(s).size(); });
+    run(results, "to_upper_inplace", *c, opt, filter, [&]() -> std::size_t {
+        std::string t = s;
+        libuni::to_upper_inplace(t);
+        return t.size();
+      });
+    run(results, "next_word", *c, opt, filter, [&]() -> std::size_t {
+        std::size_t n = 0;
+        std::u32string::const_iterator word_begin, word_end = s32.begin();
+        while(libuni::next_word(word_begin, word_end, s32.end())) {
+          ++n;
+        }
+        return n;
+      });
+    run(results, "get_properties", *c, opt, filter, [&]() -> std::size_t {
+        std::size_t n = 0;
+        for(std::u32string::const_iterator i = s32.begin(); i != s32.end(); ++i) {
+          n += libuni::get_properties(*i).alphabetic();
+        }
+        return n;
+      });
+    run(results, "lookup_properties", *c, opt, filter, [&]() -> std::size_t {
+        libuni::lookup_properties(s32.data(), s32.size(), properties.data());
+        return properties[s32.size() / 2].bits;
+      });
+    run(results, "find", *c, opt, filter, [&]() { return absent.find(s); });
+    run(results, "nfkd+words", *c, opt, filter, [&]() -> std::size_t {
+        std::u32string const t = libuni::toLowercase(libuni::toNFKD(s32));
+        std::size_t n = 0;
+        std::u32string::const_iterator word_begin, word_end = t.begin();
+        while(libuni::next_word(word_begin, word_end, t.end())) {
+          ++n;
+        }
+        return n;
+      });
+    run(results, "view::words", *c, opt, filter, [&]() -> std::size_t {
+        namespace view = libuni::view;
+        std::size_t n = 0;
+        auto w = view::words(view::lowercased(view::nfkd(view::decoded(s))));
+        for(auto i = w.begin(); i != w.end(); ++i) {
+          ++n;
+        }
+        return n;
+      });
+    run(results, "sort_key", *c, opt, filter, [&]() -> std::size_t {
+        unsigned char key[256];
+        std::size_t n = 0;
+        for(std::vector<std::string>::const_iterator k = keys.begin(); k != keys.end(); ++k) {
+          n += libuni::sort_key(*k, key, sizeof(key));
+        }
+        return n;
+      });
+    run(results, "sort_key(string)", *c, opt, filter, [&]() -> std::size_t {
+        std::size_t n = 0;
+        for(std::vector<std::string>::const_iterator k = keys.begin(); k != keys.end(); ++k) {
+          n += libuni::sort_key(*k).size();
+        }
+        return n;
+      });
+    run(results, "toNFD(keys)", *c, opt, filter, [&]() -> std::size_t {
+        std::size_t n = 0;
+        for(std::vector<std::string>::const_iterator k = keys.begin(); k != keys.end(); ++k) {
+          n += libuni::toNFD(*k).size();
+        }
+        return n;
+      });
+    run(results, "cache.toNFD(keys)", *c, opt, filter, [&]() -> std::size_t {
+        std::size_t n = 0;
+        for(std::vector<std::string>::const_iterator k = keys.begin(); k != keys.end(); ++k) {
+          n += cache.toNFD(*k).size();
+        }
+        return n;
+      });
+  }
+
+  print_table(std::cout, results);
+  if(json == "-") {
+    print_json(std::cout, results);
+  }
+  else if(not json.empty()) {
+    std::ofstream out(json.c_str());
+    print_json(out, results);
+    if(not out) {
+      std::cerr << "Failed to write `" << json << "'\n";
+      return 1;
+    }
+  }
+}
@@ -0,0 +1,174 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** corpus.c++ --- input texts for the throughput benchmarks
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ */
+#include "corpus.hpp"
+
+#include <libuni/utf8.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+
+namespace bench {
+namespace {
+  using libuni::codepoint_t;
+
+  struct xorshift {
+    std::uint32_t x;
+
+    xorshift() : x(2463534242u) { }
+
+    std::uint32_t
+    operator()(std::uint32_t n) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      return x % n;
+    }
+  };
+
+  void
+  put(std::string &s, codepoint_t cp) {
+    libuni::utf8::codepoint_to_utf8(cp, s);
+  }
+
+  /// Appends words of [min_len, max_len] letters from letter() separated by space (or nothing if 0).
+  template<typename Letter>
+  std::string
+  words(std::size_t size, std::size_t min_len, std::size_t max_len, codepoint_t space,
+        codepoint_t const *punct, std::size_t punct_count, Letter letter)
+  {
+    xorshift rnd;
+    std::string s;
+    s.reserve(size + 64);
+    while(s.size() < size) {
+      for(std::size_t n = min_len + rnd(max_len - min_len + 1); n > 0; --n) {
+        letter(s, rnd);
+      }
+      if(punct_count > 0 and rnd(8) == 0) {
+        put(s, punct[rnd(punct_count)]);
+      }
+      if(space) {
+        put(s, space);
+      }
+    }
+    return s;
+  }
+
+  codepoint_t const latin_punct[] = { ',', '.', '!', '?', ';' };
+  codepoint_t const cjk_punct[] = { 0x3001, 0x3002, 0xFF0C, 0x300C, 0x300D };
+  codepoint_t const arabic_punct[] = { 0x060C, 0x061B, 0x061F, '.' };
+
+  // Precomposed letters of Latin-1 and Latin Extended-A as used in French, German, Spanish, Polish, Czech, ...
+  codepoint_t const latin_accented[] = {
+    0xE0, 0xE1, 0xE2, 0xE4, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xED, 0xEE, 0xEF, 0xF1, 0xF3, 0xF4, 0xF6,
+    0xFA, 0xFB, 0xFC, 0xDF, 0xC9, 0xC4, 0xD6, 0xDC, 0x105, 0x107, 0x119, 0x142, 0x144, 0x15B, 0x17A,
+    0x17C, 0x10D, 0x11B, 0x159, 0x161, 0x17E, 0x16F
+  };
+}
+
+  std::vector<corpus>
+  synthetic_corpora(std::size_t size) {
+    std::vector<corpus> ret;
+    corpus c;
+
+    c.name = "ascii";
+    c.utf8 = words(size, 1, 10, ' ', latin_punct, sizeof(latin_punct)/sizeof(latin_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     s.push_back(rnd(12) == 0 ? 'A' + rnd(26) : 'a' + rnd(26));
+                   });
+    ret.push_back(c);
+
+    c.name = "latin";
+    c.utf8 = words(size, 1, 10, ' ', latin_punct, sizeof(latin_punct)/sizeof(latin_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     if(rnd(6) == 0) {
+                       put(s, latin_accented[rnd(sizeof(latin_accented)/sizeof(latin_accented[0]))]);
+                     }
+                     else {
+                       s.push_back(rnd(12) == 0 ? 'A' + rnd(26) : 'a' + rnd(26));
+                     }
+                   });
+    ret.push_back(c);
+
+    c.name = "cyrillic";
+    c.utf8 = words(size, 1, 10, ' ', latin_punct, sizeof(latin_punct)/sizeof(latin_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     put(s, rnd(12) == 0 ? 0x410 + rnd(32) : 0x430 + rnd(32));
+                   });
+    ret.push_back(c);
+
+    c.name = "cjk";
+    c.utf8 = words(size, 4, 24, 0, cjk_punct, sizeof(cjk_punct)/sizeof(cjk_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     put(s, 0x4E00 + rnd(0x5200));
+                   });
+    ret.push_back(c);
+
+    c.name = "hangul";
+    c.utf8 = words(size, 1, 5, ' ', latin_punct, sizeof(latin_punct)/sizeof(latin_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     put(s, 0xAC00 + rnd(11172));
+                   });
+    ret.push_back(c);
+
+    c.name = "arabic";
+    c.utf8 = words(size, 2, 8, ' ', arabic_punct, sizeof(arabic_punct)/sizeof(arabic_punct[0]),
+                   [](std::string &s, xorshift &rnd) {
+                     put(s, 0x627 + rnd(0x64A - 0x627 + 1));
+                     switch(rnd(4)) {
+                     case 0: // fatha/damma/kasra
+                       put(s, 0x64E + rnd(3));
+                       break;
+                     case 1: // shadda (ccc 33) before fatha (ccc 30) is not in canonical order
+                       put(s, 0x651);
+                       put(s, 0x64E);
+                       break;
+                     case 2: // tanwin + sukun
+                       put(s, 0x64B + rnd(3));
+                       put(s, 0x652);
+                       break;
+                     default:
+                       break;
+                     }
+                   });
+    ret.push_back(c);
+
+    c.name = "emoji";
+    c.utf8 = words(size, 1, 4, ' ', 0, 0,
+                   [](std::string &s, xorshift &rnd) {
+                     switch(rnd(4)) {
+                     case 0: // with skin tone modifier
+                       put(s, 0x1F466 + rnd(4));
+                       put(s, 0x1F3FB + rnd(5));
+                       break;
+                     case 1: // ZWJ sequence
+                       put(s, 0x1F468 + rnd(2));
+                       put(s, 0x200D);
+                       put(s, 0x1F466 + rnd(4));
+                       break;
+                     default:
+                       put(s, 0x1F600 + rnd(0x50));
+                     }
+                   });
+    ret.push_back(c);
+
+    return ret;
+  }
+
+  bool
+  load_corpus(std::string const &path, corpus &c) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if(not in) {
+      return false;
+    }
+    c.utf8.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    std::string::size_type const slash = path.rfind('/');
+    c.name = slash == std::string::npos ? path : path.substr(slash + 1);
+    return not in.bad();
+  }
+}
@@ -0,0 +1,44 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** corpus.hpp --- input texts for the throughput benchmarks
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The synthetic corpora are generated from a fixed seed, so every build measures the same input.
+ * They are meant to resemble the statistics of real text (word lengths, spaces, punctuation,
+ * share of non-ASCII), not its content:
+ *
+ * - ascii :: English-like words.
+ * - latin :: Western European text, mostly ASCII with precomposed accented letters (NFC).
+ * - cyrillic :: Russian-like words.
+ * - cjk :: Han ideographs with ideographic punctuation and no spaces.
+ * - hangul :: Precomposed Hangul syllables (decompose algorithmically).
+ * - arabic :: Arabic letters with one or two harakat each, partly in non-canonical order.
+ * - emoji :: Emoji with skin tone modifiers and ZWJ sequences (supplementary planes).
+ *
+ * Real text can be added with load_corpus (see bench_throughput --help).
+ */
+#ifndef LIBUNI_BENCH_CORPUS_HPP
+#define LIBUNI_BENCH_CORPUS_HPP
+
+#include <string>
+#include <vector>
+
+namespace bench {
+  struct corpus {
+    std::string name;
+    std::string utf8;
+  };
+
+  /// Returns all synthetic corpora, each about size bytes of UTF-8.
+  std::vector<corpus>
+  synthetic_corpora(std::size_t size);
+
+  /// Reads the file at path into c (named after the file).  Returns false on error.
+  bool
+  load_corpus(std::string const &path, corpus &c);
+}
+
+#endif
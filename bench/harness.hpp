@@ -0,0 +1,127 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** harness.hpp --- minimal benchmark harness
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Runs a function a few times to warm up caches and branch predictors and then measures every
+ * repetition separately.  The median is the number to compare, p99 (nearest rank) shows the noise.
+ *
+ * Cycles are read with rdtsc on x86.  These are reference cycles (constant TSC), not core cycles,
+ * so they only compare well on the same machine.  Elsewhere cycles_per_byte is reported as null.
+ */
+#ifndef LIBUNI_BENCH_HARNESS_HPP
+#define LIBUNI_BENCH_HARNESS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LIBUNI_BENCH_HAVE_TSC 1
+#endif
+
+namespace bench {
+  struct options {
+    std::size_t warmup;
+    std::size_t repetitions;
+
+    options() : warmup(3), repetitions(21) { }
+  };
+
+  struct result {
+    std::string benchmark;
+    std::string corpus;
+    std::size_t bytes;
+    std::size_t repetitions;
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double cycles_per_byte; // < 0 if not available
+
+    double
+    mb_per_s() const {
+      return bytes / median_ns * 1e3;
+    }
+  };
+
+  extern volatile std::size_t sink; // keeps results from being optimized away
+
+  inline
+  std::uint64_t
+  cycles() {
+#ifdef LIBUNI_BENCH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+  }
+
+  /// Returns the value at percentile p (0..100) of the sorted samples (nearest rank).
+  inline
+  double
+  percentile(std::vector<double> const &sorted, double p) {
+    std::size_t rank = std::size_t(p / 100.0 * sorted.size() + 0.5);
+    rank = std::max<std::size_t>(rank, 1);
+    return sorted[std::min(rank, sorted.size()) - 1];
+  }
+
+  /** Measures f(), which processes bytes bytes of input and returns something to feed sink.
+   * Usage:
+   *   result r = measure("toNFD", "latin", s.size(), [&]() { return toNFD(s).size(); });
+   */
+  template<typename F>
+  result
+  measure(std::string const &benchmark, std::string const &corpus, std::size_t bytes, F f,
+          options const &opt = options())
+  {
+    for(std::size_t i = 0; i < opt.warmup; ++i) {
+      sink = f();
+    }
+
+    std::vector<double> ns;
+    std::vector<double> cpb;
+    for(std::size_t i = 0; i < opt.repetitions; ++i) {
+      auto const start = std::chrono::steady_clock::now();
+      std::uint64_t const c0 = cycles();
+      sink = f();
+      std::uint64_t const c1 = cycles();
+      auto const stop = std::chrono::steady_clock::now();
+      ns.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+      cpb.push_back(double(c1 - c0) / bytes);
+    }
+    std::sort(ns.begin(), ns.end());
+    std::sort(cpb.begin(), cpb.end());
+
+    result r;
+    r.benchmark = benchmark;
+    r.corpus = corpus;
+    r.bytes = bytes;
+    r.repetitions = opt.repetitions;
+    r.median_ns = percentile(ns, 50);
+    r.p99_ns = percentile(ns, 99);
+    r.min_ns = ns.front();
+#ifdef LIBUNI_BENCH_HAVE_TSC
+    r.cycles_per_byte = percentile(cpb, 50);
+#else
+    r.cycles_per_byte = -1;
+#endif
+    return r;
+  }
+
+  /// Writes the results as a JSON document (one object per line in "results" to keep diffs readable).
+  void
+  print_json(std::ostream &out, std::vector<result> const &results);
+
+  /// Writes a human readable table.
+  void
+  print_table(std::ostream &out, std::vector<result> const &results);
+}
+
+#endif
@@ -0,0 +1,343 @@
+/** cache.hpp --- a concurrent cache of normalized and case mapped strings
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * normalization_cache remembers the results of toNFD, toNFKD, toNFC, toNFKC, toLowercase and
+ * toUppercase for UTF-8 strings.  It helps if the same short strings (tags, names, keys) are
+ * normalized over and over again.  It can be used by any number of threads at the same time.
+ *
+ * - A string the quick check proves unchanged (e.g., is_nfc for toNFC) is returned without looking
+ *   at the cache.  The quick check is a single pass and is cheaper than hashing and probing.
+ *   Only strings that really change are cached.
+ * - Key and result have to fit into a slot together (max_size bytes).  Longer strings are not
+ *   cached because for them the hash and the copies cost about as much as the mapping.
+ * - The cache is split into shards by the hash of the string.  A shard is a set associative table
+ *   of fixed size slots, so the memory is bounded and allocated once.  When a set is full, a slot
+ *   is evicted with the CLOCK algorithm: a hit sets the referenced bit of the slot and the hand
+ *   passes over referenced slots once (clearing the bit) before it evicts one.
+ * - Lookups take no lock.  Every slot has a version (a seqlock) which is odd while the slot is
+ *   written, and a reader retries if the version changed while it copied the slot.  Inserts lock
+ *   the shard.
+ * - Shards, slots and the tags of a set start at a cache line and the counters are striped over
+ *   cache_stripes lines (one per thread, round robin), so a lookup writes no line that other
+ *   threads read or write.
+ *
+ * Usage:
+ *   libuni::normalization_cache cache(1 << 16); // slots
+ *   std::string const tag = cache.toNFC(raw_tag);
+ *   libuni::cache_stats const s = cache.stats();
+ */
+#ifndef LIBUNI_CACHE_HPP
+#define LIBUNI_CACHE_HPP
+
+#include "config.hpp"
+#include "utf8.hpp"
+#include "normalization.hpp"
+#include "case.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+
+namespace libuni {
+  /// What normalization_cache computes (part of the key).
+  enum cache_operation {
+    cache_nfd,
+    cache_nfkd,
+    cache_nfc,
+    cache_nfkc,
+    cache_lowercase,
+    cache_uppercase,
+    cache_operations
+  };
+
+  struct cache_stats {
+    std::uint64_t hits;
+    std::uint64_t misses;     // computed and inserted
+    std::uint64_t bypasses;   // the quick check proved the string unchanged
+    std::uint64_t uncached;   // too long to be cached
+    std::uint64_t evictions;
+  };
+
+  namespace helper {
+    std::size_t const cache_line = 64;
+    std::size_t const cache_slot_words = 21;
+    std::size_t const cache_ways = 4; // slots per set
+    std::size_t const cache_stripes = 64;
+
+    /** An array of value-initialized elements starting at a cache line.  Plain new only respects
+     * alignas beyond alignof(std::max_align_t) since C++17.
+     */
+    template<typename T>
+    class cache_aligned_array {
+      void *raw;
+      T *elements;
+      std::size_t n;
+
+      cache_aligned_array(cache_aligned_array const&) = delete;
+      cache_aligned_array &operator=(cache_aligned_array const&) = delete;
+
+      void
+      destroy() {
+        for(std::size_t i = 0; i < n; ++i) {
+          elements[i].~T();
+        }
+        ::operator delete(raw);
+      }
+
+    public:
+      cache_aligned_array()
+        : raw(0x0), elements(0x0), n(0)
+      { }
+
+      ~cache_aligned_array() {
+        destroy();
+      }
+
+      void
+      reset(std::size_t size) {
+        destroy();
+        raw = 0x0; // if new throws
+        n = 0;
+        raw = ::operator new(size * sizeof(T) + cache_line - 1);
+        elements = reinterpret_cast<T*>((reinterpret_cast<std::uintptr_t>(raw) + cache_line - 1) & ~(cache_line - 1));
+        for(; n < size; ++n) {
+          new(elements + n) T();
+        }
+      }
+
+      T &
+      operator[](std::size_t i) {
+        return elements[i];
+      }
+
+      T const &
+      operator[](std::size_t i) const {
+        return elements[i];
+      }
+    };
+
+    /// Key and value are stored one after the other in data.  A slot is three cache lines.
+    struct alignas(cache_line) cache_slot {
+      std::atomic<std::uint64_t> version; // odd while the slot is written
+      std::atomic<std::uint64_t> tag;     // hash and operation of the key, 0 if the slot is empty
+      std::atomic<std::uint32_t> sizes;   // size of the key << 8 | size of the value
+      std::atomic<bool> referenced;       // CLOCK
+      std::atomic<std::uint64_t> data[cache_slot_words];
+    };
+
+    static_assert(sizeof(cache_slot) == 3 * cache_line, "cache_slot_words has to fill the lines of a slot");
+
+    struct cache_shard {
+      cache_aligned_array<cache_slot> slots; // sets * cache_ways
+      cache_aligned_array<std::atomic<std::uint64_t>> tags; // copies of the tags of slots: a probe reads one line
+      std::unique_ptr<std::uint8_t[]> hand; // CLOCK hand of every set (only used by inserts)
+      std::size_t set_mask;
+      alignas(cache_line) std::mutex mutex; // held by inserts, not on the line the lookups read
+    };
+
+    static_assert(cache_ways * sizeof(std::uint64_t) <= cache_line and cache_line % (cache_ways * sizeof(std::uint64_t)) == 0,
+                  "the tags of a set have to be in one cache line");
+
+    /// The counters of the threads using one stripe.
+    struct alignas(cache_line) cache_counters {
+      std::atomic<std::uint64_t> hits;
+      std::atomic<std::uint64_t> misses;
+      std::atomic<std::uint64_t> bypasses;
+      std::atomic<std::uint64_t> uncached;
+      std::atomic<std::uint64_t> evictions;
+    };
+
+    /// Returns the stripe of the counters of the calling thread (assigned round robin).
+    LIBUNI_LINKAGE
+    std::size_t
+    cache_stripe();
+
+    /// Returns the tag of [key, key + n) for op.  Never 0.
+    LIBUNI_LINKAGE
+    std::uint64_t
+    cache_tag(char const *key, std::size_t n, cache_operation op);
+
+    /// Looks up the key with tag in its set.  Lock-free.  Returns true and sets value on a hit.
+    LIBUNI_LINKAGE
+    bool
+    cache_find(cache_shard &shard, std::uint64_t tag, char const *key, std::size_t n, std::string &value);
+
+    /// Stores key and value (which have to fit in a slot).  Locks the shard.  Returns true if a slot was evicted.
+    LIBUNI_LINKAGE
+    bool
+    cache_insert(cache_shard &shard, std::uint64_t tag, char const *key, std::size_t n,
+                 std::string const &value);
+
+    /// Empties every slot.  Locks the shard.
+    LIBUNI_LINKAGE
+    void
+    cache_clear(cache_shard &shard);
+
+    /// Returns true if in does not change with op (the quick check of op).
+    inline
+    bool
+    cache_unchanged(std::string const &in, cache_operation op) {
+      typedef utf_trait<std::string> UTFTraits;
+      std::string::const_iterator i = in.begin();
+      switch(op) {
+      case cache_nfd:
+        return is_nfd(in);
+      case cache_nfkd:
+        return is_nfkd(in);
+      case cache_nfc:
+        return is_nfc(in);
+      case cache_nfkc:
+        return is_nfkc(in);
+      case cache_lowercase:
+        return not find_first_change<UTFTraits>(i, in.end(), lowercase_mapping) and i == in.end();
+      case cache_uppercase:
+        return not find_first_change<UTFTraits>(i, in.end(), uppercase_mapping) and i == in.end();
+      default:
+        return true;
+      }
+    }
+
+    /// Computes op for in (which cache_unchanged found to change) without the cache.
+    inline
+    std::string
+    cache_compute(std::string const &in, cache_operation op) {
+      typedef utf_trait<std::string> UTFTraits;
+      codepoint_string_t tmp;
+      switch(op) { // cache_unchanged was false: skip the quick check of toNFD etc.
+      case cache_nfd:
+        return normalize<NFD, std::string, UTFTraits>(in, tmp);
+      case cache_nfkd:
+        return normalize<NFKD, std::string, UTFTraits>(in, tmp);
+      case cache_nfc:
+        return normalize<NFC, std::string, UTFTraits>(in, tmp);
+      case cache_nfkc:
+        return normalize<NFKC, std::string, UTFTraits>(in, tmp);
+      case cache_lowercase:
+        return toLowercase(in);
+      case cache_uppercase:
+        return toUppercase(in);
+      default:
+        return in;
+      }
+    }
+  }
+
+  class normalization_cache {
+    helper::cache_aligned_array<helper::cache_shard> shards;
+    std::size_t shard_mask;
+    helper::cache_aligned_array<helper::cache_counters> counters; // cache_stripes
+
+    static
+    std::size_t
+    round_up_pow2(std::size_t n) {
+      std::size_t r = 1;
+      while(r < n) {
+        r <<= 1;
+      }
+      return r;
+    }
+
+    helper::cache_shard &
+    shard(std::uint64_t tag) {
+      return shards[(tag >> 56) & shard_mask];
+    }
+
+  public:
+    /// Longest key and value together (in bytes) that is cached.
+    static std::size_t const max_size = helper::cache_slot_words * 8;
+
+    /** Creates a cache with room for about capacity strings (rounded up to a power of two) split
+     * into shard_count shards (rounded up to a power of two, at most 256).
+     */
+    explicit normalization_cache(std::size_t capacity = 1 << 16, std::size_t shard_count = 16)
+      : shard_mask(round_up_pow2(shard_count < 256 ? shard_count : 256) - 1)
+    {
+      shards.reset(shard_mask + 1);
+      counters.reset(helper::cache_stripes); // zero
+      std::size_t const sets = round_up_pow2((capacity + helper::cache_ways - 1) / helper::cache_ways / (shard_mask + 1));
+      for(std::size_t i = 0; i <= shard_mask; ++i) {
+        helper::cache_shard &s = shards[i];
+        s.slots.reset(sets * helper::cache_ways); // zero: empty
+        s.tags.reset(sets * helper::cache_ways);
+        s.hand.reset(new std::uint8_t[sets]());
+        s.set_mask = sets - 1;
+      }
+    }
+
+    /// Returns the result of op for the UTF-8 string in (e.g., toNFC(in) for cache_nfc).
+    std::string
+    get(std::string const &in, cache_operation op) {
+      helper::cache_counters &c = counters[helper::cache_stripe()];
+      if(helper::cache_unchanged(in, op)) { // never inserted
+        c.bypasses.fetch_add(1, std::memory_order_relaxed);
+        return in;
+      }
+      else if(in.size() > max_size) {
+        c.uncached.fetch_add(1, std::memory_order_relaxed);
+        return helper::cache_compute(in, op);
+      }
+      std::uint64_t const tag = helper::cache_tag(in.data(), in.size(), op);
+      helper::cache_shard &s = shard(tag);
+      std::string ret;
+      if(helper::cache_find(s, tag, in.data(), in.size(), ret)) {
+        c.hits.fetch_add(1, std::memory_order_relaxed);
+        return ret;
+      }
+      ret = helper::cache_compute(in, op);
+      if(in.size() + ret.size() > max_size) {
+        c.uncached.fetch_add(1, std::memory_order_relaxed);
+      }
+      else {
+        c.misses.fetch_add(1, std::memory_order_relaxed);
+        if(helper::cache_insert(s, tag, in.data(), in.size(), ret)) {
+          c.evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      return ret;
+    }
+
+    std::string toNFD(std::string const &in) { return get(in, cache_nfd); }
+    std::string toNFKD(std::string const &in) { return get(in, cache_nfkd); }
+    std::string toNFC(std::string const &in) { return get(in, cache_nfc); }
+    std::string toNFKC(std::string const &in) { return get(in, cache_nfkc); }
+    std::string toLowercase(std::string const &in) { return get(in, cache_lowercase); }
+    std::string toUppercase(std::string const &in) { return get(in, cache_uppercase); }
+
+    /// Removes all strings (but keeps the counters).
+    void
+    clear() {
+      for(std::size_t i = 0; i <= shard_mask; ++i) {
+        helper::cache_clear(shards[i]);
+      }
+    }
+
+    /// The counters summed over the stripes.
+    cache_stats
+    stats() const {
+      cache_stats ret = { 0, 0, 0, 0, 0 };
+      for(std::size_t i = 0; i < helper::cache_stripes; ++i) {
+        helper::cache_counters const &c = counters[i];
+        ret.hits += c.hits.load(std::memory_order_relaxed);
+        ret.misses += c.misses.load(std::memory_order_relaxed);
+        ret.bypasses += c.bypasses.load(std::memory_order_relaxed);
+        ret.uncached += c.uncached.load(std::memory_order_relaxed);
+        ret.evictions += c.evictions.load(std::memory_order_relaxed);
+      }
+      return ret;
+    }
+  };
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/cache.c++"
+#endif
+
+#endif
@@ -11,28 +11,90 @@
 #ifndef LIBUNI_CASE_HPP
 #define LIBUNI_CASE_HPP
 
+#include "config.hpp"
+#include "stats.hpp"
 #include "codepoint.hpp"
 #include "codepoint_string.hpp"
 #include "utf.hpp"
+#include "utf8.hpp"
+
+#include <string>
+#include <utility>
 
 namespace libuni {
-  extern codepoint_t uppercase_mapping(codepoint_t cp);
-  extern codepoint_t lowercase_mapping(codepoint_t cp);
-  extern codepoint_t titlecase_mapping(codepoint_t cp);
+  LIBUNI_LINKAGE codepoint_t uppercase_mapping(codepoint_t cp);
+  LIBUNI_LINKAGE codepoint_t lowercase_mapping(codepoint_t cp);
+  LIBUNI_LINKAGE codepoint_t titlecase_mapping(codepoint_t cp);
   extern codepoint_t code_folding(codepoint_t cp);
 
   namespace helper {
+    /** Advances i to the first code point map changes.  Returns false if there is none, i is then
+     * end or the first ill-formed sequence.
+     */
+    template<typename UTFTraits, typename I, typename CaseMapping>
+    bool
+    find_first_change(I &i, I end, CaseMapping map) {
+      codepoint_t cp;
+      for(I next = i; UTFTraits::next_codepoint(next, end, cp) == utf_ok; i = next) {
+        if(map(cp) != cp) {
+          return true;
+        }
+        LIBUNI_STATS_COUNT(case_unchanged);
+      }
+      return false;
+    }
+
+    /// Appends the mapping of [i, end) to ret.
+    template<typename String, typename UTFTraits, typename I, typename CaseMapping>
+    void
+    append_mapped(String &ret, I i, I end, CaseMapping map) {
+      codepoint_t cp;
+      while(UTFTraits::next_codepoint(i, end, cp) == utf_ok) {
+        codepoint_t const mapped = map(cp);
+        if(mapped != cp) {
+          LIBUNI_STATS_COUNT(case_changed);
+        }
+        else {
+          LIBUNI_STATS_COUNT(case_unchanged);
+        }
+        UTFTraits::append(ret, mapped);
+      }
+    }
+
+    /** If in does not change, the result is a copy of in: no temporary is built and the copy is the
+     * only allocation (toXcase_move avoids that one as well).  The result uses the allocator of in.
+     */
     template<typename String, typename UTFTraits = utf_trait<String>, typename CaseMapping>
     String
     toXcase(String const &in, CaseMapping map) {
       typedef typename String::const_iterator iterator_t;
       iterator_t const end = in.end();
       iterator_t i = in.begin();
-      codepoint_t cp;
-      String ret;
-      while(UTFTraits::next_codepoint(i, end, cp) == utf_ok) {
-        UTFTraits::append(ret, map(cp));
+      if(not find_first_change<UTFTraits>(i, end, map)) {
+        return i == end ? in : String(in.begin(), i, in.get_allocator()); // an ill-formed sequence ends the output
+      }
+      String ret(in.get_allocator());
+      ret.reserve(in.size());
+      ret.assign(in.begin(), i);
+      append_mapped<String, UTFTraits>(ret, i, end, map);
+      return ret;
+    }
+
+    /// Same as toXcase but in is moved to the result if it does not change.
+    template<typename String, typename UTFTraits = utf_trait<String>, typename CaseMapping>
+    String
+    toXcase_move(String &in, CaseMapping map) {
+      typedef typename String::const_iterator iterator_t;
+      iterator_t const end = in.end();
+      iterator_t i = in.begin();
+      if(not find_first_change<UTFTraits>(i, end, map)) {
+        in.erase(i, end);
+        return std::move(in);
       }
+      String ret(in.get_allocator());
+      ret.reserve(in.size());
+      ret.assign(iterator_t(in.begin()), i);
+      append_mapped<String, UTFTraits>(ret, i, end, map);
       return ret;
     }
   }
@@ -40,12 +102,76 @@ namespace libuni {
   template<typename String, typename UTFTraits = utf_trait<String>>
   String
   toUppercase(String const &in) {
-    return helper::toXcase(in, uppercase_mapping);
+    return helper::toXcase<String, UTFTraits>(in, uppercase_mapping);
+  }
+
+  /// Moves in to the result if nothing changes.
+  template<typename String, typename UTFTraits = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toUppercase(String &&in) {
+    return helper::toXcase_move<String, UTFTraits>(in, uppercase_mapping);
   }
 
   template<typename String, typename UTFTraits = utf_trait<String>>
   String toLowercase(String const &in) {
-    return helper::toXcase(in, lowercase_mapping);
+    return helper::toXcase<String, UTFTraits>(in, lowercase_mapping);
+  }
+
+  template<typename String, typename UTFTraits = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toLowercase(String &&in) {
+    return helper::toXcase_move<String, UTFTraits>(in, lowercase_mapping);
+  }
+
+  namespace helper {
+    /// See to_lower_inplace(char8_t*, std::size_t).
+    LIBUNI_LINKAGE
+    std::size_t
+    xcase_inplace(char8_t *p, std::size_t n, bool upper);
+  }
+
+  /** Maps the UTF-8 in [p, p + n) to lowercase in place as long as the mapping does not change the
+   * length of the encoding (ASCII runs are mapped with the SIMD kernels, see simd.hpp).  Returns the
+   * offset of the first code point whose mapping is longer or shorter (or of the first ill-formed
+   * sequence) or n if everything was mapped.
+   */
+  inline
+  std::size_t
+  to_lower_inplace(char8_t *p, std::size_t n) {
+    return helper::xcase_inplace(p, n, false);
+  }
+
+  inline
+  std::size_t
+  to_upper_inplace(char8_t *p, std::size_t n) {
+    return helper::xcase_inplace(p, n, true);
+  }
+
+  namespace helper {
+    template<typename CaseMapping>
+    void
+    xcase_inplace(std::string &s, bool upper, CaseMapping map) {
+      typedef utf_trait<std::string> UTFTraits;
+      std::size_t const done = s.empty() ? 0 : xcase_inplace(reinterpret_cast<char8_t*>(&s[0]), s.size(), upper);
+      if(done != s.size()) { // the length changes: map the rest out of place once
+        std::string rest(s.get_allocator());
+        append_mapped<std::string, UTFTraits>(rest, s.cbegin() + done, s.cend(), map);
+        s.replace(done, std::string::npos, rest);
+      }
+    }
+  }
+
+  /// Same as s = toLowercase(s) but maps s in place if possible.
+  inline
+  void
+  to_lower_inplace(std::string &s) {
+    helper::xcase_inplace(s, false, lowercase_mapping);
+  }
+
+  inline
+  void
+  to_upper_inplace(std::string &s) {
+    helper::xcase_inplace(s, true, uppercase_mapping);
   }
 
   template<typename String, typename UTFTraits = utf_trait<String>>
@@ -57,11 +183,11 @@ namespace libuni {
   String toNFKC_Casefold(String const &in);
 
   namespace helper {
-    extern
+    LIBUNI_LINKAGE
     bool
     is_uppercase(codepoint_t cp);
 
-    extern
+    LIBUNI_LINKAGE
     bool
     is_lowercase(codepoint_t cp);
 
@@ -98,4 +224,8 @@ namespace libuni {
   bool isCased(String const &in);
 }
 
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/case.c++"
+#endif
+
 #endif
@@ -0,0 +1,147 @@
+/** collation.hpp --- an implementation of the Unicode Collation Algorithm (UTS#10)
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * An implementation of the Unicode Collation Algorithm (UTS#10) with the Default Unicode Collation
+ * Element Table (DUCET, allkeys.txt).  Tailorings are not supported.
+ *
+ * sort_key() turns a string into a sort key.  Compare sort keys with memcmp over the shorter length
+ * and the length as tie breaker (std::string's operator< does that), which is the same as comparing
+ * the strings with the UCA.  Key format: the levels in order, separated by a zero weight of the width
+ * of the preceding level.  Primary, secondary and quaternary weights are 16 bit big-endian, tertiary
+ * weights 8 bit.  Completely ignorable weights are omitted.
+ *
+ * Strings with Latin-1 code points only are not normalized: the DUCET contains the precomposed
+ * letters and Latin-1 has no combining marks.  Everything else is decomposed (NFD) first.
+ *
+ * Usage:
+ *   unsigned char key[64];
+ *   std::size_t const n = libuni::sort_key(str, key, sizeof(key));
+ *   if(n > sizeof(key)) {
+ *     // key is truncated (but still a prefix of the complete key), retry with n bytes
+ *   }
+ */
+#ifndef LIBUNI_COLLATION_HPP
+#define LIBUNI_COLLATION_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+#include "codepoint_string.hpp"
+#include "utf.hpp"
+#include "utf32.hpp"
+#include "normalization.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace libuni {
+  namespace collation {
+    enum strength {
+      primary = 1,  // base letters
+      secondary,    // accents
+      tertiary,     // case and variants
+      quaternary    // variable elements (punctuation, spaces, ...) with shifted
+    };
+
+    enum variable_weighting {
+      non_ignorable, // variable elements are compared like letters
+      shifted        // variable elements are ignored on levels 1-3 and compared on level 4
+    };
+
+    struct options {
+      strength level;
+      variable_weighting variable;
+
+      options(strength level = tertiary, variable_weighting variable = non_ignorable)
+        : level(level), variable(variable)
+      { }
+    };
+
+    /// Returns the version of the DUCET (empty if libuni was built without allkeys.txt).
+    LIBUNI_LINKAGE
+    char const*
+    version();
+  }
+
+  namespace helper {
+    /// Returns the scratch buffer sort_key decodes into (one per thread).
+    LIBUNI_LINKAGE
+    codepoint_string_t&
+    sort_key_buffer();
+
+    /** Writes the sort key of cps (NFD or Latin-1) to out (see sort_key).  Code points matched by
+     * discontiguous contractions are removed from cps.
+     */
+    LIBUNI_LINKAGE
+    std::size_t
+    sort_key(codepoint_string_t &cps, unsigned char *out, std::size_t size, collation::options const &opt);
+
+    /** Returns the sort key of cps (see above) and sets length.  The key is in a buffer of the calling
+     * thread, which is valid until the next call.
+     */
+    LIBUNI_LINKAGE
+    unsigned char const*
+    sort_key(codepoint_string_t &cps, std::size_t &length, collation::options const &opt);
+
+    /// Decodes in into sort_key_buffer(), decomposed (NFD) unless it is Latin-1.
+    template<typename String, typename UTFTrait>
+    codepoint_string_t&
+    sort_key_input(String const &in) {
+      codepoint_string_t &cps = sort_key_buffer();
+      cps.resize(in.size()); // there are at most as many code points as code units
+      typedef typename String::const_iterator iterator_t;
+      iterator_t const end = in.end();
+      iterator_t i = in.begin();
+      codepoint_t cp;
+      std::size_t n = 0;
+      while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+        if(cp >= 0x100) { // start over with the decomposition
+          decompose_into<String, UTFTrait, false>(in, cps);
+          return cps;
+        }
+        cps[n++] = cp;
+      }
+      cps.resize(n);
+      return cps;
+    }
+  }
+
+  /** Writes the sort key of in to out, at most size bytes.  Returns the length of the complete key,
+   * if this is larger than size the key is truncated.
+   */
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  std::size_t
+  sort_key(String const &in, unsigned char *out, std::size_t size,
+           collation::options const &opt = collation::options())
+  {
+    return helper::sort_key(helper::sort_key_input<String, UTFTrait>(in), out, size, opt);
+  }
+
+  /// Returns the sort key of in, allocated with alloc.
+  template<typename String, typename UTFTrait = utf_trait<String>, typename Alloc = std::allocator<char>>
+  std::basic_string<char, std::char_traits<char>, Alloc>
+  sort_key(String const &in, collation::options const &opt = collation::options(), Alloc const &alloc = Alloc()) {
+    std::size_t n;
+    unsigned char const *const key = helper::sort_key(helper::sort_key_input<String, UTFTrait>(in), n, opt);
+    return std::basic_string<char, std::char_traits<char>, Alloc>(reinterpret_cast<char const*>(key), n, alloc);
+  }
+
+  /// Compares lhs and rhs with the UCA.  Returns <0, 0 or >0 like strcmp.
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  int
+  collate(String const &lhs, String const &rhs, collation::options const &opt = collation::options()) {
+    std::string const key = sort_key<String, UTFTrait>(lhs, opt);
+    std::size_t n;
+    unsigned char const *const other = helper::sort_key(helper::sort_key_input<String, UTFTrait>(rhs), n, opt);
+    return key.compare(0, key.size(), reinterpret_cast<char const*>(other), n);
+  }
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/collation.c++"
+#endif
+
+#endif
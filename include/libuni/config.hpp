@@ -0,0 +1,22 @@
+/** config.hpp --- build configuration of libuni
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Define LIBUNI_HEADER_ONLY before including any libuni header to use libuni without linking
+ * against the library.  The table lookups (e.g., helper::get_quick_check) are then inline functions
+ * operating on constexpr tables and can be inlined into the loops calling them.  This requires the
+ * generated tables in src/generated (i.e., a configured and built source tree).
+ */
+#ifndef LIBUNI_CONFIG_HPP
+#define LIBUNI_CONFIG_HPP
+
+#ifdef LIBUNI_HEADER_ONLY
+#define LIBUNI_LINKAGE inline
+#else
+#define LIBUNI_LINKAGE extern
+#endif
+
+#endif
@@ -0,0 +1,47 @@
+/** data.hpp --- load the Unicode tables from a data file at runtime
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The generator writes the tables compiled into the library also to a binary file (libuni.dat, see
+ * src/data_format.hpp).  load() maps such a file read-only (the pages are shared between processes)
+ * and uses it in place, nothing is parsed or copied.  The index arrays and the offsets into other
+ * arrays are checked once (a single pass), so a corrupt file is rejected instead of causing reads
+ * outside of the mapping.  This way the Unicode data can be updated without
+ * rebuilding programs, as long as the file was generated with the same table layouts (TABLE_LAYOUT)
+ * and the library was not built with LIBUNI_HEADER_ONLY.
+ *
+ * If the environment variable LIBUNI_DATA is set when the library is loaded, that file is loaded.
+ *
+ * load() and use_compiled_in() are not thread-safe: call them during initialization before any
+ * other thread uses libuni.
+ */
+#ifndef LIBUNI_DATA_HPP
+#define LIBUNI_DATA_HPP
+
+#include <string>
+
+namespace libuni {
+  namespace data {
+    /** Maps the data file at path and uses it for all lookups.  Returns false and keeps the current
+     * tables if the file can't be mapped or doesn't match this build (error receives the reason).
+     */
+    extern
+    bool
+    load(char const *path, std::string *error = 0);
+
+    /// Switches back to the tables compiled into the library.
+    extern
+    void
+    use_compiled_in();
+
+    /// Returns the Unicode version of the tables in use.
+    extern
+    char const*
+    unicode_version();
+  }
+}
+
+#endif
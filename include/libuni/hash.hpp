@@ -0,0 +1,209 @@
+/** hash.hpp --- hashing and comparing strings up to canonical equivalence
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * nfd_hash(s) is a hash of the UTF-8 encoding of toNFD(s) and nfc_hash(s) of toNFC(s), so
+ * canonically equivalent strings (e.g., "é" and "é") have the same hash.  Neither builds the
+ * normalized string: if the quick check (is_nfd/is_nfc) proves the input is normalized, UTF-8 input
+ * is hashed as is, otherwise the normalized code points are hashed as they are produced (see
+ * helper::normalizing_reader), which only buffers a few segments.  The hash does not depend on the
+ * encoding of the input.  It may change with the libuni version, so don't store it.
+ *
+ * canonically_equal(a, b) tells whether a and b are canonically equivalent.
+ *
+ * Usage (a hash join):
+ *   struct nfc_hasher {
+ *     std::size_t operator()(std::string const &s) const { return libuni::nfc_hash(s); }
+ *   };
+ *   struct nfc_equal {
+ *     bool operator()(std::string const &a, std::string const &b) const {
+ *       return libuni::canonically_equal(a, b);
+ *     }
+ *   };
+ *   std::unordered_map<std::string, row, nfc_hasher, nfc_equal> table;
+ */
+#ifndef LIBUNI_HASH_HPP
+#define LIBUNI_HASH_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+#include "utf.hpp"
+#include "utf8.hpp"
+#include "normalization.hpp"
+#include "simd.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace libuni {
+  namespace helper {
+    /// State of the incremental hash of a byte stream.
+    struct hash_state {
+      std::uint64_t h;
+      std::uint64_t tail;      // bytes not yet mixed in (little-endian)
+      std::size_t tail_size;
+      std::uint64_t length;
+
+      hash_state()
+        : h(0x243F6A8885A308D3ull), tail(0), tail_size(0), length(0)
+      { }
+    };
+
+    inline
+    std::uint64_t
+    rotl(std::uint64_t x, unsigned r) {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    /// Mixes the 8 bytes w into h (the body of MurmurHash3).
+    inline
+    std::uint64_t
+    hash_mix(std::uint64_t h, std::uint64_t w) {
+      w *= 0x87C37B91114253D5ull;
+      w = rotl(w, 31);
+      w *= 0x4CF5AD432745937Full;
+      h ^= w;
+      return rotl(h, 27) * 5 + 0x52DCE729;
+    }
+
+    /// Feeds [p, p + n) to the hash.
+    LIBUNI_LINKAGE
+    void
+    hash_bytes(hash_state &s, char8_t const *p, std::size_t n);
+
+    /// Feeds the UTF-8 encoding of cp to the hash.  Same as hash_bytes with the encoded bytes.
+    inline
+    void
+    hash_codepoint(hash_state &s, codepoint_t cp) {
+      std::uint64_t bytes; // in little-endian order
+      std::size_t n;
+      if(cp <= 0x7F) {
+        bytes = cp;
+        n = 1;
+      }
+      else if(cp <= 0x7FF) {
+        bytes = ((cp >> 6) | 0xC0) | ((cp & 0x3F) | 0x80) << 8;
+        n = 2;
+      }
+      else if(cp <= 0xFFFF) {
+        bytes = ((cp >> 12) | 0xE0) | (((cp >> 6) & 0x3F) | 0x80) << 8 | ((cp & 0x3F) | 0x80) << 16;
+        n = 3;
+      }
+      else {
+        bytes = ((cp >> 18) | 0xF0) | (((cp >> 12) & 0x3F) | 0x80) << 8 | (((cp >> 6) & 0x3F) | 0x80) << 16 |
+          std::uint64_t((cp & 0x3F) | 0x80) << 24;
+        n = 4;
+      }
+      s.length += n;
+      std::size_t const shift = 8 * s.tail_size;
+      s.tail |= bytes << shift;
+      s.tail_size += n;
+      if(s.tail_size >= 8) { // shift is at least 32 (n <= 4)
+        s.h = hash_mix(s.h, s.tail);
+        s.tail_size -= 8;
+        s.tail = s.tail_size == 0 ? 0 : bytes >> (64 - shift);
+      }
+    }
+
+    LIBUNI_LINKAGE
+    std::size_t
+    hash_final(hash_state const &s);
+
+    /// Tells whether the code units of String can be hashed as they are (UTF-8 in contiguous memory).
+    template<typename String, typename UTFTrait>
+    struct hash_as_bytes : std::integral_constant<bool,
+      is_utf8<UTFTrait>::value and
+      simd::helper::contiguous_bytes<typename String::const_iterator>::value>
+    { };
+
+    template<typename String, typename UTFTrait>
+    void
+    hash_normalized(hash_state &s, String const &in, std::true_type) {
+      if(not in.empty()) {
+        hash_bytes(s, simd::helper::byte_pointer(in.begin()), in.size());
+      }
+    }
+
+    template<typename String, typename UTFTrait>
+    void
+    hash_normalized(hash_state &s, String const &in, std::false_type) {
+      typedef typename String::const_iterator iterator_t;
+      iterator_t const end = in.end();
+      iterator_t i = in.begin();
+      codepoint_t cp;
+      while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+        hash_codepoint(s, cp);
+      }
+    }
+
+    template<typename String, typename UTFTrait, bool Compose>
+    std::size_t
+    normalization_hash(String const &in, bool normalized) {
+      hash_state s;
+      if(normalized) {
+        hash_normalized<String, UTFTrait>(s, in, hash_as_bytes<String, UTFTrait>());
+      }
+      else {
+        typedef decoder<typename String::const_iterator, UTFTrait> decoder_t;
+        normalizing_reader<decoder_t, false, Compose> r(decoder_t(in.begin(), in.end()));
+        for(codepoint_t cp; r.next(cp); ) {
+          hash_codepoint(s, cp);
+        }
+      }
+      return hash_final(s);
+    }
+  }
+
+  /// Returns the hash of the NFD of in.
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  std::size_t
+  nfd_hash(String const &in) {
+    return helper::normalization_hash<String, UTFTrait, false>(in, is_nfd<String, UTFTrait>(in));
+  }
+
+  /// Returns the hash of the NFC of in.
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  std::size_t
+  nfc_hash(String const &in) {
+    return helper::normalization_hash<String, UTFTrait, true>(in, is_nfc<String, UTFTrait>(in));
+  }
+
+  /// Tells whether lhs and rhs are canonically equivalent, i.e., have the same NFD.
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  bool
+  canonically_equal(String const &lhs, String const &rhs) {
+    if(lhs == rhs) {
+      return true;
+    }
+    // the normalization of a string is unique: two different normalized strings are not equivalent
+    else if((is_nfc<String, UTFTrait>(lhs) and is_nfc<String, UTFTrait>(rhs)) or
+            (is_nfd<String, UTFTrait>(lhs) and is_nfd<String, UTFTrait>(rhs))) {
+      return false;
+    }
+    typedef helper::decoder<typename String::const_iterator, UTFTrait> decoder_t;
+    helper::normalizing_reader<decoder_t, false, false> l(decoder_t(lhs.begin(), lhs.end()));
+    helper::normalizing_reader<decoder_t, false, false> r(decoder_t(rhs.begin(), rhs.end()));
+    codepoint_t lcp = 0, rcp = 0;
+    for(;;) {
+      bool const lmore = l.next(lcp);
+      bool const rmore = r.next(rcp);
+      if(lmore != rmore or (lmore and lcp != rcp)) {
+        return false;
+      }
+      else if(not lmore) {
+        return true;
+      }
+    }
+  }
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/hash.c++"
+#endif
+
+#endif
@@ -0,0 +1,370 @@
+/** literal.hpp --- normalization and case mapping of string literals at compile time
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * literal_nfd, literal_nfkd, literal_nfc, literal_nfkc, literal_lowercase and literal_uppercase map
+ * a UTF-8 string literal in a constant expression, so keys and identifiers don't have to be
+ * normalized at startup.  The result is a literal_string: a NUL terminated char array with room for
+ * the longest possible result (3 times the input for NFD and NFC, 11 times for NFKD and NFKC, 1.5
+ * times for the case mappings) and the actual size.  Like toNFC etc., an ill-formed sequence ends
+ * the input.
+ *
+ * The algorithms are the ones of normalization.hpp and case.hpp, written as C++14 constexpr
+ * functions (loops and local variables) over the constexpr compiled-in tables.  The rest of libuni
+ * is C++0x, only this header needs C++14.  Like LIBUNI_HEADER_ONLY (see config.hpp) it needs the
+ * generated tables in src/generated.  It always uses the compiled-in Unicode version, tables loaded
+ * at runtime with data::load are not used.
+ *
+ * Usage:
+ *   constexpr auto key = libuni::literal_nfc("Résumé");
+ *   static_assert(key.size() == 8, "composed");
+ *   std::string const s = key.str(); // or key.c_str()
+ */
+#ifndef LIBUNI_LITERAL_HPP
+#define LIBUNI_LITERAL_HPP
+
+#if __cplusplus < 201402L
+#error "libuni/literal.hpp needs C++14 constexpr (e.g., -std=c++14)"
+#endif
+
+#include "config.hpp"
+#include "codepoint.hpp"
+#include "utf.hpp"
+#include "normalization.hpp"
+#include "../../src/database.hpp"
+#include "../../src/data_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace libuni {
+  /// A UTF-8 string with a fixed capacity (including the terminating NUL).
+  template<std::size_t Capacity>
+  struct literal_string {
+    char data[Capacity];
+    std::size_t length;
+
+    constexpr
+    std::size_t
+    size() const {
+      return length;
+    }
+
+    constexpr
+    char const *
+    c_str() const {
+      return data;
+    }
+
+    constexpr
+    char
+    operator[](std::size_t i) const {
+      return data[i];
+    }
+
+    std::string
+    str() const {
+      return std::string(data, length);
+    }
+  };
+
+  namespace literal {
+    /** constexpr version of utf8::next_codepoint for char.  Accepts the well-formed sequences of
+     * Table 3-7 (like utf8::find_illformed) only: no overlong forms, surrogates or values above U+10FFFF.
+     */
+    constexpr
+    utf_status
+    next_codepoint(char const *&i, char const *end, codepoint_t &cp) {
+      if(i == end) {
+        return end_of_string;
+      }
+      unsigned char const lead = *i;
+      std::size_t const n = lead < 0x80 ? 1 : (0xC2 <= lead and lead <= 0xDF) ? 2 : (lead & 0xF0) == 0xE0 ? 3 :
+        (0xF0 <= lead and lead <= 0xF4) ? 4 : 0;
+      if(n == 0) {
+        return invalid_sequence;
+      }
+      else if(std::size_t(end - i) < n) {
+        return incomplete_sequence;
+      }
+      // range of the second byte
+      unsigned char const min = lead == 0xE0 ? 0xA0 : lead == 0xF0 ? 0x90 : 0x80;
+      unsigned char const max = lead == 0xED ? 0x9F : lead == 0xF4 ? 0x8F : 0xBF;
+      codepoint_t c = n == 1 ? lead : lead & (0x7F >> n);
+      for(std::size_t k = 1; k < n; ++k) {
+        unsigned char const trail = i[k];
+        if(k == 1 ? trail < min or max < trail : (trail & 0xC0) != 0x80) {
+          return invalid_sequence;
+        }
+        c = (c << 6) | (trail & 0x3F);
+      }
+      i += n;
+      cp = c;
+      return utf_ok;
+    }
+
+    /// constexpr version of utf8::codepoint_to_utf8.  Writes 1 to 4 bytes to out and returns the number.
+    constexpr
+    std::size_t
+    codepoint_to_utf8(codepoint_t cp, char *out) {
+      if(cp < 0x80) {
+        out[0] = char(cp);
+        return 1;
+      }
+      else if(cp < 0x800) {
+        out[0] = char(0xC0 | (cp >> 6));
+        out[1] = char(0x80 | (cp & 0x3F));
+        return 2;
+      }
+      else if(cp < 0x10000) {
+        out[0] = char(0xE0 | (cp >> 12));
+        out[1] = char(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = char(0x80 | (cp & 0x3F));
+        return 3;
+      }
+      out[0] = char(0xF0 | (cp >> 18));
+      out[1] = char(0x80 | ((cp >> 12) & 0x3F));
+      out[2] = char(0x80 | ((cp >> 6) & 0x3F));
+      out[3] = char(0x80 | (cp & 0x3F));
+      return 4;
+    }
+
+    constexpr
+    std::uint16_t
+    get_quick_check(codepoint_t cp) {
+      return libuni::helper::database::compiled_in.quick_check.lookup(cp);
+    }
+
+    constexpr
+    std::uint8_t
+    get_canonical_class(codepoint_t cp) {
+      return get_quick_check(cp) >> 8;
+    }
+
+    constexpr
+    codepoint_t
+    lowercase_mapping(codepoint_t cp) {
+      codepoint_t const r = libuni::helper::database::compiled_in.simple_lowercase_mapping.lookup(cp);
+      return r == 0 ? cp : r;
+    }
+
+    constexpr
+    codepoint_t
+    uppercase_mapping(codepoint_t cp) {
+      codepoint_t const r = libuni::helper::database::compiled_in.simple_uppercase_mapping.lookup(cp);
+      return r == 0 ? cp : r;
+    }
+
+    namespace helper {
+      template<std::size_t Capacity>
+      struct codepoints {
+        codepoint_t data[Capacity];
+        std::size_t size;
+      };
+
+      /// Appends the full decomposition of cp to out (see libuni::helper::decompose_codepoint).
+      template<bool Kompatibility, std::size_t Capacity>
+      constexpr
+      void
+      decompose_codepoint(codepoint_t cp, codepoints<Capacity> &out) {
+        codepoint_t stack[20] = { };
+        std::size_t stacksize = 0;
+        stack[stacksize++] = cp;
+        while(stacksize) {
+          codepoint_t const code = stack[--stacksize];
+          if(hangul::SBase <= code and code < hangul::SBase + hangul::SCount) { // Hangul Syllable Decomposition
+            codepoint_t const SIndex = code - hangul::SBase;
+            out.data[out.size++] = hangul::LBase + SIndex / hangul::NCount;
+            out.data[out.size++] = hangul::VBase + (SIndex % hangul::NCount) / hangul::TCount;
+            if(SIndex % hangul::TCount != 0) {
+              out.data[out.size++] = hangul::TBase + SIndex % hangul::TCount;
+            }
+            continue;
+          }
+          auto const &db = libuni::helper::database::compiled_in;
+          std::size_t const index = db.decomp_index.lookup(code);
+          codepoint_t const info = index == 0 ? 0 : db.decomp_map[index];
+          if(index != 0 and (Kompatibility or (info & 0xFF) == 0)) {
+            codepoint_t const *begin = db.decomp_map + index + 1;
+            codepoint_t const *end = begin + ((info >> 8) & 0xFF);
+            while(end != begin) {
+              stack[stacksize++] = *--end;
+            }
+          }
+          else {
+            out.data[out.size++] = code;
+          }
+        }
+      }
+
+      /// Decodes [i, end), decomposes it and puts it in canonical order.
+      template<bool Kompatibility, std::size_t Capacity>
+      constexpr
+      codepoints<Capacity>
+      decompose(char const *i, char const *end) {
+        codepoints<Capacity> out = { { }, 0 };
+        codepoint_t cp = 0;
+        while(next_codepoint(i, end, cp) == utf_ok) {
+          std::size_t const first = out.size;
+          decompose_codepoint<Kompatibility>(cp, out);
+          for(std::size_t k = first; k < out.size; ++k) { // Canonical Ordering Algorithm (D109)
+            std::uint8_t const canonical_class = get_canonical_class(out.data[k]);
+            for(std::size_t j = k; canonical_class != 0 and j > 0 and
+                  get_canonical_class(out.data[j - 1]) > canonical_class; --j) {
+              codepoint_t const tmp = out.data[j - 1];
+              out.data[j - 1] = out.data[j];
+              out.data[j] = tmp;
+            }
+          }
+        }
+        return out;
+      }
+
+      /// See libuni::helper::get_composition.
+      constexpr
+      codepoint_t
+      get_composition(codepoint_t first, codepoint_t second) {
+        if(hangul::LBase <= first and first < hangul::LBase + hangul::LCount and
+           hangul::VBase <= second and second < hangul::VBase + hangul::VCount) { // LV
+          return hangul::SBase + ((first - hangul::LBase) * hangul::VCount + second - hangul::VBase) * hangul::TCount;
+        }
+        else if(hangul::SBase <= first and first < hangul::SBase + hangul::SCount and
+                (first - hangul::SBase) % hangul::TCount == 0 and
+                hangul::TBase < second and second < hangul::TBase + hangul::TCount) { // LV + T
+          return first + second - hangul::TBase;
+        }
+        auto const &db = libuni::helper::database::compiled_in;
+        std::size_t const size = data_format::composition_size;
+        std::size_t lo = 0, hi = db.composition_map_size / size;
+        while(lo < hi) {
+          std::size_t const mid = (lo + hi) / 2;
+          std::uint32_t const *const record = db.composition_map + mid * size;
+          if(record[0] < first or (record[0] == first and record[1] < second)) {
+            lo = mid + 1;
+          }
+          else {
+            hi = mid;
+          }
+        }
+        if(lo * size < db.composition_map_size and db.composition_map[lo * size] == first and
+           db.composition_map[lo * size + 1] == second) {
+          return db.composition_map[lo * size + 2];
+        }
+        return 0;
+      }
+
+      /// Canonical Composition Algorithm (D117), see libuni::helper::compose.
+      template<std::size_t Capacity>
+      constexpr
+      void
+      compose(codepoints<Capacity> &str) {
+        std::size_t starter = Capacity; // last starter, if nothing blocks it
+        std::uint8_t last_class = 0;
+        std::size_t out = 0;
+        for(std::size_t i = 0; i < str.size; ++i) {
+          codepoint_t const cp = str.data[i];
+          std::uint16_t const qc = get_quick_check(cp);
+          std::uint8_t const canonical_class = qc >> 8;
+          if(starter != Capacity and ((qc >> libuni::helper::NFC) & 3) == Maybe and
+             (last_class < canonical_class or (last_class == 0 and out - 1 == starter))) {
+            if(codepoint_t const composite = get_composition(str.data[starter], cp)) {
+              str.data[starter] = composite;
+              continue;
+            }
+          }
+          if(canonical_class == 0) {
+            starter = out;
+          }
+          last_class = canonical_class;
+          str.data[out++] = cp;
+        }
+        str.size = out;
+      }
+
+      template<std::size_t Capacity, std::size_t CodepointCapacity>
+      constexpr
+      literal_string<Capacity>
+      encode(codepoints<CodepointCapacity> const &str) {
+        literal_string<Capacity> ret = { { }, 0 };
+        for(std::size_t i = 0; i < str.size; ++i) {
+          ret.length += codepoint_to_utf8(str.data[i], ret.data + ret.length);
+        }
+        return ret;
+      }
+
+      template<bool Kompatibility, bool Compose, std::size_t N>
+      constexpr
+      literal_string<(Kompatibility ? 11 : 3) * (N - 1) + 1>
+      normalize(char const (&in)[N]) {
+        codepoints<(Kompatibility ? 6 : 2) * (N - 1) + 1> tmp =
+          decompose<Kompatibility, (Kompatibility ? 6 : 2) * (N - 1) + 1>(in, in + N - 1);
+        if(Compose) {
+          compose(tmp);
+        }
+        return encode<(Kompatibility ? 11 : 3) * (N - 1) + 1>(tmp);
+      }
+
+      template<bool Upper, std::size_t N>
+      constexpr
+      literal_string<3 * (N - 1) / 2 + 1>
+      xcase(char const (&in)[N]) {
+        literal_string<3 * (N - 1) / 2 + 1> ret = { { }, 0 };
+        char const *i = in;
+        codepoint_t cp = 0;
+        while(next_codepoint(i, in + N - 1, cp) == utf_ok) {
+          ret.length += codepoint_to_utf8(Upper ? uppercase_mapping(cp) : lowercase_mapping(cp),
+                                          ret.data + ret.length);
+        }
+        return ret;
+      }
+    }
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<3 * (N - 1) + 1>
+  literal_nfd(char const (&in)[N]) {
+    return literal::helper::normalize<false, false>(in);
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<11 * (N - 1) + 1>
+  literal_nfkd(char const (&in)[N]) {
+    return literal::helper::normalize<true, false>(in);
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<3 * (N - 1) + 1>
+  literal_nfc(char const (&in)[N]) {
+    return literal::helper::normalize<false, true>(in);
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<11 * (N - 1) + 1>
+  literal_nfkc(char const (&in)[N]) {
+    return literal::helper::normalize<true, true>(in);
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<3 * (N - 1) / 2 + 1>
+  literal_lowercase(char const (&in)[N]) {
+    return literal::helper::xcase<false>(in);
+  }
+
+  template<std::size_t N>
+  constexpr
+  literal_string<3 * (N - 1) / 2 + 1>
+  literal_uppercase(char const (&in)[N]) {
+    return literal::helper::xcase<true>(in);
+  }
+}
+
+#endif
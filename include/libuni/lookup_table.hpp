@@ -0,0 +1,98 @@
+/** lookup_table.hpp --- table layouts used by the generated Unicode database
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The generator (src/generate_two_stage_table.c++) picks one of these layouts for each property
+ * and emits an instance called <property>_table.  The library only calls lookup() and therefore
+ * does not depend on the layout.  Tables and lookups are constexpr so they can be inlined (see
+ * LIBUNI_HEADER_ONLY in config.hpp).
+ *
+ * - two_stage_table :: index[cp >> shift] selects a block in data.
+ * - latin1_table :: direct array for U+0000..U+00FF, two_stage_table for everything else.
+ * - bmp_trie :: the BMP index stores data offsets directly (one shift, two loads).  Supplementary
+ *               code points use a three stage table (index1, index2, data).
+ *
+ * The tables cover U+0000..U+10FFFF.  Larger values (e.g., from ill-formed input) return 0.
+ *
+ * See also the layout_table in the generator which has to be kept in sync.
+ */
+#ifndef LIBUNI_LOOKUP_TABLE_HPP
+#define LIBUNI_LOOKUP_TABLE_HPP
+
+#include "codepoint.hpp"
+
+#include <cstddef>
+
+namespace libuni {
+  namespace helper {
+    codepoint_t const table_limit = 0x110000;
+
+    template<typename Index, typename T>
+    struct two_stage_table {
+      typedef Index index_type;
+      typedef T value_type;
+      static unsigned const layout = 0; // see data_format::layout_id
+
+      Index const *index;
+      T const *data;
+      std::size_t shift;
+
+      constexpr
+      T
+      lookup(codepoint_t cp) const {
+        return cp < table_limit
+          ? data[(std::size_t(index[cp >> shift]) << shift) + (cp & ((codepoint_t(1) << shift) - 1))]
+          : T();
+      }
+    };
+
+    template<typename Index, typename T>
+    struct latin1_table {
+      typedef Index index_type;
+      typedef T value_type;
+      static unsigned const layout = 1;
+
+      T const *latin1;
+      two_stage_table<Index, T> rest;
+
+      constexpr
+      T
+      lookup(codepoint_t cp) const {
+        return cp < 0x100 ? latin1[cp] : rest.lookup(cp);
+      }
+    };
+
+    std::size_t const bmp_trie_shift = 6;
+
+    template<typename BmpIndex, typename Index1, typename Index2, typename T>
+    struct bmp_trie {
+      typedef BmpIndex bmp_index_type;
+      typedef Index1 index1_type;
+      typedef Index2 index2_type;
+      typedef T value_type;
+      static unsigned const layout = 2;
+
+      BmpIndex const *bmp_index;
+      Index1 const *index1;
+      Index2 const *index2;
+      T const *data;
+      std::size_t shift; // of index1
+
+      constexpr
+      T
+      lookup(codepoint_t cp) const {
+        return cp < 0x10000
+          ? data[std::size_t(bmp_index[cp >> bmp_trie_shift]) + (cp & ((1u << bmp_trie_shift) - 1))]
+          : cp >= table_limit ? T()
+          : data[(std::size_t(index2[(std::size_t(index1[(cp - 0x10000) >> (bmp_trie_shift + shift)]) << shift) +
+                                     (((cp - 0x10000) >> bmp_trie_shift) & ((codepoint_t(1) << shift) - 1))])
+                  << bmp_trie_shift) + (cp & ((1u << bmp_trie_shift) - 1))];
+      }
+    };
+  }
+}
+
+#endif
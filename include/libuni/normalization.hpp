@@ -12,11 +12,18 @@
 #ifndef LIBUNI_NORMALIZATION_HPP
 #define LIBUNI_NORMALIZATION_HPP
 
+#include "config.hpp"
+#include "stats.hpp"
 #include "codepoint.hpp"
 #include "codepoint_string.hpp"
 #include "utf8.hpp"
+#include "simd.hpp"
 
 #include <cassert> // TODO
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 namespace libuni {
   enum quick_check_t {
@@ -26,7 +33,7 @@ namespace libuni {
   };
 
   namespace helper {
-    extern
+    LIBUNI_LINKAGE
     std::uint16_t
     get_quick_check(codepoint_t cp);
 
@@ -55,9 +62,19 @@ namespace libuni {
       return static_cast<quick_check_t>((libuni::helper::is_allowed(qc) >> NF) & 3);
     }
 
-    extern
+    LIBUNI_LINKAGE
     bool
     get_decomp_mapping(codepoint_t cp, std::size_t &prefix, codepoint_t const *&begin, codepoint_t const *&end);
+
+    /** Skips a run of ASCII in contiguous UTF-8 with the SIMD kernel (see simd.hpp).  ASCII is
+     * Yes with canonical class 0 in every normalization form.  Returns true if i was moved.
+     */
+    template<typename UTFTrait, typename I>
+    bool
+    skip_ascii(I &i, I end) {
+      return simd::helper::skip_ascii(i, end, std::integral_constant<bool,
+        is_utf8<UTFTrait>::value and simd::helper::contiguous_bytes<I>::value>());
+    }
   }
 
   template<typename String, typename UTFTrait, helper::normalization_form Select>
@@ -69,15 +86,23 @@ namespace libuni {
     iterator_t const end = in.end();
     iterator_t i = in.begin();
     codepoint_t cp;
-    while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+    for(;;) {
+      if(helper::skip_ascii<UTFTrait>(i, end)) {
+        last_canonical_class = 0;
+      }
+      if(UTFTrait::next_codepoint(i, end, cp) != utf_ok) {
+        break;
+      }
       std::uint16_t const qc = helper::get_quick_check(cp);
       std::uint8_t const canonical_class = helper::get_canonical_class(qc);
       if(last_canonical_class > canonical_class and canonical_class != 0) {
+        LIBUNI_STATS_COUNT(quick_check_no);
         return No;
       }
 
       quick_check_t const check = helper::is_allowed<Select>(qc);
       if(check == No) {
+        LIBUNI_STATS_COUNT(quick_check_no);
         return No;
       }
       else if(check == Maybe) {
@@ -85,6 +110,12 @@ namespace libuni {
       }
       last_canonical_class = canonical_class;
     }
+    if(result == Yes) {
+      LIBUNI_STATS_COUNT(quick_check_yes);
+    }
+    else {
+      LIBUNI_STATS_COUNT(quick_check_maybe);
+    }
     return result;
   }
 
@@ -96,7 +127,13 @@ namespace libuni {
     iterator_t const end = in.end();
     iterator_t i = in.begin();
     codepoint_t cp;
-    while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+    for(;;) {
+      if(helper::skip_ascii<UTFTrait>(i, end)) {
+        last_canonical_class = 0;
+      }
+      if(UTFTrait::next_codepoint(i, end, cp) != utf_ok) {
+        break;
+      }
       std::uint16_t const qc = helper::get_quick_check(cp);
       std::uint8_t const canonical_class = helper::get_canonical_class(qc);
       if(last_canonical_class > canonical_class and canonical_class != 0) {
@@ -138,10 +175,33 @@ namespace libuni {
   }
 
   namespace helper {
-    template<typename String, typename UTFTrait, bool Kompatibility>
-    codepoint_string_t
-    decompose(String const &in) {
-      codepoint_string_t tmp; // store codepoints before reorder
+    /// Returns the primary composite of first and second or 0.
+    LIBUNI_LINKAGE
+    codepoint_t
+    get_composition(codepoint_t first, codepoint_t second);
+
+    /** Applies the Canonical Composition Algorithm to [begin, end) (which has to be in canonical
+     * order) in place.  Returns the new length.
+     */
+    LIBUNI_LINKAGE
+    std::size_t
+    compose(codepoint_t *begin, codepoint_t *end);
+
+    /// Composes the code points in str (a codepoint_string_t or a normalization_context buffer).
+    template<typename Buffer>
+    Buffer &
+    compose(Buffer &str) {
+      str.resize(compose(&str[0], &str[0] + str.size()));
+      return str;
+    }
+
+    /** Decomposes in into tmp (which is cleared first) and puts it in canonical order.  Buffer is
+     * a std::basic_string of code points with any allocator.
+     */
+    template<typename String, typename UTFTrait, bool Kompatibility, typename Buffer>
+    void
+    decompose_into(String const &in, Buffer &tmp) {
+      tmp.clear(); // store codepoints before reorder
       tmp.reserve(in.size() + 10);
       codepoint_t stack[20];
       std::size_t stacksize = 0;
@@ -175,6 +235,7 @@ namespace libuni {
             while(end != begin) {
               stack[stacksize++] = *--end;
             }
+            LIBUNI_STATS_RECORD(decompose_stack_depth, stacksize);
           }
           else {
             tmp.push_back(code);
@@ -183,9 +244,13 @@ namespace libuni {
       }
 
 
+      if(tmp.empty()) {
+        return;
+      }
+
       // Canonical Ordering Algorithm  (D109)
       std::uint8_t prev = helper::get_canonical_class(helper::get_quick_check(tmp[0]));
-      codepoint_string_t::iterator sortbeg = tmp.begin() - 1;
+      typename Buffer::iterator sortbeg = tmp.begin() - 1;
       for(auto i = tmp.begin(); i != tmp.end(); ++i) {
         std::uint8_t cur = helper::get_canonical_class(helper::get_quick_check(*i));
 
@@ -196,9 +261,10 @@ namespace libuni {
           prev = cur;
         }
         else {
-          codepoint_string_t::iterator j = i - 1;
+          typename Buffer::iterator j = i - 1;
           for(;;) {
             std::swap(*j, *(j + 1));
+            LIBUNI_STATS_COUNT(reorder_swaps);
             --j;
             if(j == sortbeg) {
               break;
@@ -211,19 +277,104 @@ namespace libuni {
           prev = helper::get_canonical_class(helper::get_quick_check(*i));
         }
       }
+    }
 
+    template<typename String, typename UTFTrait, bool Kompatibility>
+    codepoint_string_t
+    decompose(String const &in) {
+      codepoint_string_t tmp;
+      decompose_into<String, UTFTrait, Kompatibility>(in, tmp);
       return tmp;
     }
+
+    /// Normalizes in (which is not in NF) to the code points in tmp, the scratch buffer.
+    template<normalization_form NF, typename String, typename UTFTrait, typename Buffer>
+    void
+    normalize_into(String const &in, Buffer &tmp) {
+      LIBUNI_STATS_COUNT(normalize_decompose);
+      decompose_into<String, UTFTrait, (NF & NFKD) != 0>(in, tmp);
+      if(NF & NFC) {
+        compose(tmp);
+      }
+    }
+
+    /** Returns in (which is not in NF) normalized to NF.  tmp is the scratch buffer for the code
+     * points.  The result is allocated with the allocator of in.
+     */
+    template<normalization_form NF, typename String, typename UTFTrait, typename Buffer>
+    String
+    normalize(String const &in, Buffer &tmp) {
+      normalize_into<NF, String, UTFTrait>(in, tmp);
+      return UTFTrait::from_codepoints(tmp, in.get_allocator());
+    }
+
+    /// Encodes the code points in tmp into out, which is cleared first and keeps its capacity.
+    template<typename UTFTrait, typename Buffer, typename String>
+    void
+    encode_into(Buffer const &tmp, String &out) {
+      out.clear();
+      for(auto i = tmp.begin(); i != tmp.end(); ++i) {
+        UTFTrait::append(out, *i);
+      }
+    }
+
+    /** The body of every toNFD, toNFKD, toNFC and toNFKC: returns in if it is in NF (moved if it is
+     * an rvalue) or in normalized with the scratch buffer tmp.
+     */
+    template<normalization_form NF, typename UTFTrait, typename In, typename Buffer>
+    typename std::decay<In>::type
+    to_nf(In &&in, Buffer &tmp) {
+      typedef typename std::decay<In>::type String;
+      if(is_nfX<String, UTFTrait, NF>(in)) {
+        LIBUNI_STATS_COUNT(normalize_unchanged);
+        return std::forward<In>(in);
+      }
+      return normalize<NF, String, UTFTrait>(in, tmp);
+    }
   }
 
+  /** Scratch space to normalize many strings (see toNFD(in, context) etc.).  The code points are
+   * stored in a buffer allocated with Alloc, which keeps its capacity from one string to the next.
+   * Only the results are allocated (with the allocator of the input).  A context must not be used
+   * by two threads at the same time.
+   *
+   * Usage:
+   *   normalization_context<> context;
+   *   for(auto i = lines.begin(); i != lines.end(); ++i) {
+   *     out.push_back(toNFC(*i, context));
+   *   }
+   */
+  template<typename Alloc = std::allocator<codepoint_t>>
+  class normalization_context {
+  public:
+    typedef std::basic_string<codepoint_t, std::char_traits<codepoint_t>, Alloc> buffer_type;
+
+    buffer_type buffer;
+
+    explicit normalization_context(Alloc const &alloc = Alloc())
+      : buffer(alloc)
+    { }
+  };
+
   template<typename String, typename UTFTrait = utf_trait<String>>
   String toNFD(String const &in) {
-    if(is_nfd(in)) {
-      return in;
-    }
-    else {
-      return UTFTrait::from_codepoints(helper::decompose<String, UTFTrait, false>(in));
-    }
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFD, UTFTrait>(in, tmp);
+  }
+
+  /// Moves in to the result if it is in NFD (same for toNFKD, toNFC and toNFKC).
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toNFD(String &&in) {
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFD, UTFTrait>(std::move(in), tmp);
+  }
+
+  /// Same as toNFD(in) but the code points are buffered in context (same for toNFKD, toNFC and toNFKC).
+  template<typename String, typename UTFTrait = utf_trait<String>, typename Alloc>
+  String
+  toNFD(String const &in, normalization_context<Alloc> &context) {
+    return helper::to_nf<helper::NFD, UTFTrait>(in, context.buffer);
   }
 
   // Normalization Form KD (NFKD): Compatibility Decomposition
@@ -241,22 +392,176 @@ namespace libuni {
 
   template<typename String, typename UTFTrait = utf_trait<String>>
   String toNFKD(String const &in) {
-    if(is_nfkd(in)) {
-      return in;
-    }
-    else {
-      return UTFTrait::from_codepoints(helper::decompose<String, UTFTrait, true>(in));
-    }
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFKD, UTFTrait>(in, tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toNFKD(String &&in) {
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFKD, UTFTrait>(std::move(in), tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>, typename Alloc>
+  String
+  toNFKD(String const &in, normalization_context<Alloc> &context) {
+    return helper::to_nf<helper::NFKD, UTFTrait>(in, context.buffer);
   }
 
-  // Normalization Form C (NFC): Canonical Decomposition, followed by Canonical Composition
   namespace helper {
-    inline
-    codepoint_string_t
-    compose(codepoint_string_t const &in) {
-      // TODO
-      return in;
+    /** Writes the full decomposition of cp (canonical or, with Kompatibility, compatibility) to out
+     * and returns the number of code points (at most 18).  Not in canonical order.
+     */
+    template<bool Kompatibility>
+    std::size_t
+    decompose_codepoint(codepoint_t cp, codepoint_t *out) {
+      codepoint_t *const out_begin = out;
+      codepoint_t stack[20];
+      std::size_t stacksize = 0;
+      stack[stacksize++] = cp;
+      while(stacksize) {
+        codepoint_t const code = stack[--stacksize];
+        if(hangul::SBase <= code and code < hangul::SBase + hangul::SCount) { // Hangul Syllable Decomposition
+          codepoint_t const SIndex = code - hangul::SBase;
+          *out++ = hangul::LBase + SIndex / hangul::NCount;
+          *out++ = hangul::VBase + (SIndex % hangul::NCount) / hangul::TCount;
+          if(SIndex % hangul::TCount != 0) {
+            *out++ = hangul::TBase + SIndex % hangul::TCount;
+          }
+          continue;
+        }
+        std::size_t prefix;
+        codepoint_t const *begin = 0x0, *end = 0x0;
+        if(helper::get_decomp_mapping(code, prefix, begin, end) and (Kompatibility or prefix == 0)) {
+          assert(end - begin + stacksize < sizeof(stack)/sizeof(stack[0]));
+          while(end != begin) {
+            stack[stacksize++] = *--end;
+          }
+        }
+        else {
+          *out++ = code;
+        }
+      }
+      return out - out_begin;
     }
+
+    /// A code point source (see normalizing_reader) decoding [i, end).
+    template<typename I, typename UTFTrait>
+    struct decoder {
+      I i;
+      I end;
+
+      decoder(I begin, I end)
+        : i(begin), end(end)
+      { }
+
+      bool
+      next(codepoint_t &cp) {
+        return UTFTrait::next_codepoint(i, end, cp) == utf_ok;
+      }
+    };
+
+    /** Reads the code points of source (anything with a bool next(codepoint_t&) member like
+     * decoder) normalized on the fly: NFD (NFKD with Kompatibility) or NFC (NFKC) with Compose.
+     * The input is normalized in segments, which end in front of a starter (with Compose in front
+     * of a starter which never combines with a preceding code point, i.e., NFC_QC=Yes).  Only a few
+     * segments are buffered.
+     *
+     * Usage:
+     *   typedef helper::decoder<iterator, UTFTrait> decoder_t;
+     *   helper::normalizing_reader<decoder_t, false, true> r(decoder_t(str.begin(), str.end()));
+     *   for(codepoint_t cp; r.next(cp); ) {
+     *     // cp is the next code point of the NFC of str
+     *   }
+     */
+    template<typename Source, bool Kompatibility, bool Compose>
+    class normalizing_reader {
+      Source source;
+      codepoint_string_t segment;
+      std::size_t pos;          // next code point of segment to return
+      std::size_t ready;        // segment[0, ready) is normalized
+      std::uint8_t last_class;  // canonical class of segment.back()
+      bool eos;
+
+      /// Appends cp and moves it to its place in canonical order (Canonical Ordering Algorithm, D109)
+      void
+      append(codepoint_t cp, std::uint16_t qc) {
+        std::uint8_t const canonical_class = get_canonical_class(qc);
+        if(canonical_class == 0) {
+          if(segment.size() > ready and (not Compose or is_allowed<NFC>(qc) == Yes)) {
+            finish(segment.size());
+          }
+          last_class = 0;
+        }
+        else if(canonical_class < last_class) {
+          std::size_t j = segment.size();
+          while(j > ready and get_canonical_class(get_quick_check(segment[j - 1])) > canonical_class) {
+            --j;
+            LIBUNI_STATS_COUNT(reorder_swaps);
+          }
+          segment.insert(segment.begin() + j, cp);
+          return;
+        }
+        else {
+          last_class = canonical_class;
+        }
+        segment.push_back(cp);
+      }
+
+      /// Marks segment[ready, n) as complete.
+      void
+      finish(std::size_t n) {
+        if(Compose and n - ready > 1) {
+          std::size_t const composed = ready + compose(&segment[ready], &segment[0] + n);
+          segment.erase(composed, n - composed);
+          n = composed;
+        }
+        ready = n;
+      }
+
+      void
+      fill() {
+        segment.erase(0, ready);
+        pos = ready = 0;
+        codepoint_t cp;
+        while(ready < 64 and not eos) { // read a few segments at a time
+          if(not source.next(cp)) {
+            eos = true;
+            finish(segment.size());
+            break;
+          }
+          std::uint16_t const qc = get_quick_check(cp);
+          if(is_allowed<Kompatibility ? NFKD : NFD>(qc) == Yes) { // no decomposition mapping
+            append(cp, qc);
+          }
+          else {
+            codepoint_t decomposed[20];
+            std::size_t const n = decompose_codepoint<Kompatibility>(cp, decomposed);
+            for(std::size_t k = 0; k < n; ++k) {
+              append(decomposed[k], get_quick_check(decomposed[k]));
+            }
+          }
+        }
+      }
+
+    public:
+      explicit normalizing_reader(Source const &source)
+        : source(source), pos(0), ready(0), last_class(0), eos(false)
+      { }
+
+      bool
+      next(codepoint_t &cp) {
+        if(pos == ready) {
+          fill();
+          if(ready == 0) {
+            return false;
+          }
+        }
+        cp = segment[pos++];
+        return true;
+      }
+    };
   }
 
   template<typename String, typename UTFTrait = utf_trait<String>>
@@ -273,13 +578,21 @@ namespace libuni {
 
   template<typename String, typename UTFTrait = utf_trait<String>>
   String toNFC(String const &in) {
-    if(is_nfc(in)) {
-      return in;
-    }
-    else {
-      codepoint_string_t tmp = helper::decompose<String, UTFTrait, false>(in);
-      return UTFTrait::from_codepoints(helper::compose(tmp));
-    }
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFC, UTFTrait>(in, tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toNFC(String &&in) {
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFC, UTFTrait>(std::move(in), tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>, typename Alloc>
+  String
+  toNFC(String const &in, normalization_context<Alloc> &context) {
+    return helper::to_nf<helper::NFC, UTFTrait>(in, context.buffer);
   }
 
   // Normalization Form KC (NFKC): Compatibility Decomposition, followed by Canonical Composition
@@ -297,14 +610,59 @@ namespace libuni {
 
   template<typename String, typename UTFTrait = utf_trait<String>>
   String toNFKC(String const &in) {
-    if(is_nfc(in)) {
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFKC, UTFTrait>(in, tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  typename helper::enable_if_rvalue<String>::type
+  toNFKC(String &&in) {
+    codepoint_string_t tmp;
+    return helper::to_nf<helper::NFKC, UTFTrait>(std::move(in), tmp);
+  }
+
+  template<typename String, typename UTFTrait = utf_trait<String>, typename Alloc>
+  String
+  toNFKC(String const &in, normalization_context<Alloc> &context) {
+    return helper::to_nf<helper::NFKC, UTFTrait>(in, context.buffer);
+  }
+
+  /** Returns in if it is in the normalization form NF (helper::NFD, NFKD, NFC or NFKC).  Otherwise
+   * in is normalized into buffer and buffer is returned.  Normalized input is neither copied nor
+   * allocated and buffer keeps its capacity, so reusing it avoids allocations for the others too.
+   * Usage:
+   *   std::string buffer;
+   *   std::string const &key = normalize_if_needed<helper::NFC>(in, buffer);
+   */
+  template<helper::normalization_form NF, typename String, typename UTFTrait = utf_trait<String>>
+  String const &
+  normalize_if_needed(String const &in, String &buffer) {
+    if(is_nfX<String, UTFTrait, NF>(in)) {
+      LIBUNI_STATS_COUNT(normalize_unchanged);
       return in;
     }
-    else {
-      codepoint_string_t tmp = helper::decompose<String, UTFTrait, true>(in);
-      return UTFTrait::from_codepoints(helper::compose(tmp));
+    codepoint_string_t tmp;
+    helper::normalize_into<NF, String, UTFTrait>(in, tmp);
+    helper::encode_into<UTFTrait>(tmp, buffer);
+    return buffer;
+  }
+
+  /// Same as normalize_if_needed(in, buffer) but the code points are buffered in context.
+  template<helper::normalization_form NF, typename String, typename UTFTrait = utf_trait<String>, typename Alloc>
+  String const &
+  normalize_if_needed(String const &in, String &buffer, normalization_context<Alloc> &context) {
+    if(is_nfX<String, UTFTrait, NF>(in)) {
+      LIBUNI_STATS_COUNT(normalize_unchanged);
+      return in;
     }
+    helper::normalize_into<NF, String, UTFTrait>(in, context.buffer);
+    helper::encode_into<UTFTrait>(context.buffer, buffer);
+    return buffer;
   }
 }
 
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/normalization.c++"
+#endif
+
 #endif
@@ -0,0 +1,136 @@
+/** properties.hpp --- General_Category, Script, Cased and Alphabetic of code points
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The properties of a code point are packed into two bytes (character_properties) and are looked
+ * up with a single table lookup.  get_properties(cp) looks up one code point,
+ * lookup_properties(p, n, out) a whole buffer: with AVX2 (see simd.hpp) it gathers the table
+ * entries of eight code points at once.
+ *
+ * Cased and Alphabetic are the derived properties of DerivedCoreProperties.txt (see UAX#44).  If
+ * the UCD used for the build lacks that file, they are approximated by the General_Category and if
+ * it lacks Scripts.txt, the Script of every code point is Unknown.
+ *
+ * The Script is an index into the script names of the database (script_name).  The indices depend
+ * on the Unicode version, so use find_script instead of hard coding them.  0 is always Unknown.
+ *
+ * Usage:
+ *   std::vector<libuni::character_properties> props(text.size());
+ *   libuni::lookup_properties(text.data(), text.size(), props.data());
+ *   libuni::script_t latin;
+ *   libuni::find_script("Latin", latin);
+ *   for(std::size_t i = 0; i < props.size(); ++i) {
+ *     if(props[i].alphabetic() and props[i].script() == latin) {
+ *       ...
+ *     }
+ *   }
+ */
+#ifndef LIBUNI_PROPERTIES_HPP
+#define LIBUNI_PROPERTIES_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libuni {
+  /// General_Category values (UAX#44 5.7.1).  Unassigned code points are Cn.
+  namespace general_category { // Yes/No/Maybe of the quick check are in libuni as well
+    enum type {
+      Cn, // Unassigned
+      Lu, // Uppercase_Letter
+      Ll, // Lowercase_Letter
+      Lt, // Titlecase_Letter
+      Lm, // Modifier_Letter
+      Lo, // Other_Letter
+      Mn, // Nonspacing_Mark
+      Mc, // Spacing_Mark
+      Me, // Enclosing_Mark
+      Nd, // Decimal_Number
+      Nl, // Letter_Number
+      No, // Other_Number
+      Pc, // Connector_Punctuation
+      Pd, // Dash_Punctuation
+      Ps, // Open_Punctuation
+      Pe, // Close_Punctuation
+      Pi, // Initial_Punctuation
+      Pf, // Final_Punctuation
+      Po, // Other_Punctuation
+      Sm, // Math_Symbol
+      Sc, // Currency_Symbol
+      Sk, // Modifier_Symbol
+      So, // Other_Symbol
+      Zs, // Space_Separator
+      Zl, // Line_Separator
+      Zp, // Paragraph_Separator
+      Cc, // Control
+      Cf, // Format
+      Cs, // Surrogate
+      Co  // Private_Use
+    };
+  }
+
+  std::size_t const general_categories = general_category::Co + 1;
+
+  typedef std::uint8_t script_t;
+
+  /// The packed properties of a code point (see data_format::properties in src/data_format.hpp).
+  struct character_properties {
+    std::uint16_t bits;
+
+    general_category::type
+    category() const {
+      return general_category::type(bits & 0x1F);
+    }
+
+    script_t
+    script() const {
+      return bits >> 8;
+    }
+
+    bool
+    cased() const {
+      return bits & 0x20;
+    }
+
+    bool
+    alphabetic() const {
+      return bits & 0x40;
+    }
+  };
+
+  /// Returns the properties of cp.  Values above U+10FFFF are unassigned.
+  LIBUNI_LINKAGE
+  character_properties
+  get_properties(codepoint_t cp);
+
+  /// Writes the properties of [p, p + n) to [out, out + n).
+  LIBUNI_LINKAGE
+  void
+  lookup_properties(codepoint_t const *p, std::size_t n, character_properties *out);
+
+  /// Returns the name of the script s (e.g., "Latin") or 0 if s is not a script of the database.
+  LIBUNI_LINKAGE
+  char const*
+  script_name(script_t s);
+
+  /// Sets s to the script called name.  Returns false if the database has no such script.
+  LIBUNI_LINKAGE
+  bool
+  find_script(char const *name, script_t &s);
+
+  /// Returns the abbreviation of c (e.g., "Lu").
+  LIBUNI_LINKAGE
+  char const*
+  general_category_name(general_category::type c);
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/properties.c++"
+#endif
+
+#endif
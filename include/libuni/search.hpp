@@ -0,0 +1,207 @@
+/** search.hpp --- case and normalization insensitive substring search
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Finds a pattern in a text ignoring case and canonical equivalence, i.e., "café" matches "CAFÉ"
+ * and "café".  Pattern and text are compared in a folded form: the canonical decomposition
+ * (NFD) with every code point case folded and, with ignore_accents, without non-starters
+ * (combining marks), so "cafe" matches "café" as well.  The default options ignore case only, use
+ * search::options::accent_insensitive() to ignore accents too.  Case folding uses the simple case
+ * mappings (lowercase of the uppercase), special casing (e.g., "ß" vs. "SS") is not supported.
+ *
+ * The text is folded lazily while it is scanned, once, with a Boyer-Moore-Horspool matcher over the
+ * folded code points.  Nothing as large as the text is allocated.  Matches are reported as code
+ * unit offsets (bytes for UTF-8) into the original text and always cover whole code points.  A
+ * match must not end in front of a combining mark (unless they are ignored): "cafe" does not match
+ * "café" in any normalization form.
+ *
+ * Usage:
+ *   libuni::searcher const s(pattern);
+ *   libuni::search::context context; // optional, reuses the buffer
+ *   std::size_t begin, end = 0;
+ *   while(s.find(text, begin, end, end, context)) {
+ *     match = text.substr(begin, end - begin);
+ *   }
+ */
+#ifndef LIBUNI_SEARCH_HPP
+#define LIBUNI_SEARCH_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+#include "utf.hpp"
+#include "utf8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace libuni {
+  namespace search {
+    struct options {
+      bool ignore_case;
+      bool ignore_accents; // ignore non-starters (combining marks)
+
+      options(bool ignore_case = true, bool ignore_accents = false)
+        : ignore_case(ignore_case), ignore_accents(ignore_accents)
+      { }
+
+      /// Ignores case and accents: "cafe" matches "Café".
+      static options
+      accent_insensitive() {
+        return options(true, true);
+      }
+    };
+
+    std::size_t const npos = static_cast<std::size_t>(-1);
+  }
+
+  namespace helper {
+    /// A folded code point and the offsets of the code point in the text it comes from.
+    struct folded_codepoint {
+      codepoint_t cp;
+      std::uint8_t canonical_class;
+      std::size_t begin;
+      std::size_t end;
+    };
+
+    /** Appends the folded form of cp, which is at [begin, end) in the text, to out.  Keeps out in
+     * canonical order and returns the index of the last starter in out (or 0 if there is none),
+     * everything in front of it is final.
+     */
+    LIBUNI_LINKAGE
+    std::size_t
+    fold(codepoint_t cp, std::size_t begin, std::size_t end, search::options const &opt,
+         std::vector<folded_codepoint> &out);
+
+    /// A pattern prepared for the Horspool matcher.
+    struct folded_pattern {
+      search::options opt;
+      std::vector<codepoint_t> cps;
+      std::size_t shift[256]; // indexed by the low byte of the last code point of the window
+    };
+
+    /// Folds [begin, end) into p.cps and fills the shift table.
+    LIBUNI_LINKAGE
+    void
+    prepare(codepoint_t const *begin, codepoint_t const *end, folded_pattern &p);
+
+    /** Searches p in text[pos, final).  text[final] (if there) has to be a starter.  On success sets
+     * match_begin/match_end to the offsets and returns true.  Otherwise returns false and pos is the
+     * first window that has to be checked again once more text is folded.
+     */
+    LIBUNI_LINKAGE
+    bool
+    horspool(folded_pattern const &p, std::vector<folded_codepoint> const &text, std::size_t &pos,
+             std::size_t final, std::size_t &match_begin, std::size_t &match_end);
+  }
+
+  namespace search {
+    /// The buffer of searcher::find.  Pass one to repeated searches to keep its capacity.
+    struct context {
+      std::vector<helper::folded_codepoint> folded;
+    };
+  }
+
+  /// A pattern prepared for repeated searches.
+  class searcher {
+    helper::folded_pattern pattern;
+
+  public:
+    template<typename String, typename UTFTrait = utf_trait<String>>
+    explicit searcher(String const &in, search::options const &opt = search::options()) {
+      typedef typename String::const_iterator iterator_t;
+      iterator_t const end = in.end();
+      iterator_t i = in.begin();
+      codepoint_t cp;
+      std::vector<codepoint_t> cps;
+      while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+        cps.push_back(cp);
+      }
+      pattern.opt = opt;
+      helper::prepare(cps.data(), cps.data() + cps.size(), pattern);
+    }
+
+    /** Finds the first match in text starting at the code unit offset from.  Returns false if there
+     * is none.  An empty pattern matches at from.
+     */
+    template<typename String, typename UTFTrait = utf_trait<String>>
+    bool
+    find(String const &text, std::size_t &match_begin, std::size_t &match_end, std::size_t from = 0) const {
+      search::context context;
+      return find<String, UTFTrait>(text, match_begin, match_end, from, context);
+    }
+
+    /// Like the above but folds the text into the buffer of context.
+    template<typename String, typename UTFTrait = utf_trait<String>>
+    bool
+    find(String const &text, std::size_t &match_begin, std::size_t &match_end, std::size_t from,
+         search::context &context) const {
+      if(pattern.cps.empty()) {
+        match_begin = match_end = from;
+        return from <= text.size();
+      }
+      if(from >= text.size()) {
+        return false;
+      }
+      typedef typename String::const_iterator iterator_t;
+      iterator_t const begin = text.begin();
+      iterator_t const end = text.end();
+      iterator_t i = begin + from;
+      codepoint_t cp;
+      std::vector<helper::folded_codepoint> &folded = context.folded;
+      folded.clear();
+      folded.reserve(256);
+      std::size_t pos = 0; // first window not yet checked
+      std::size_t offset = from;
+      while(UTFTrait::next_codepoint(i, end, cp) == utf_ok) {
+        std::size_t const next = i - begin;
+        std::size_t final;
+        if(cp < 0x80) { // the ASCII case of helper::fold
+          if(pattern.opt.ignore_case and 'A' <= cp and cp <= 'Z') {
+            cp += 'a' - 'A';
+          }
+          helper::folded_codepoint const f = { cp, 0, offset, next };
+          folded.push_back(f);
+          final = folded.size() - 1;
+        }
+        else {
+          final = helper::fold(cp, offset, next, pattern.opt, folded);
+        }
+        offset = next;
+        if(final >= pos + pattern.cps.size() + 64 and // search in batches
+           helper::horspool(pattern, folded, pos, final, match_begin, match_end)) {
+          return true;
+        }
+        if(pos >= 4096) { // drop what has been searched
+          folded.erase(folded.begin(), folded.begin() + pos);
+          pos = 0;
+        }
+      }
+      return helper::horspool(pattern, folded, pos, folded.size(), match_begin, match_end);
+    }
+
+    /// Returns the offset of the first match in text or search::npos.
+    template<typename String, typename UTFTrait = utf_trait<String>>
+    std::size_t
+    find(String const &text, std::size_t from = 0) const {
+      std::size_t match_begin, match_end;
+      return find<String, UTFTrait>(text, match_begin, match_end, from) ? match_begin : search::npos;
+    }
+  };
+
+  /// Returns the code unit offset of the first match of pattern in text or search::npos.
+  template<typename String, typename UTFTrait = utf_trait<String>>
+  std::size_t
+  find(String const &text, String const &pattern, search::options const &opt = search::options()) {
+    return searcher(pattern, opt).find<String, UTFTrait>(text);
+  }
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/search.c++"
+#endif
+
+#endif
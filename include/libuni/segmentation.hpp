@@ -10,9 +10,14 @@
 #ifndef LIBUNI_SEGMENTATION_HPP
 #define LIBUNI_SEGMENTATION_HPP
 
+#include "config.hpp"
+#include "stats.hpp"
 #include "codepoint.hpp"
 
+#include <cstddef>
+
 namespace libuni {
+#ifndef LIBUNI_HEADER_ONLY // otherwise defined as constants in segmentation.c++ (see below)
   namespace break_property {
     extern unsigned const None;
     extern unsigned const CR;
@@ -28,12 +33,20 @@ namespace libuni {
     extern unsigned const Numeric;
     extern unsigned const ExtendNumLet;
   }
+#endif
 
   namespace helper {
-    extern
+    LIBUNI_LINKAGE
     unsigned
     get_word_breaks(codepoint_t cp);
   }
+}
+
+#ifdef LIBUNI_HEADER_ONLY // break_property has to be defined before next_word
+#include "../../src/segmentation.c++"
+#endif
+
+namespace libuni {
 
   /** Sets word_begin/word_end to the beginning/end of the next word. Returns false on EOS.
    * Usage:
@@ -53,6 +66,7 @@ namespace libuni {
       return false;
     }
     word_begin = word_end;
+    LIBUNI_STATS_COUNT(words);
     unsigned s = helper::get_word_breaks(*word_end);
 
     for(;;) {
@@ -129,6 +143,129 @@ namespace libuni {
       }
     }
   }
+
+  namespace helper {
+    /** Returns true if there is a word boundary between two code points with the word break
+     * properties prev and cur regardless of their context.  A false result only means the
+     * boundary can't be decided locally (e.g., WB4 or the WB6/7 look ahead/behind).
+     */
+    inline
+    bool
+    is_word_boundary(unsigned prev, unsigned cur) {
+      using namespace break_property;
+
+      if(prev == CR and cur == LF) { // WB3
+        return false;
+      }
+      else if( (prev == CR or prev == LF or prev == Newline) or // WB3a
+               (cur == CR or cur == LF or cur == Newline) ) { // WB3b
+        return true;
+      }
+      else if(cur == Extend or cur == Format) { // WB4
+        return false;
+      }
+      else if(cur == None) { // no rule joins anything with None on the right side (WB14)
+        return true;
+      }
+      else if(prev == Extend or prev == Format) { // WB4: depends on what precedes the Extend/Format
+        return false;
+      }
+      else if(prev == None) { // (WB14)
+        return true;
+      }
+      else if( (prev == ALetter and (cur == ALetter or cur == MidLetter or cur == MidNumLet or cur == Numeric)) or // WB5/6/9
+               ((prev == MidLetter or prev == MidNumLet) and cur == ALetter) or // WB7
+               (prev == Numeric and (cur == Numeric or cur == ALetter or cur == MidNum or cur == MidNumLet)) or // WB8/10/12
+               ((prev == MidNum or prev == MidNumLet) and cur == Numeric) or // WB11
+               (prev == Katakana and cur == Katakana) or // WB13
+               ((prev == ALetter or prev == Numeric or prev == Katakana or prev == ExtendNumLet) and cur == ExtendNumLet) or // WB13a
+               (prev == ExtendNumLet and (cur == ALetter or cur == Numeric or cur == Katakana)) ) { // WB13b
+        return false;
+      }
+      else { // WB14
+        return true;
+      }
+    }
+
+    /** Returns the last position at or before pos where a word boundary is guaranteed (or begin).
+     * Segmentation with next_word can be restarted from there and yields the same words as
+     * segmenting from begin.  The scan only covers the word containing pos and a bounded
+     * amount of context.
+     */
+    template<typename I>
+    I
+    word_restart_point(I begin, I pos) {
+      if(pos == begin) {
+        return begin;
+      }
+      unsigned cur = helper::get_word_breaks(*pos);
+      for(std::size_t distance = 1;; ++distance) {
+        I prev = pos;
+        --prev;
+        unsigned const p = helper::get_word_breaks(*prev);
+        if(is_word_boundary(p, cur)) {
+          LIBUNI_STATS_RECORD(word_restart_distance, distance);
+          return pos;
+        }
+        pos = prev;
+        if(pos == begin) {
+          LIBUNI_STATS_RECORD(word_restart_distance, distance);
+          return begin;
+        }
+        cur = p;
+      }
+    }
+  }
+
+  /** Sets word_begin/word_end to the beginning/end of the word preceding word_begin. Returns false if
+   * word_begin is begin.  Only the previous word (plus a little context) is segmented.
+   * Usage:
+   *   iterator word_begin = str.end();
+   *   iterator word_end;
+   *   iterator const begin = str.begin();
+   *   while(previous_word(word_begin, word_end, begin)) {
+   *     word = (word_begin, word_end);
+   *   }
+   */
+  template<typename I>
+  bool
+  previous_word(I &word_begin, I &word_end, I begin) {
+    if(word_begin == begin) {
+      return false;
+    }
+    I const end = word_begin; // is a word boundary and therefore a valid end of string
+    I last = word_begin;
+    --last;
+    word_end = helper::word_restart_point(begin, last);
+    while(next_word(word_begin, word_end, end) and word_end != end) {
+    }
+    return true;
+  }
+
+  /** Sets word_begin/word_end to the beginning/end of the word containing pos. Returns false if pos is end.
+   * Segmentation restarts close to pos and therefore does not depend on the distance from begin.
+   * Usage:
+   *   iterator word_begin, word_end;
+   *   if(word_at(word_begin, word_end, str.begin(), str.begin() + offset, str.end())) {
+   *     word = (word_begin, word_end);
+   *   }
+   */
+  template<typename I>
+  bool
+  word_at(I &word_begin, I &word_end, I begin, I pos, I end) {
+    if(pos == end) {
+      return false;
+    }
+    word_end = helper::word_restart_point(begin, pos);
+    while(next_word(word_begin, word_end, end)) {
+      for(I i = word_begin; i != word_end; ++i) {
+        if(i == pos) {
+          return true;
+        }
+      }
+    }
+    return false; // not reached if begin <= pos < end
+  }
 }
 
 #endif
@@ -0,0 +1,153 @@
+/** simd.hpp --- vectorized kernels selected at runtime
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The library is built for the baseline of the target architecture.  The bulk kernels below exist
+ * in several versions (SSE4.2, AVX2, AVX-512BW on x86) and the best one the CPU supports is
+ * selected the first time a kernel is used.  Set the environment variable LIBUNI_SIMD to
+ * "portable", "sse4.2", "avx2" or "avx512" to force a level (e.g., for testing or benchmarking).
+ * Levels the CPU does not support are ignored with a warning.
+ *
+ * The templates (utf8::is_wellformed, utf8_to_utf32, isNFC, ...) call these kernels when the input
+ * is contiguous UTF-8, i.e., pointers to bytes or iterators of std::string/std::vector<char>.
+ * to_lower_inplace/to_upper_inplace (see case.hpp) use ascii_to_lower/ascii_to_upper.
+ *
+ * set_level() is not thread-safe: call it during initialization before any other thread uses libuni.
+ */
+#ifndef LIBUNI_SIMD_HPP
+#define LIBUNI_SIMD_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace libuni {
+  typedef unsigned char char8_t; // see utf8.hpp
+
+  namespace simd {
+    enum level {
+      portable,
+      sse42,
+      avx2,
+      avx512,
+      levels
+    };
+
+    /// Returns the best level the CPU supports.
+    LIBUNI_LINKAGE
+    level
+    detected_level();
+
+    /// Returns the level of the kernels in use.
+    LIBUNI_LINKAGE
+    level
+    active_level();
+
+    /// Uses the kernels of level l.  Returns false (and changes nothing) if the CPU does not support l.
+    LIBUNI_LINKAGE
+    bool
+    set_level(level l);
+
+    /// Returns the name of l as used by LIBUNI_SIMD.
+    LIBUNI_LINKAGE
+    char const*
+    level_name(level l);
+
+    /// Parses a level name.  Returns false if name is unknown.
+    LIBUNI_LINKAGE
+    bool
+    parse_level(char const *name, level &l);
+
+    /// Returns the length of the ASCII prefix of [p, p + n).
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_prefix(char8_t const *p, std::size_t n);
+
+    /// Maps the ASCII prefix of [p, p + n) to lowercase in place and returns its length.
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_lower(char8_t *p, std::size_t n);
+
+    /// Maps the ASCII prefix of [p, p + n) to uppercase in place and returns its length.
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_upper(char8_t *p, std::size_t n);
+
+    /// Same as utf8::is_wellformed.
+    LIBUNI_LINKAGE
+    bool
+    utf8_is_wellformed(char8_t const *p, std::size_t n);
+
+    /** Decodes [p, p + n) into out (which needs room for n code points) and returns the number of
+     * code points.  Stops at the first invalid or incomplete sequence like utf8::next_codepoint.
+     */
+    LIBUNI_LINKAGE
+    std::size_t
+    utf8_to_utf32(char8_t const *p, std::size_t n, codepoint_t *out);
+
+    namespace helper {
+      template<typename P>
+      struct byte_pointer_type : std::integral_constant<bool,
+        std::is_same<P, char const*>::value or std::is_same<P, char*>::value or
+        std::is_same<P, char8_t const*>::value or std::is_same<P, char8_t*>::value>
+      { };
+
+      /// Tells whether I iterates over contiguous bytes the kernels can work on.
+      template<typename I>
+      struct contiguous_bytes : std::integral_constant<bool,
+        byte_pointer_type<I>::value or
+        std::is_same<I, std::string::const_iterator>::value or std::is_same<I, std::string::iterator>::value or
+        std::is_same<I, std::vector<char>::const_iterator>::value or std::is_same<I, std::vector<char>::iterator>::value or
+        std::is_same<I, std::vector<char8_t>::const_iterator>::value or
+        std::is_same<I, std::vector<char8_t>::iterator>::value>
+      { };
+
+#ifdef __GLIBCXX__
+      /** Iterators of std::basic_string and std::vector with any allocator.  This relies on the
+       * libstdc++ internal __normal_iterator: with other standard libraries the iterators of
+       * containers with custom allocators are not recognized and take the scalar path.
+       */
+      template<typename P, typename Container>
+      struct contiguous_bytes<__gnu_cxx::__normal_iterator<P, Container>> : byte_pointer_type<P>
+      { };
+#endif
+
+      /// Returns a pointer to the byte i points to (i has to be dereferenceable).
+      template<typename I>
+      char8_t const*
+      byte_pointer(I i) {
+        return reinterpret_cast<char8_t const*>(&*i);
+      }
+
+      /// Advances i over ASCII bytes if I is contiguous.  Returns true if i was moved.
+      template<typename I>
+      bool
+      skip_ascii(I &i, I end, std::true_type) {
+        if(i == end or (*i & 0x80)) {
+          return false;
+        }
+        i += ascii_prefix(byte_pointer(i), end - i);
+        return true;
+      }
+
+      template<typename I>
+      bool
+      skip_ascii(I&, I, std::false_type) {
+        return false;
+      }
+    }
+  }
+}
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/simd.c++"
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/** stats.hpp --- optional counters for the hot paths of libuni
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Define LIBUNI_STATS before including any libuni header (or configure with -DLIBUNI_STATS=ON) to
+ * count what the algorithms do, e.g., how often toNFD can return its input unchanged.  Without
+ * LIBUNI_STATS the LIBUNI_STATS_* macros expand to nothing and nothing is counted.  Most of libuni
+ * are templates, so the define matters for the code including the headers, not for the library.
+ *
+ * Every thread counts into its own block without synchronization.  get() sums the blocks of all
+ * threads (including threads that have exited), get_thread() only returns the calling thread's.
+ * reset() does not write the blocks of other threads, it remembers their current counts and get()
+ * subtracts them, so a count made concurrently with reset() is counted before or after it.
+ *
+ * Histograms use power of two buckets: bucket 0 counts the value 0, bucket b the values in
+ * [2^(b-1), 2^b).  The last bucket also counts everything larger.
+ *
+ * Usage:
+ *   libuni::stats::snapshot const s = libuni::stats::get();
+ *   double const fast = double(s.counters[libuni::stats::normalize_unchanged]) /
+ *     (s.counters[libuni::stats::normalize_unchanged] + s.counters[libuni::stats::normalize_decompose]);
+ *   libuni::stats::reset();
+ */
+#ifndef LIBUNI_STATS_HPP
+#define LIBUNI_STATS_HPP
+
+#include "config.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace libuni {
+  namespace stats {
+    enum counter {
+      quick_check_yes,     // isNFD/isNFKD/isNFC/isNFKC result
+      quick_check_maybe,
+      quick_check_no,
+      normalize_unchanged, // toNFD/... returned the input (already normalized)
+      normalize_decompose, // toNFD/... ran the full decomposition
+      reorder_swaps,       // swaps of the Canonical Ordering Algorithm
+      compositions,        // primary composites formed by the Canonical Composition Algorithm
+      case_changed,        // code points changed by toUppercase/toLowercase
+      case_unchanged,
+      words,               // words returned by next_word
+      invalid_sequence,    // ill-formed or incomplete sequence ended decoding (UTF-8/16)
+      counters
+    };
+
+    char const *const counter_names[counters] = {
+      "quick_check_yes",
+      "quick_check_maybe",
+      "quick_check_no",
+      "normalize_unchanged",
+      "normalize_decompose",
+      "reorder_swaps",
+      "compositions",
+      "case_changed",
+      "case_unchanged",
+      "words",
+      "invalid_sequence"
+    };
+
+    enum histogram {
+      decompose_stack_depth, // pending code points when a decomposition mapping is expanded
+      word_restart_distance, // code points word_restart_point scanned backwards
+      histograms
+    };
+
+    char const *const histogram_names[histograms] = {
+      "decompose_stack_depth",
+      "word_restart_distance"
+    };
+
+    std::size_t const buckets = 16;
+
+    struct snapshot {
+      std::uint64_t counters[stats::counters];
+      std::uint64_t histograms[stats::histograms][buckets];
+    };
+
+    /// Returns the sum of the counters of all threads.
+    LIBUNI_LINKAGE
+    snapshot
+    get();
+
+    /// Returns the counters of the calling thread.
+    LIBUNI_LINKAGE
+    snapshot
+    get_thread();
+
+    /// Sets the counters of all threads to zero (as seen by get and get_thread).
+    LIBUNI_LINKAGE
+    void
+    reset();
+
+    namespace helper {
+      struct thread_stats {
+        std::atomic<std::uint64_t> counters[stats::counters];
+        std::atomic<std::uint64_t> histograms[stats::histograms][buckets];
+        snapshot at_reset; // the counts at the last reset(), guarded by the mutex of the registry
+      };
+
+      /// Returns the block of the calling thread.
+      LIBUNI_LINKAGE
+      thread_stats&
+      local();
+
+      // Only the owning thread writes, so there is no need for an atomic read-modify-write.
+      inline
+      void
+      add(std::atomic<std::uint64_t> &c, std::uint64_t n) {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+
+      inline
+      void
+      count(counter c, std::uint64_t n = 1) {
+        add(local().counters[c], n);
+      }
+
+      inline
+      std::size_t
+      bucket(std::uint64_t value) {
+        std::size_t b = 0;
+        while(value and b < buckets - 1) {
+          value >>= 1;
+          ++b;
+        }
+        return b;
+      }
+
+      inline
+      void
+      record(histogram h, std::uint64_t value) {
+        add(local().histograms[h][bucket(value)], 1);
+      }
+    }
+  }
+}
+
+#ifdef LIBUNI_STATS
+#define LIBUNI_STATS_COUNT(c) ::libuni::stats::helper::count(::libuni::stats::c)
+#define LIBUNI_STATS_RECORD(h, value) ::libuni::stats::helper::record(::libuni::stats::h, (value))
+#else
+#define LIBUNI_STATS_COUNT(c) ((void)0)
+#define LIBUNI_STATS_RECORD(h, value) ((void)0)
+#endif
+
+#ifdef LIBUNI_HEADER_ONLY
+#include "../../src/stats.c++"
+#endif
+
+#endif
@@ -13,11 +13,23 @@
 
 #include "codepoint.hpp"
 
+#include <type_traits>
+
 namespace libuni {
   enum utf_status { utf_ok, incomplete_sequence, invalid_sequence, end_of_string };
 
   template<typename String>
   struct utf_trait;
+
+  namespace helper {
+    /** Return type of the overloads taking a String&& which can be moved from: String is not
+     * deduced as a reference (lvalue) or const.
+     */
+    template<typename String>
+    struct enable_if_rvalue
+      : std::enable_if<not std::is_reference<String>::value and not std::is_const<String>::value, String>
+    { };
+  }
 }
 
 #endif
@@ -12,6 +12,10 @@
 #define LIBUNI_UTF16_HPP
 
 #include "utf.hpp"
+#include "stats.hpp"
+#include "codepoint_string.hpp"
+
+#include <string>
 
 namespace libuni {
   namespace utf16 {
@@ -47,15 +51,15 @@ namespace libuni {
       switch(end - i) {
       default:
       case 2:
-        if( (*i & 0xD800) == 0xD800 ) {
+        if( (*i & 0xFC00) == 0xD800 ) { // high surrogate
           I const first = i;
           ++i;
-          if( (*i & 0xDC00) != 0xDC00 ) {
+          if( (*i & 0xFC00) != 0xDC00 ) {
             i = first;
             return invalid_sequence;
           }
           cp =
-            (codepoint_t(*first & 0x3C0) + 0x10000u) +
+            ((codepoint_t(*first & 0x3C0) << 10) + 0x10000u) +
             ((*first & 0x3F) << 10) +
             (*i & 0x3FF);
         }
@@ -75,6 +79,31 @@ namespace libuni {
       return utf_ok;
     }
 
+    template<typename Cont>
+    void
+    codepoint_to_utf16(codepoint_t cp, Cont &str) {
+      if(cp <= 0xFFFF) {
+        str.push_back(cp);
+      }
+      else {
+        cp -= 0x10000;
+        str.push_back(0xD800 | (cp >> 10));
+        str.push_back(0xDC00 | (cp & 0x3FF));
+      }
+    }
+
+    inline
+    std::u16string
+    from_codepoints(codepoint_string_t const &str) {
+      std::u16string ret;
+      ret.reserve(str.size());
+      codepoint_string_t::const_iterator const end = str.cend();
+      for(auto i = str.cbegin(); i != end; ++i) {
+        codepoint_to_utf16(*i, ret);
+      }
+      return ret;
+    }
+
     //// Bytes required to represent a codepoint
     inline
     std::size_t
@@ -91,15 +120,37 @@ namespace libuni {
     }
   } // namespace utf16
 
-  template<>
-  struct utf_trait<std::u16string> {
-    typedef std::u16string string_type;
+  template<typename Traits, typename Alloc>
+  struct utf_trait<std::basic_string<char16_t, Traits, Alloc>> {
+    typedef std::basic_string<char16_t, Traits, Alloc> string_type;
 
     template<typename I>
     static
     utf_status
     next_codepoint(I &i, I end, codepoint_t &cp) {
-      return utf16::next_codepoint(i, end, cp);
+      utf_status const s = utf16::next_codepoint(i, end, cp);
+      if(s == invalid_sequence or s == incomplete_sequence) {
+        LIBUNI_STATS_COUNT(invalid_sequence);
+      }
+      return s;
+    }
+
+    template<typename Codepoints>
+    static
+    string_type
+    from_codepoints(Codepoints const &str, Alloc const &alloc = Alloc()) {
+      string_type ret(alloc);
+      ret.reserve(str.size());
+      for(auto i = str.begin(); i != str.end(); ++i) {
+        utf16::codepoint_to_utf16(*i, ret);
+      }
+      return ret;
+    }
+
+    static inline
+    void
+    append(string_type &str, codepoint_t cp) {
+      utf16::codepoint_to_utf16(cp, str);
     }
   };
 }
@@ -13,6 +13,8 @@
 
 #include "utf.hpp"
 
+#include <string>
+
 namespace libuni {
   namespace utf32 {
     template<typename I>
@@ -40,9 +42,9 @@ namespace libuni {
     }
   } // namespace utf32
 
-  template<>
-  struct utf_trait<std::u32string> {
-    typedef std::u32string string_type;
+  template<typename Traits, typename Alloc>
+  struct utf_trait<std::basic_string<char32_t, Traits, Alloc>> {
+    typedef std::basic_string<char32_t, Traits, Alloc> string_type;
 
     template<typename I>
     static
@@ -52,11 +54,18 @@ namespace libuni {
     }
 
     static inline
-    std::u32string const&
-    from_codepoints(std::u32string const &str) {
+    string_type const&
+    from_codepoints(string_type const &str) {
       return str;
     }
 
+    template<typename Codepoints>
+    static
+    string_type
+    from_codepoints(Codepoints const &str, Alloc const &alloc = Alloc()) {
+      return string_type(str.begin(), str.end(), alloc);
+    }
+
     static inline
     void
     append(string_type &s, codepoint_t cp) {
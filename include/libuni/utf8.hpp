@@ -12,6 +12,8 @@
 #define LIBUNI_UTF8_HPP
 
 #include "utf.hpp"
+#include "stats.hpp"
+#include "simd.hpp"
 #include "codepoint_string.hpp"
 
 #include <type_traits>
@@ -122,6 +124,7 @@ namespace libuni {
     }
   }
 
+  inline
   std::string
   from_codepoints(codepoint_string_t const &str) {
     std::string ret;
@@ -154,94 +157,115 @@ namespace libuni {
     }
   }
 
+  /** Returns the beginning of the first ill-formed (or incomplete) sequence in [begin, end) or end
+   * if it is well-formed.  Validates byte by byte.
+   */
   template<typename I>
-  bool is_wellformed(I begin, I end) {
+  I find_illformed(I begin, I end) {
     for(I i = begin; i != end; ++i) {
+      I const first = i;
       if(helper::is_larger_zero(*i) and *i <= 0x7F) {
       }
       else if(0xC2 <= *i and *i <= 0xDF) {
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
       else if(*i == 0xE0) {
         ++i;
         if(i == end or not (0xA0 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
-      else if( (0xE1 <= *i and *i <= 0xEC) or (0xEE < *i and *i < 0xEF) ) {
+      else if( (0xE1 <= *i and *i <= 0xEC) or (0xEE <= *i and *i <= 0xEF) ) {
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
       else if(*i == 0xED) {
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0x9F)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
       else if(*i == 0xF0) {
         ++i;
         if(i == end or not (0x90 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
-      else if(0xF1 < *i and *i < 0xF3) {
+      else if(0xF1 <= *i and *i <= 0xF3) {
         ++i;
-        if(i == end or not (0x90 <= *i and *i <= 0xBF)) {
-          return false;
+        if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
       else if(*i == 0xF4) {
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0x8F)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
         ++i;
         if(i == end or not (0x80 <= *i and *i <= 0xBF)) {
-          return false;
+          return first;
         }
       }
       else {
-        return false;
+        return first;
       }
     }
-    return true;
+    return end;
+  }
+
+  /// Byte by byte validation, used for iterators the SIMD kernels can't handle.
+  template<typename I>
+  bool is_wellformed(I begin, I end, std::false_type) {
+    return find_illformed(begin, end) == end;
+  }
+
+  /// Validation of contiguous bytes (see simd.hpp).
+  template<typename I>
+  bool is_wellformed(I begin, I end, std::true_type) {
+    return begin == end or simd::utf8_is_wellformed(simd::helper::byte_pointer(begin), end - begin);
+  }
+
+  template<typename I>
+  bool is_wellformed(I begin, I end) {
+    return is_wellformed(begin, end, simd::helper::contiguous_bytes<I>());
   }
 
   //// Bytes required to represent a codepoint
@@ -284,21 +308,33 @@ namespace libuni {
   }
   } // namespace utf8
 
-  template<>
-  struct utf_trait<std::string> { // assume std::string is UTF-8
-    typedef std::string string_type;
+  /// UTF-8 in a std::basic_string<char> with any allocator (assume std::string is UTF-8).
+  template<typename Traits, typename Alloc>
+  struct utf_trait<std::basic_string<char, Traits, Alloc>> {
+    typedef std::basic_string<char, Traits, Alloc> string_type;
 
     template<typename I>
     static
     utf_status
     next_codepoint(I &i, I end, codepoint_t &cp) {
-      return utf8::next_codepoint(i, end, cp);
+      utf_status const s = utf8::next_codepoint(i, end, cp);
+      if(s == invalid_sequence or s == incomplete_sequence) {
+        LIBUNI_STATS_COUNT(invalid_sequence);
+      }
+      return s;
     }
 
-    static inline
-    std::string
-    from_codepoints(codepoint_string_t const &str) {
-      return utf8::from_codepoints(str);
+    /// The result is allocated with alloc.
+    template<typename Codepoints>
+    static
+    string_type
+    from_codepoints(Codepoints const &str, Alloc const &alloc = Alloc()) {
+      string_type ret(alloc);
+      ret.reserve(str.size()); // TODO
+      for(auto i = str.begin(); i != str.end(); ++i) {
+        utf8::codepoint_to_utf8(*i, ret);
+      }
+      return ret;
     }
 
     static inline
@@ -307,6 +343,15 @@ namespace libuni {
       utf8::codepoint_to_utf8(cp, str);
     }
   };
+
+  namespace helper {
+    /// Tells whether UTFTrait is the UTF-8 trait (of a string with any allocator).
+    template<typename UTFTrait>
+    struct is_utf8 : std::false_type { };
+
+    template<typename Traits, typename Alloc>
+    struct is_utf8<utf_trait<std::basic_string<char, Traits, Alloc>>> : std::true_type { };
+  }
 }
 
 #endif
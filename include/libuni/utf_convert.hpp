@@ -12,16 +12,52 @@
 #include "utf16.hpp"
 #include "utf32.hpp"
 
+#include <memory>
+#include <string>
+
 namespace libuni {
+  namespace helper {
+    template<typename Alloc>
+    struct utf32_string {
+      typedef std::basic_string<char32_t, std::char_traits<char32_t>, Alloc> type;
+    };
+
+    template<typename I, typename Alloc>
+    typename utf32_string<Alloc>::type
+    utf8_to_utf32(I begin, I end, Alloc const &alloc, std::false_type) {
+      typedef utf_trait<typename utf32_string<Alloc>::type> utf32traits;
+      codepoint_t cp;
+      typename utf32_string<Alloc>::type ret(alloc);
+      while(utf8::next_codepoint(begin, end, cp) == utf_ok) {
+        utf32traits::append(ret, cp);
+      }
+      return ret;
+    }
+
+    /// Decoding of contiguous bytes (see simd.hpp).
+    template<typename I, typename Alloc>
+    typename utf32_string<Alloc>::type
+    utf8_to_utf32(I begin, I end, Alloc const &alloc, std::true_type) {
+      typename utf32_string<Alloc>::type ret(alloc);
+      if(begin != end) {
+        ret.resize(end - begin);
+        ret.resize(simd::utf8_to_utf32(simd::helper::byte_pointer(begin), end - begin,
+                                       &ret[0]));
+      }
+      return ret;
+    }
+  }
+
+  /// The result is allocated with alloc.
+  template<typename I, typename Alloc>
+  typename helper::utf32_string<Alloc>::type
+  utf8_to_utf32(I begin, I end, Alloc const &alloc) {
+    return helper::utf8_to_utf32(begin, end, alloc, simd::helper::contiguous_bytes<I>());
+  }
+
   template<typename I>
   std::u32string utf8_to_utf32(I begin, I end) {
-    typedef utf_trait<std::u32string> utf32traits;
-    codepoint_t cp;
-    std::u32string ret;
-    while(utf8::next_codepoint(begin, end, cp) == utf_ok) {
-      utf32traits::append(ret, cp);
-    }
-    return ret;
+    return helper::utf8_to_utf32(begin, end, std::allocator<char32_t>(), simd::helper::contiguous_bytes<I>());
   }
 
   inline
@@ -0,0 +1,323 @@
+/** view.hpp --- lazy views for text processing pipelines
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Chaining the string functions (e.g., next_word over toLowercase(toNFKD(s))) creates a complete
+ * intermediate string in every step.  The views below do the same work lazily: each one pulls code
+ * points from the view it wraps, so a pipeline is a single pass over the input with small fixed
+ * buffers and only the final output is allocated.
+ *
+ *   decoded(s)         the code points of s (UTF-8, UTF-16 or UTF-32, see utf_trait)
+ *   nfd(v), nfkd(v),   v normalized (see helper::normalizing_reader)
+ *   nfc(v), nfkc(v)
+ *   lowercased(v),     v with the simple case mappings applied (like toLowercase/toUppercase)
+ *   uppercased(v)
+ *   words(v[, alloc])  the words of v (like next_word) as pairs of pointers to code points
+ *   encoded<String>(v) the code points of v encoded as String
+ *
+ * Views are single pass: every view consumes the view it wraps and begin() starts the iteration.
+ * A view of a string refers to it, the string has to outlive the view.  The pointers of a word are
+ * only valid until the next word is read.
+ *
+ * Usage:
+ *   std::string const out = view::encoded<std::string>(view::lowercased(view::nfkd(view::decoded(s))));
+ *   auto w = view::words(view::lowercased(view::nfkd(view::decoded(s))));
+ *   for(auto i = w.begin(); i != w.end(); ++i) {
+ *     codepoint_string_t const word(i->first, i->second);
+ *   }
+ */
+#ifndef LIBUNI_VIEW_HPP
+#define LIBUNI_VIEW_HPP
+
+#include "config.hpp"
+#include "codepoint.hpp"
+#include "codepoint_string.hpp"
+#include "utf.hpp"
+#include "normalization.hpp"
+#include "case.hpp"
+#include "segmentation.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace libuni {
+  namespace view {
+    /// Input iterator over the values View::next returns.
+    template<typename View, typename Value>
+    class iterator : public std::iterator<std::input_iterator_tag, Value> {
+      View *view; // 0 at the end
+      Value value;
+
+    public:
+      iterator()
+        : view(0x0), value()
+      { }
+
+      explicit iterator(View &v)
+        : view(&v), value()
+      {
+        ++*this;
+      }
+
+      Value const &
+      operator*() const {
+        return value;
+      }
+
+      Value const *
+      operator->() const {
+        return &value;
+      }
+
+      iterator &
+      operator++() {
+        if(not view->next(value)) {
+          view = 0x0;
+        }
+        return *this;
+      }
+
+      iterator
+      operator++(int) {
+        iterator const tmp = *this;
+        ++*this;
+        return tmp;
+      }
+
+      bool
+      operator==(iterator const &rhs) const {
+        return view == rhs.view;
+      }
+
+      bool
+      operator!=(iterator const &rhs) const {
+        return view != rhs.view;
+      }
+    };
+
+    /// Provides begin() and end() for a view with a bool next(Value&) member.
+    template<typename View, typename Value = codepoint_t>
+    struct range {
+      typedef view::iterator<View, Value> iterator;
+
+      iterator
+      begin() {
+        return iterator(static_cast<View&>(*this));
+      }
+
+      iterator
+      end() {
+        return iterator();
+      }
+    };
+
+    template<typename I, typename UTFTrait>
+    class decoded_view : public range<decoded_view<I, UTFTrait>> {
+      libuni::helper::decoder<I, UTFTrait> decoder;
+
+    public:
+      decoded_view(I begin, I end)
+        : decoder(begin, end)
+      { }
+
+      bool
+      next(codepoint_t &cp) {
+        return decoder.next(cp);
+      }
+    };
+
+    template<typename String, typename UTFTrait = utf_trait<String>>
+    decoded_view<typename String::const_iterator, UTFTrait>
+    decoded(String const &in) {
+      return decoded_view<typename String::const_iterator, UTFTrait>(in.begin(), in.end());
+    }
+
+    template<typename Source, bool Kompatibility, bool Compose>
+    class normalized_view : public range<normalized_view<Source, Kompatibility, Compose>> {
+      libuni::helper::normalizing_reader<Source, Kompatibility, Compose> reader;
+
+    public:
+      explicit normalized_view(Source const &source)
+        : reader(source)
+      { }
+
+      bool
+      next(codepoint_t &cp) {
+        return reader.next(cp);
+      }
+    };
+
+    template<typename Source>
+    normalized_view<Source, false, false>
+    nfd(Source const &source) {
+      return normalized_view<Source, false, false>(source);
+    }
+
+    template<typename Source>
+    normalized_view<Source, true, false>
+    nfkd(Source const &source) {
+      return normalized_view<Source, true, false>(source);
+    }
+
+    template<typename Source>
+    normalized_view<Source, false, true>
+    nfc(Source const &source) {
+      return normalized_view<Source, false, true>(source);
+    }
+
+    template<typename Source>
+    normalized_view<Source, true, true>
+    nfkc(Source const &source) {
+      return normalized_view<Source, true, true>(source);
+    }
+
+    namespace helper {
+      struct lowercase {
+        static
+        codepoint_t
+        map(codepoint_t cp) {
+          return lowercase_mapping(cp);
+        }
+      };
+
+      struct uppercase {
+        static
+        codepoint_t
+        map(codepoint_t cp) {
+          return uppercase_mapping(cp);
+        }
+      };
+    }
+
+    /// Applies Mapping::map to every code point of Source.
+    template<typename Source, typename Mapping>
+    class mapped_view : public range<mapped_view<Source, Mapping>> {
+      Source source;
+
+    public:
+      explicit mapped_view(Source const &source)
+        : source(source)
+      { }
+
+      bool
+      next(codepoint_t &cp) {
+        if(not source.next(cp)) {
+          return false;
+        }
+        cp = Mapping::map(cp);
+        return true;
+      }
+    };
+
+    template<typename Source>
+    mapped_view<Source, helper::lowercase>
+    lowercased(Source const &source) {
+      return mapped_view<Source, helper::lowercase>(source);
+    }
+
+    template<typename Source>
+    mapped_view<Source, helper::uppercase>
+    uppercased(Source const &source) {
+      return mapped_view<Source, helper::uppercase>(source);
+    }
+
+    typedef std::pair<codepoint_t const*, codepoint_t const*> word_t;
+
+    /** The words of Source as found by next_word.  Code points are read in blocks into a buffer
+     * (allocated with Alloc) which holds the current word and what next_word needs to look ahead.
+     */
+    template<typename Source, typename Alloc = std::allocator<codepoint_t>>
+    class words_view : public range<words_view<Source, Alloc>, word_t> {
+      Source source;
+      std::basic_string<codepoint_t, std::char_traits<codepoint_t>, Alloc> buffer;
+      std::size_t word_begin; // of the next word in buffer
+      bool eos;
+
+      static std::size_t const block = 64;
+
+      /** Tells whether the boundary at word_end is final, i.e., does not depend on code points not
+       * yet read.  next_word looks ahead over Extend and Format to the next other code point.
+       */
+      static
+      bool
+      is_final(codepoint_t const *word_end, codepoint_t const *end) {
+        using namespace break_property;
+        if(word_end == end) {
+          return false;
+        }
+        for(codepoint_t const *i = word_end + 1; i < end; ++i) {
+          unsigned const p = libuni::helper::get_word_breaks(*i);
+          if(p != Extend and p != Format) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+    public:
+      explicit words_view(Source const &source, Alloc const &alloc = Alloc())
+        : source(source), buffer(alloc), word_begin(0), eos(false)
+      { }
+
+      bool
+      next(word_t &word) {
+        for(;;) {
+          codepoint_t const *const begin = buffer.data();
+          codepoint_t const *const end = begin + buffer.size();
+          codepoint_t const *wb, *we = begin + word_begin;
+          if(next_word(wb, we, end) and (eos or is_final(we, end))) {
+            word = word_t(wb, we);
+            word_begin = we - begin;
+            return true;
+          }
+          else if(eos) {
+            return false;
+          }
+          // read more (keeping the current word)
+          buffer.erase(0, word_begin);
+          word_begin = 0;
+          codepoint_t cp;
+          for(std::size_t n = 0; n < block; ++n) {
+            if(not source.next(cp)) {
+              eos = true;
+              break;
+            }
+            buffer.push_back(cp);
+          }
+        }
+      }
+    };
+
+    template<typename Source>
+    words_view<Source>
+    words(Source const &source) {
+      return words_view<Source>(source);
+    }
+
+    template<typename Source, typename Alloc>
+    words_view<Source, Alloc>
+    words(Source const &source, Alloc const &alloc) {
+      return words_view<Source, Alloc>(source, alloc);
+    }
+
+    /// Encodes the code points of source as String.
+    template<typename String, typename UTFTrait = utf_trait<String>, typename Source>
+    String
+    encoded(Source source) {
+      String ret;
+      codepoint_t cp;
+      while(source.next(cp)) {
+        UTFTrait::append(ret, cp);
+      }
+      return ret;
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include <libuni/cache.hpp>
+#include <libuni/hash.hpp>
+
+#include <cstring>
+
+namespace libuni { namespace helper {
+  namespace caching {
+    /// Index of the first slot of the set of tag.
+    inline
+    std::size_t
+    set_of(cache_shard const &shard, std::uint64_t tag) {
+      return ((tag >> 3) & shard.set_mask) * cache_ways;
+    }
+
+    /// Writes key and value to the words of slot.
+    inline
+    void
+    store(cache_slot &slot, char const *key, std::size_t n, std::string const &value) {
+      char buffer[cache_slot_words * 8] = { };
+      std::memcpy(buffer, key, n);
+      std::memcpy(buffer + n, value.data(), value.size());
+      for(std::size_t w = 0; w < (n + value.size() + 7) / 8; ++w) {
+        std::uint64_t word;
+        std::memcpy(&word, buffer + 8 * w, 8);
+        slot.data[w].store(word, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  std::size_t
+  cache_stripe() {
+    static std::atomic<std::size_t> next(0);
+    static thread_local std::size_t const stripe = next.fetch_add(1, std::memory_order_relaxed) % cache_stripes;
+    return stripe;
+  }
+
+  std::uint64_t
+  cache_tag(char const *key, std::size_t n, cache_operation op) {
+    hash_state s;
+    hash_bytes(s, reinterpret_cast<char8_t const*>(key), n);
+    return (std::uint64_t(hash_final(s)) & ~std::uint64_t(7)) | (op + 1); // the low bits are never 0
+  }
+
+  bool
+  cache_find(cache_shard &shard, std::uint64_t tag, char const *key, std::size_t n, std::string &value) {
+    std::size_t const set = caching::set_of(shard, tag);
+    for(std::size_t way = 0; way < cache_ways; ++way) {
+      if(shard.tags[set + way].load(std::memory_order_relaxed) != tag) {
+        continue;
+      }
+      cache_slot &slot = shard.slots[set + way];
+      for(;;) { // seqlock read
+        std::uint64_t const version = slot.version.load(std::memory_order_acquire);
+        if(version & 1) { // an insert is writing the slot: don't wait for it
+          return false;
+        }
+        std::uint64_t const t = slot.tag.load(std::memory_order_relaxed);
+        std::uint32_t const sizes = slot.sizes.load(std::memory_order_relaxed);
+        std::size_t const key_size = sizes >> 8;
+        std::size_t const value_size = sizes & 0xFF;
+        std::uint64_t words[cache_slot_words];
+        std::size_t const used = t == tag ? (key_size + value_size + 7) / 8 : 0;
+        for(std::size_t w = 0; w < used and w < cache_slot_words; ++w) {
+          words[w] = slot.data[w].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(slot.version.load(std::memory_order_relaxed) != version) {
+          continue; // changed while copying
+        }
+        else if(t != tag or key_size != n) {
+          break;
+        }
+        char const *const bytes = reinterpret_cast<char const*>(words);
+        if(std::memcmp(bytes, key, n) != 0) {
+          break;
+        }
+        value.assign(bytes + n, value_size);
+        if(not slot.referenced.load(std::memory_order_relaxed)) { // don't write the line on every hit
+          slot.referenced.store(true, std::memory_order_relaxed);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool
+  cache_insert(cache_shard &shard, std::uint64_t tag, char const *key, std::size_t n, std::string const &value) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::size_t const first = caching::set_of(shard, tag);
+    cache_slot *const set = &shard.slots[first];
+    std::uint8_t &hand = shard.hand[first / cache_ways];
+    cache_slot *victim = 0x0;
+    bool evicted = false;
+    for(std::size_t way = 0; way < cache_ways and not victim; ++way) { // the same key (inserted by another thread) or an empty slot
+      std::uint64_t const t = shard.tags[first + way].load(std::memory_order_relaxed);
+      if(t == tag or t == 0) {
+        victim = &set[way];
+      }
+    }
+    if(not victim) { // CLOCK
+      while(set[hand].referenced.load(std::memory_order_relaxed)) {
+        set[hand].referenced.store(false, std::memory_order_relaxed);
+        hand = (hand + 1) % cache_ways;
+      }
+      victim = &set[hand];
+      hand = (hand + 1) % cache_ways;
+      evicted = true;
+    }
+
+    std::uint64_t const version = victim->version.load(std::memory_order_relaxed);
+    victim->version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    victim->tag.store(tag, std::memory_order_relaxed);
+    victim->sizes.store(std::uint32_t(n << 8 | value.size()), std::memory_order_relaxed);
+    victim->referenced.store(false, std::memory_order_relaxed);
+    caching::store(*victim, key, n, value);
+    victim->version.store(version + 2, std::memory_order_release);
+    shard.tags[victim - &shard.slots[0]].store(tag, std::memory_order_relaxed);
+    return evicted;
+  }
+
+  void
+  cache_clear(cache_shard &shard) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for(std::size_t i = 0; i < (shard.set_mask + 1) * cache_ways; ++i) {
+      cache_slot &slot = shard.slots[i];
+      std::uint64_t const version = slot.version.load(std::memory_order_relaxed);
+      slot.version.store(version + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.tag.store(0, std::memory_order_relaxed);
+      slot.version.store(version + 2, std::memory_order_release);
+      shard.tags[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}}
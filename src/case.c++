@@ -1,39 +1,90 @@
 #include <libuni/case.hpp>
-#include "generated/case_database.hpp"
+#include <libuni/simd.hpp>
+#include "database.hpp"
+
+#include <cstring>
 
 namespace libuni {
   codepoint_t
   uppercase_mapping(codepoint_t cp) {
-    std::size_t const index = simple_uppercase_mapping_index[cp >> simple_uppercase_mapping_shift];
-    codepoint_t const r = simple_uppercase_mapping[(index << simple_uppercase_mapping_shift) + (cp & ( (1 << simple_uppercase_mapping_shift) - 1))];
+    codepoint_t const r = helper::database::active.simple_uppercase_mapping.lookup(cp);
     return r == 0 ? cp : r;
   }
 
   bool
   helper::is_uppercase(codepoint_t cp) {
-    std::size_t const index = simple_uppercase_mapping_index[cp >> simple_uppercase_mapping_shift];
-    codepoint_t const r = simple_uppercase_mapping[(index << simple_uppercase_mapping_shift) + (cp & ( (1 << simple_uppercase_mapping_shift) - 1))];
+    codepoint_t const r = helper::database::active.simple_uppercase_mapping.lookup(cp);
     return r == 0;
   }
 
   codepoint_t
   lowercase_mapping(codepoint_t cp) {
-    std::size_t const index = simple_lowercase_mapping_index[cp >> simple_lowercase_mapping_shift];
-    codepoint_t const r = simple_lowercase_mapping[(index << simple_lowercase_mapping_shift) + (cp & ( (1 << simple_lowercase_mapping_shift) - 1))];
+    codepoint_t const r = helper::database::active.simple_lowercase_mapping.lookup(cp);
     return r == 0 ? cp : r;
   }
 
   bool
   helper::is_lowercase(codepoint_t cp) {
-    std::size_t const index = simple_lowercase_mapping_index[cp >> simple_lowercase_mapping_shift];
-    codepoint_t const r = simple_lowercase_mapping[(index << simple_lowercase_mapping_shift) + (cp & ( (1 << simple_lowercase_mapping_shift) - 1))];
+    codepoint_t const r = helper::database::active.simple_lowercase_mapping.lookup(cp);
     return r == 0;
   }
 
+  namespace helper { namespace case_mapping {
+    /// The UTF-8 encoding of a code point.
+    struct encoded {
+      char8_t bytes[4];
+      std::size_t size;
+
+      encoded()
+        : size(0)
+      { }
+
+      void
+      push_back(char8_t c) {
+        bytes[size++] = c;
+      }
+    };
+  }}
+
+  std::size_t
+  helper::xcase_inplace(char8_t *p, std::size_t n, bool upper) {
+    std::size_t i = 0;
+    while(i < n) {
+      if(p[i] < 0x80) {
+        if(i + 1 < n and p[i + 1] < 0x80) { // a run: call the kernel
+          i += upper ? simd::ascii_to_upper(p + i, n - i) : simd::ascii_to_lower(p + i, n - i);
+        }
+        else { // e.g., a space between words
+          if(char8_t(p[i] - (upper ? 'a' : 'A')) < 26) {
+            p[i] ^= 0x20;
+          }
+          ++i;
+        }
+        continue;
+      }
+      char8_t const *next = p + i;
+      codepoint_t cp;
+      if(utf8::next_codepoint(next, const_cast<char8_t const*>(p + n), cp) != utf_ok) {
+        return i;
+      }
+      std::size_t const size = next - (p + i);
+      codepoint_t const mapped = upper ? uppercase_mapping(cp) : lowercase_mapping(cp);
+      if(mapped != cp) {
+        case_mapping::encoded e;
+        utf8::codepoint_to_utf8(mapped, e);
+        if(e.size != size) {
+          return i;
+        }
+        std::memcpy(p + i, e.bytes, size);
+      }
+      i += size;
+    }
+    return i;
+  }
+
   codepoint_t
   titlecase_mapping(codepoint_t cp) {
-    std::size_t const index = simple_titlecase_mapping_index[cp >> simple_titlecase_mapping_shift];
-    codepoint_t const r = simple_titlecase_mapping[(index << simple_titlecase_mapping_shift) + (cp & ( (1 << simple_titlecase_mapping_shift) - 1))];
+    codepoint_t const r = helper::database::active.simple_titlecase_mapping.lookup(cp);
     return r == 0 ? uppercase_mapping(cp) : r;
   }
 }
@@ -0,0 +1,333 @@
+#include <libuni/collation.hpp>
+#include "database.hpp"
+#include "data_format.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace libuni {
+  namespace collation {
+    char const*
+    version() {
+      return helper::database::active.collation_version;
+    }
+  }
+
+namespace helper {
+  namespace uca {
+    namespace format = data_format::collation;
+
+    std::uint32_t const common_secondary = 0x20;
+    std::uint32_t const common_tertiary = 0x02;
+
+    inline
+    std::uint32_t
+    make_element(std::uint32_t primary, std::uint32_t secondary, std::uint32_t tertiary) {
+      return primary << format::primary_shift | secondary << format::secondary_shift | tertiary << format::tertiary_shift;
+    }
+
+    /// Appends the collation elements of ref (offset and count, see data_format.hpp) to ces.
+    inline
+    void
+    append_elements(std::uint32_t ref, std::vector<std::uint32_t> &ces) {
+      std::size_t const offset = ref >> format::offset_shift;
+      std::size_t const count = ref & format::count_mask;
+      assert(offset + count <= database::active.collation_elements_size);
+      std::uint32_t const *const elements = database::active.collation_elements + offset;
+      if(count == 1) { // the common case, much cheaper than the range insert
+        ces.push_back(*elements);
+      }
+      else {
+        ces.insert(ces.end(), elements, elements + count);
+      }
+    }
+
+    /// Appends the implicit weights (UCA 10.1) of cp.  base is 0 for unassigned code points.
+    inline
+    void
+    append_implicit(codepoint_t cp, std::uint32_t base, std::vector<std::uint32_t> &ces) {
+      std::uint32_t aaaa, bbbb;
+      if(base == 0 or base >= 0xFB40) { // Han and unassigned
+        aaaa = (base ? base : 0xFBC0) + (cp >> 15);
+        bbbb = (cp & 0x7FFF) | 0x8000;
+      }
+      else { // @implicitweights (Tangut, Nushu, ...)
+        codepoint_t origin = cp;
+        for(std::size_t i = 0; i + 1 < database::active.collation_implicit_size; i += 2) {
+          if(database::active.collation_implicit[i] == base) {
+            origin = database::active.collation_implicit[i + 1];
+            break;
+          }
+        }
+        aaaa = base;
+        bbbb = ((cp - origin) & 0x7FFF) | 0x8000;
+      }
+      ces.push_back(make_element(aaaa, common_secondary, common_tertiary));
+      ces.push_back(make_element(bbbb, 0, 0));
+    }
+
+    /// Returns the reference to the collation elements of the contraction [cps, cps + n) or 0.
+    inline
+    std::uint32_t
+    find_contraction(codepoint_t const *cps, std::size_t n) {
+      codepoint_t key[format::contraction_length] = { };
+      std::copy(cps, cps + n, key);
+      std::uint32_t const *const begin = database::active.collation_contractions;
+      std::size_t lo = 0, hi = database::active.collation_contractions_size / format::contraction_size;
+      while(lo < hi) {
+        std::size_t const mid = (lo + hi) / 2;
+        std::uint32_t const *const record = begin + mid * format::contraction_size;
+        if(std::lexicographical_compare(record, record + format::contraction_length,
+                                        key, key + format::contraction_length)) {
+          lo = mid + 1;
+        }
+        else {
+          hi = mid;
+        }
+      }
+      std::uint32_t const *const record = begin + lo * format::contraction_size;
+      if(lo * format::contraction_size < database::active.collation_contractions_size and
+         std::equal(key, key + format::contraction_length, record)) {
+        return record[format::contraction_length];
+      }
+      return 0;
+    }
+
+    inline
+    std::uint8_t
+    canonical_class(codepoint_t cp) {
+      return get_canonical_class(get_quick_check(cp));
+    }
+
+    /// Produces the collation elements of cps (UCA S2).  Removes code points matched by discontiguous contractions.
+    inline
+    void
+    collation_elements(codepoint_string_t &cps, std::vector<std::uint32_t> &ces) {
+      ces.reserve(cps.size());
+      for(std::size_t i = 0; i < cps.size();) {
+        codepoint_t const cp = cps[i];
+        if(cp < format::ascii_size and database::active.collation_ascii[cp]) { // no trie, no contractions
+          ces.push_back(database::active.collation_ascii[cp]);
+          ++i;
+          continue;
+        }
+        std::uint32_t ref = database::active.collation_index.lookup(cp);
+        std::size_t len = 1;
+        if(ref & format::has_contractions) {
+          ref &= ~format::has_contractions;
+          // S2.1.1 longest contiguous match
+          for(std::size_t n = std::min(format::contraction_length, cps.size() - i); n > 1; --n) {
+            if(std::uint32_t const r = find_contraction(&cps[i], n)) {
+              ref = r;
+              len = n;
+              break;
+            }
+          }
+          // S2.1.2 extend the match by unblocked non-starters
+          codepoint_t match[format::contraction_length];
+          std::copy(&cps[i], &cps[i] + len, match);
+          std::size_t matched = len;
+          std::uint8_t skipped = 0; // canonical class of the last non-starter not in the match
+          for(std::size_t j = i + len; j < cps.size() and matched < format::contraction_length;) {
+            std::uint8_t const ccc = canonical_class(cps[j]);
+            if(ccc == 0) {
+              break;
+            }
+            else if(skipped < ccc) {
+              match[matched] = cps[j];
+              if(std::uint32_t const r = find_contraction(match, matched + 1)) {
+                ref = r;
+                ++matched;
+                cps.erase(cps.begin() + j);
+                continue;
+              }
+            }
+            skipped = ccc;
+            ++j;
+          }
+        }
+
+        if(ref & format::count_mask) {
+          append_elements(ref, ces);
+        }
+        else {
+          append_implicit(cp, ref >> format::offset_shift, ces);
+        }
+        i += len;
+      }
+    }
+
+    /// Writes a key to a buffer which may be too small (the length is counted anyway).
+    struct key_writer {
+      unsigned char *out;
+      std::size_t size;
+      std::size_t length;
+
+      void
+      put8(std::uint32_t weight) {
+        if(length < size) {
+          out[length] = weight;
+        }
+        ++length;
+      }
+
+      void
+      put16(std::uint32_t weight) {
+        put8(weight >> 8);
+        put8(weight & 0xFF);
+      }
+    };
+
+    /// Writes a key to a buffer of at least max_key_length bytes.
+    struct unchecked_key_writer {
+      unsigned char *begin;
+      unsigned char *out;
+
+      void
+      put8(std::uint32_t weight) {
+        *out++ = weight;
+      }
+
+      void
+      put16(std::uint32_t weight) {
+        out[0] = weight >> 8;
+        out[1] = weight & 0xFF;
+        out += 2;
+      }
+
+      std::size_t
+      length() const {
+        return out - begin;
+      }
+    };
+
+    /// The collation elements of a string and its quaternary weights (with shifted).
+    struct key_elements {
+      std::vector<std::uint32_t> ces;
+      std::vector<std::uint16_t> quaternary;
+      std::vector<unsigned char> key; // returned by sort_key(cps, length, opt)
+    };
+
+    /// Returns the scratch buffers of sort_key (one per thread).
+    inline
+    key_elements&
+    scratch() {
+      static thread_local key_elements e;
+      return e;
+    }
+
+    /// Produces the collation elements of cps (UCA S2) and applies the variable weighting (S3 for shifted).
+    inline
+    void
+    prepare(codepoint_string_t &cps, collation::options const &opt, key_elements &e) {
+      e.ces.clear();
+      collation_elements(cps, e.ces);
+      if(opt.variable != collation::shifted) {
+        return;
+      }
+      // UCA 4.3 Table 11
+      std::vector<std::uint32_t> &ces = e.ces;
+      e.quaternary.resize(ces.size());
+      bool after_variable = false;
+      for(std::size_t i = 0; i < ces.size(); ++i) {
+        std::uint32_t const primary = ces[i] >> format::primary_shift;
+        if(ces[i] == 0) { // completely ignorable
+          e.quaternary[i] = 0;
+        }
+        else if(ces[i] & format::variable) {
+          e.quaternary[i] = primary;
+          ces[i] = 0;
+          after_variable = true;
+        }
+        else if(primary == 0 and after_variable) {
+          e.quaternary[i] = 0;
+          ces[i] = 0;
+        }
+        else {
+          e.quaternary[i] = 0xFFFF;
+          if(primary != 0) {
+            after_variable = false;
+          }
+        }
+      }
+    }
+
+    /// Returns an upper bound of the key length of e (7 bytes per element and the level separators).
+    inline
+    std::size_t
+    max_key_length(key_elements const &e) {
+      return e.ces.size() * 7 + 5;
+    }
+
+    /// Writes the sort key of the prepared elements e (UCA S3 and S4) with Writer (see above).
+    template<typename Writer>
+    void
+    write_key(key_elements const &e, collation::options const &opt, Writer &key) {
+      std::vector<std::uint32_t> const &ces = e.ces;
+      for(std::size_t i = 0; i < ces.size(); ++i) {
+        if(std::uint32_t const primary = ces[i] >> format::primary_shift) {
+          key.put16(primary);
+        }
+      }
+      if(opt.level >= collation::secondary) {
+        key.put16(0);
+        for(std::size_t i = 0; i < ces.size(); ++i) {
+          if(std::uint32_t const secondary = (ces[i] >> format::secondary_shift) & 0x1FF) {
+            key.put16(secondary);
+          }
+        }
+      }
+      if(opt.level >= collation::tertiary) {
+        key.put16(0);
+        for(std::size_t i = 0; i < ces.size(); ++i) {
+          if(std::uint32_t const tertiary = (ces[i] >> format::tertiary_shift) & 0x1F) {
+            key.put8(tertiary);
+          }
+        }
+      }
+      if(opt.level >= collation::quaternary and opt.variable == collation::shifted) {
+        key.put8(0);
+        for(std::size_t i = 0; i < ces.size(); ++i) {
+          if(e.quaternary[i]) {
+            key.put16(e.quaternary[i]);
+          }
+        }
+      }
+    }
+  }
+
+  codepoint_string_t&
+  sort_key_buffer() {
+    static thread_local codepoint_string_t cps;
+    return cps;
+  }
+
+  std::size_t
+  sort_key(codepoint_string_t &cps, unsigned char *out, std::size_t size, collation::options const &opt) {
+    uca::key_elements &e = uca::scratch();
+    uca::prepare(cps, opt, e);
+    if(uca::max_key_length(e) <= size) {
+      uca::unchecked_key_writer key = { out, out };
+      uca::write_key(e, opt, key);
+      return key.length();
+    }
+    uca::key_writer key = { out, size, 0 };
+    uca::write_key(e, opt, key);
+    return key.length;
+  }
+
+  unsigned char const*
+  sort_key(codepoint_string_t &cps, std::size_t &length, collation::options const &opt) {
+    uca::key_elements &e = uca::scratch();
+    uca::prepare(cps, opt, e);
+    e.key.resize(uca::max_key_length(e));
+    uca::unchecked_key_writer writer = { e.key.data(), e.key.data() };
+    uca::write_key(e, opt, writer);
+    length = writer.length();
+    assert(length <= e.key.size());
+    return e.key.data();
+  }
+}
+} // namespace libuni
@@ -0,0 +1,353 @@
+#include <libuni/data.hpp>
+#include "database.hpp"
+#include "data_format.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace libuni {
+namespace helper { namespace database {
+  tables active = compiled_in;
+}}
+
+namespace {
+  using namespace data_format;
+
+  struct mapping {
+    void *addr;
+    std::size_t size;
+  };
+
+  mapping current = { 0, 0 };
+
+  void
+  unmap(mapping &m) {
+    if(m.addr) {
+      munmap(m.addr, m.size);
+      m.addr = 0;
+      m.size = 0;
+    }
+  }
+
+  struct data_file {
+    char const *base;
+    std::size_t size;
+    header const *head;
+    section_entry const *sections;
+
+    section_entry const*
+    find(char const *name) const {
+      for(std::size_t i = 0; i < head->section_count; ++i) {
+        if(std::strncmp(sections[i].name, name, sizeof(sections[i].name)) == 0) {
+          return sections + i;
+        }
+      }
+      return 0;
+    }
+  };
+
+  template<typename T>
+  bool
+  get_array(data_file const &f, array_entry const &a, T const *&p) {
+    if(a.count == 0 or a.width != sizeof(T) or a.offset % alignof(T) != 0 or
+       a.offset > f.size or a.count > (f.size - a.offset) / sizeof(T)) {
+      return false;
+    }
+    p = reinterpret_cast<T const*>(f.base + a.offset);
+    return true;
+  }
+
+  /// get_array for the arrays of a table, which the generator pads to whole 32 bit words (see properties.c++).
+  template<typename T>
+  bool
+  get_table_array(data_file const &f, array_entry const &a, T const *&p) {
+    return a.count * sizeof(T) % 4 == 0 and get_array(f, a, p);
+  }
+
+  /** Returns true if index has at least blocks entries and each entry selects a whole block of
+   * block_size elements (starting at entry << shift) of an array with size elements.  A single pass
+   * over the index, so lookup() can't read outside of the arrays of a corrupt file.
+   */
+  template<typename Index>
+  bool
+  valid_index(array_entry const &a, Index const *index, std::uint64_t blocks, std::size_t shift,
+              std::uint64_t block_size, std::uint64_t size)
+  {
+    if(a.count < blocks) {
+      return false;
+    }
+    for(std::size_t i = 0; i < a.count; ++i) {
+      if((std::uint64_t(index[i]) << shift) + block_size > size) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Number of blocks of 1 << shift code points in [first, table_limit).
+  std::uint64_t
+  blocks(codepoint_t first, std::size_t shift) {
+    return ((std::uint64_t(helper::table_limit) - 1 - first) >> shift) + 1;
+  }
+
+  template<typename Index, typename T>
+  bool
+  bind(data_file const &f, section_entry const &s, helper::two_stage_table<Index, T> &t) {
+    if(s.layout != t.layout or s.shift >= 32) {
+      return false;
+    }
+    t.shift = s.shift;
+    return
+      get_table_array(f, s.arrays[index1_slot], t.index) and get_table_array(f, s.arrays[data_slot], t.data) and
+      valid_index(s.arrays[index1_slot], t.index, blocks(0, s.shift), s.shift, std::uint64_t(1) << s.shift,
+                  s.arrays[data_slot].count);
+  }
+
+  template<typename Index, typename T>
+  bool
+  bind(data_file const &f, section_entry const &s, helper::latin1_table<Index, T> &t) {
+    if(s.layout != t.layout or s.shift >= 32) {
+      return false;
+    }
+    t.rest.shift = s.shift;
+    return
+      get_table_array(f, s.arrays[latin1_slot], t.latin1) and s.arrays[latin1_slot].count >= 0x100 and
+      get_table_array(f, s.arrays[index1_slot], t.rest.index) and get_table_array(f, s.arrays[data_slot], t.rest.data) and
+      valid_index(s.arrays[index1_slot], t.rest.index, blocks(0, s.shift), s.shift, std::uint64_t(1) << s.shift,
+                  s.arrays[data_slot].count);
+  }
+
+  template<typename BmpIndex, typename Index1, typename Index2, typename T>
+  bool
+  bind(data_file const &f, section_entry const &s, helper::bmp_trie<BmpIndex, Index1, Index2, T> &t) {
+    using helper::bmp_trie_shift;
+    if(s.layout != t.layout or s.shift >= 32) {
+      return false;
+    }
+    t.shift = s.shift;
+    std::uint64_t const block = std::uint64_t(1) << bmp_trie_shift;
+    return
+      get_table_array(f, s.arrays[bmp_index_slot], t.bmp_index) and get_table_array(f, s.arrays[index1_slot], t.index1) and
+      get_table_array(f, s.arrays[index2_slot], t.index2) and get_table_array(f, s.arrays[data_slot], t.data) and
+      valid_index(s.arrays[bmp_index_slot], t.bmp_index, 0x10000 >> bmp_trie_shift, 0, block, s.arrays[data_slot].count) and
+      valid_index(s.arrays[index1_slot], t.index1, blocks(0x10000, bmp_trie_shift + s.shift), s.shift,
+                  std::uint64_t(1) << s.shift, s.arrays[index2_slot].count) and
+      valid_index(s.arrays[index2_slot], t.index2, 0, bmp_trie_shift, block, s.arrays[data_slot].count);
+  }
+
+  template<typename Table>
+  bool
+  bind(data_file const &f, char const *name, Table &t, std::string &error) {
+    section_entry const *s = f.find(name);
+    if(not s) {
+      error = std::string("missing table ") + name;
+      return false;
+    }
+    else if(s->layout != t.layout) {
+      error = std::string("table ") + name + " uses another layout than this build (TABLE_LAYOUT)";
+      return false;
+    }
+    else if(not bind(f, *s, t)) {
+      error = std::string("table ") + name + " is corrupt or its element types do not match this build";
+      return false;
+    }
+    return true;
+  }
+
+  template<typename T>
+  bool
+  bind_array(data_file const &f, char const *name, T const *&p, std::size_t &count, std::string &error) {
+    section_entry const *s = f.find(name);
+    if(not s or s->layout != plain_array_id or not get_array(f, s->arrays[index1_slot], p)) {
+      error = std::string("missing or bad ") + name;
+      return false;
+    }
+    count = s->arrays[index1_slot].count;
+    return true;
+  }
+
+  /// Returns true if valid(v) for every value v of the (already bound) table name.
+  template<typename T, typename Valid>
+  bool
+  valid_values(data_file const &f, char const *name, Valid valid) {
+    section_entry const &s = *f.find(name);
+    array_slot const slots[] = { latin1_slot, data_slot };
+    for(std::size_t k = 0; k < sizeof(slots) / sizeof(slots[0]); ++k) {
+      array_entry const &a = s.arrays[slots[k]];
+      T const *const p = reinterpret_cast<T const*>(f.base + a.offset);
+      for(std::size_t i = 0; i < a.count; ++i) {
+        if(not valid(p[i])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  /// Checks the offsets into the other arrays, which lookups use without bounds checks.
+  bool
+  valid_offsets(data_file const &f, helper::database::tables const &t, std::string &error) {
+    if(not valid_values<decltype(t.decomp_index)::value_type>(f, "decomp_index", [&t](std::size_t i) {
+          return i < t.decomp_map_size and (i == 0 or i + 1 + ((t.decomp_map[i] >> 8) & 0xFF) <= t.decomp_map_size);
+        })) {
+      error = "decomp_index does not match decomp_map";
+      return false;
+    }
+
+    auto const valid_ref = [&t](std::uint32_t ref) {
+      return (ref & collation::count_mask) == 0 or
+        (ref >> collation::offset_shift) + (ref & collation::count_mask) <= t.collation_elements_size;
+    };
+    bool valid_contractions = true;
+    for(std::size_t i = collation::contraction_length; i < t.collation_contractions_size; i += collation::contraction_size) {
+      valid_contractions = valid_contractions and valid_ref(t.collation_contractions[i]);
+    }
+    if(not valid_contractions or
+       not valid_values<decltype(t.collation_index)::value_type>(f, "collation_index", valid_ref)) {
+      error = "collation_index or collation_contractions do not match collation_elements";
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  bind(data_file const &f, helper::database::tables &t, std::string &error) {
+    std::size_t size;
+    if(not bind(f, "quick_check", t.quick_check, error) or
+       not bind(f, "decomp_index", t.decomp_index, error) or
+       not bind(f, "simple_uppercase_mapping", t.simple_uppercase_mapping, error) or
+       not bind(f, "simple_lowercase_mapping", t.simple_lowercase_mapping, error) or
+       not bind(f, "simple_titlecase_mapping", t.simple_titlecase_mapping, error) or
+       not bind(f, "breaks", t.breaks, error) or
+       not bind(f, "collation_index", t.collation_index, error) or
+       not bind(f, "properties", t.properties, error) or
+       not bind_array(f, "decomp_map", t.decomp_map, t.decomp_map_size, error) or
+       not bind_array(f, "composition_map", t.composition_map, t.composition_map_size, error) or
+       not bind_array(f, "collation_elements", t.collation_elements, t.collation_elements_size, error) or
+       not bind_array(f, "collation_contractions", t.collation_contractions, t.collation_contractions_size, error) or
+       not bind_array(f, "collation_implicit", t.collation_implicit, t.collation_implicit_size, error) or
+       not bind_array(f, "script_names", t.script_names, t.script_names_size, error)) {
+      return false;
+    }
+    else if(t.script_names[t.script_names_size - 1] != '\0') {
+      error = "bad script_names";
+      return false;
+    }
+    else if(not bind_array(f, "collation_ascii", t.collation_ascii, size, error)) {
+      return false;
+    }
+    else if(size != collation::ascii_size) {
+      error = "bad collation_ascii";
+      return false;
+    }
+    else if(not valid_offsets(f, t, error)) {
+      return false;
+    }
+
+    // The values of the word break property are compiled into the library (break_property)
+    section_entry const *s = f.find("breaks_names");
+    char const *names;
+    if(not s or s->layout != plain_array_id or not get_array(f, s->arrays[index1_slot], names) or
+       s->arrays[index1_slot].count != sizeof(breaks_names) or
+       std::memcmp(names, breaks_names, sizeof(breaks_names)) != 0) {
+      error = "word break property values do not match this build";
+      return false;
+    }
+
+    if(not bind_array(f, "collation_version", t.collation_version, size, error)) {
+      return false;
+    }
+    else if(t.collation_version[size - 1] != '\0') {
+      error = "bad collation_version";
+      return false;
+    }
+
+    t.unicode_version = f.head->unicode_version;
+    return true;
+  }
+
+  /// Loads the file named by LIBUNI_DATA when the library is loaded
+  struct load_from_environment {
+    load_from_environment() {
+      char const *path = std::getenv("LIBUNI_DATA");
+      std::string error;
+      if(path and *path and not data::load(path, &error)) {
+        std::cerr << "libuni: failed to load LIBUNI_DATA `" << path << "': " << error << '\n';
+      }
+    }
+  } load_from_environment_;
+}
+
+namespace data {
+  bool
+  load(char const *path, std::string *error) {
+    std::string ignored;
+    std::string &err = error ? *error : ignored;
+
+    int const fd = open(path, O_RDONLY);
+    if(fd < 0) {
+      err = std::string("can't open: ") + std::strerror(errno);
+      return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 or std::size_t(st.st_size) < sizeof(header)) {
+      close(fd);
+      err = "not a libuni data file";
+      return false;
+    }
+    mapping m;
+    m.size = st.st_size;
+    m.addr = mmap(0, m.size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(m.addr == MAP_FAILED) {
+      err = std::string("can't map: ") + std::strerror(errno);
+      return false;
+    }
+
+    data_file f;
+    f.base = static_cast<char const*>(m.addr);
+    f.size = m.size;
+    f.head = reinterpret_cast<header const*>(f.base);
+    f.sections = reinterpret_cast<section_entry const*>(f.head + 1);
+    if(std::memcmp(f.head->magic, magic, sizeof(magic)) != 0 or f.head->size != f.size) {
+      err = "not a libuni data file";
+    }
+    else if(f.head->version != version or f.head->byte_order != byte_order) {
+      err = "unsupported version or byte order";
+    }
+    else if(f.head->section_count > (f.size - sizeof(header)) / sizeof(section_entry) or
+            f.head->unicode_version[sizeof(f.head->unicode_version) - 1] != '\0') {
+      err = "corrupt header";
+    }
+    else {
+      helper::database::tables t = helper::database::compiled_in;
+      if(bind(f, t, err)) {
+        helper::database::active = t;
+        unmap(current);
+        current = m;
+        return true;
+      }
+    }
+    unmap(m);
+    return false;
+  }
+
+  void
+  use_compiled_in() {
+    helper::database::active = helper::database::compiled_in;
+    unmap(current);
+  }
+
+  char const*
+  unicode_version() {
+    return helper::database::active.unicode_version;
+  }
+}
+} // namespace libuni
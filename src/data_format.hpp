@@ -0,0 +1,125 @@
+/** data_format.hpp --- layout of the binary Unicode data file (libuni.dat)
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * Written by the generator and mapped by src/data.c++ (see include/libuni/data.hpp).  This header is
+ * shared by both and therefore MUST NOT include anything from libuni (the generator bootstraps).
+ *
+ * The file is a header, followed by section_count section entries, followed by the arrays.  Every
+ * array starts at a multiple of alignment (relative to the start of the file), so the file can be
+ * used in place after mmap.  Everything is stored in the byte order of the generating machine;
+ * byte_order tells the loader whether it matches.
+ *
+ * A section is one of the tables from include/libuni/lookup_table.hpp (layout is the table_layout of
+ * the generator) or a plain array.  Unused array slots have count 0.  The arrays of tables are padded
+ * to a multiple of 4 bytes.
+ */
+#ifndef LIBUNI_DATA_FORMAT_HPP
+#define LIBUNI_DATA_FORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace libuni {
+  namespace data_format {
+    char const magic[8] = { 'l', 'i', 'b', 'u', 'n', 'i', 'D', 'B' };
+    std::uint32_t const version = 6;
+    std::uint32_t const byte_order = 0x01020304;
+    std::size_t const alignment = 64;
+
+    enum layout_id {
+      two_stage_id,
+      latin1_two_stage_id,
+      bmp_trie_id,
+      plain_array_id
+    };
+
+    enum array_slot {
+      latin1_slot,
+      bmp_index_slot,
+      index1_slot, // or the plain array
+      index2_slot,
+      data_slot,
+      array_slots
+    };
+
+    struct array_entry {
+      std::uint32_t width; // in bytes: 1, 2 or 4
+      std::uint32_t count;
+      std::uint64_t offset;
+    };
+
+    struct section_entry {
+      char name[32];
+      std::uint32_t layout;
+      std::uint32_t shift;
+      array_entry arrays[array_slots];
+    };
+
+    struct header {
+      char magic[8];
+      std::uint32_t version;
+      std::uint32_t byte_order;
+      char unicode_version[16];
+      std::uint32_t section_count;
+      std::uint32_t reserved;
+      std::uint64_t size; // of the whole file
+    };
+
+    /// composition_map: sorted records of the two code points of a primary composite and the composite.
+    std::size_t const composition_size = 3;
+
+    /** Packing of the collation tables (see include/libuni/collation.hpp).
+     *
+     * collation_elements: primary << 16 | secondary << 7 | tertiary << 1 | variable.
+     *
+     * collation_index: offset of the code point's collation elements << 6 | has contractions | count.
+     * A count of 0 means implicit weights, the offset then is the base weight (0 for unassigned).
+     *
+     * collation_contractions: sorted records of contraction_size values: the code points (0 if
+     * shorter) and the offset and count (as in collation_index) of the collation elements.
+     *
+     * collation_implicit: pairs of base weight and the first code point of @implicitweights ranges.
+     *
+     * collation_ascii: the collation element of each ASCII code point which has exactly one and no
+     * contractions, otherwise 0 (the lookup then goes through collation_index).
+     */
+    namespace collation {
+      std::uint32_t const primary_shift = 16;
+      std::uint32_t const secondary_shift = 7;
+      std::uint32_t const tertiary_shift = 1;
+      std::uint32_t const variable = 1;
+
+      std::uint32_t const count_mask = 0x1F;
+      std::uint32_t const has_contractions = 0x20;
+      std::uint32_t const offset_shift = 6;
+
+      std::size_t const contraction_length = 3;
+      std::size_t const contraction_size = contraction_length + 1;
+
+      std::size_t const ascii_size = 0x80;
+    }
+
+    /** Packing of the properties table (see include/libuni/properties.hpp): the Script index << 8 |
+     * alphabetic | cased | General_Category.  The Script index refers to script_names (0 is Unknown),
+     * the General_Category to general_category_names.
+     */
+    namespace properties {
+      std::uint32_t const category_mask = 0x1F;
+      std::uint32_t const cased = 0x20;
+      std::uint32_t const alphabetic = 0x40;
+      std::uint32_t const script_shift = 8;
+
+      std::size_t const general_categories = 30;
+      char const *const general_category_names[general_categories] = {
+        "Cn", "Lu", "Ll", "Lt", "Lm", "Lo", "Mn", "Mc", "Me", "Nd", "Nl", "No", "Pc", "Pd", "Ps",
+        "Pe", "Pi", "Pf", "Po", "Sm", "Sc", "Sk", "So", "Zs", "Zl", "Zp", "Cc", "Cf", "Cs", "Co"
+      };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,89 @@
+/** database.hpp --- the tables used by the lookup functions
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * The lookup functions (normalization.c++, case.c++, segmentation.c++, collation.c++,
+ * properties.c++) read the tables through database::active.  In the library active initially holds
+ * the compiled-in tables and data::load (data.c++) replaces the pointers with ones into a mapped
+ * data file.  The lookups are the same either way, there is no check which tables are used.  With
+ * LIBUNI_HEADER_ONLY active refers to the constexpr compiled-in tables and data::load is not
+ * available.
+ */
+#ifndef LIBUNI_SRC_DATABASE_HPP
+#define LIBUNI_SRC_DATABASE_HPP
+
+#include <libuni/config.hpp>
+#include "generated/normalization_database.hpp"
+#include "generated/case_database.hpp"
+#include "generated/segmentation_database.hpp"
+#include "generated/collation_database.hpp"
+#include "generated/property_database.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace libuni { namespace helper { namespace database {
+  struct tables {
+    std::remove_const<decltype(quick_check_table)>::type quick_check;
+    std::remove_const<decltype(decomp_index_table)>::type decomp_index;
+    codepoint_t const *decomp_map;
+    std::size_t decomp_map_size;
+    std::uint32_t const *composition_map;
+    std::size_t composition_map_size;
+    std::remove_const<decltype(simple_uppercase_mapping_table)>::type simple_uppercase_mapping;
+    std::remove_const<decltype(simple_lowercase_mapping_table)>::type simple_lowercase_mapping;
+    std::remove_const<decltype(simple_titlecase_mapping_table)>::type simple_titlecase_mapping;
+    std::remove_const<decltype(breaks_table)>::type breaks;
+    std::remove_const<decltype(collation_index_table)>::type collation_index;
+    std::uint32_t const *collation_elements;
+    std::size_t collation_elements_size;
+    std::uint32_t const *collation_contractions;
+    std::size_t collation_contractions_size;
+    std::uint32_t const *collation_implicit;
+    std::size_t collation_implicit_size;
+    std::uint32_t const *collation_ascii;
+    char const *collation_version;
+    std::remove_const<decltype(properties_table)>::type properties;
+    char const *script_names;
+    std::size_t script_names_size;
+    char const *unicode_version;
+  };
+
+  constexpr tables compiled_in = {
+    quick_check_table,
+    decomp_index_table,
+    decomp_map,
+    sizeof(decomp_map)/sizeof(decomp_map[0]),
+    composition_map,
+    sizeof(composition_map)/sizeof(composition_map[0]),
+    simple_uppercase_mapping_table,
+    simple_lowercase_mapping_table,
+    simple_titlecase_mapping_table,
+    breaks_table,
+    collation_index_table,
+    collation_elements,
+    sizeof(collation_elements)/sizeof(collation_elements[0]),
+    collation_contractions,
+    sizeof(collation_contractions)/sizeof(collation_contractions[0]),
+    collation_implicit,
+    sizeof(collation_implicit)/sizeof(collation_implicit[0]),
+    collation_ascii,
+    collation_version,
+    properties_table,
+    script_names,
+    sizeof(script_names),
+    unicode_version
+  };
+
+#ifdef LIBUNI_HEADER_ONLY
+  constexpr tables const &active = compiled_in;
+#else
+  extern tables active; // data.c++
+#endif
+}}}
+
+#endif
@@ -12,11 +12,19 @@
  * It takes the following compile-time parameters
  * - UCD_PATH :: the path to the directory containing the UCD files. MUST end with a /! [default: "UCD/"]
  * - UCD_VERSION :: suffix for UCD files. [default: ""]
- * - OUTDIR :: path to create the C++ files in. MUST end with a /! [default: "src/generated/"]
+ * - UCA_PATH :: the path to the directory containing allkeys.txt (the DUCET of UTS#10). MUST end with a /!
+ *               [default: UCD_PATH]
+ * - OUTDIR :: path to create the C++ files and the binary data file (libuni.dat, see data_format.hpp) in.
+ *             MUST end with a /! [default: "src/generated/"]
+ * - TABLE_LAYOUT :: how to pick the table layout (see lookup_table.hpp) for each property: the name of a layout
+ *                   to use it for every property, "size" to pick the smallest table, or "speed" to run a
+ *                   micro-benchmark and pick the fastest (preferring the smaller table if they are close).
+ *                   "speed" depends on timings, so its output differs from run to run. [default: "two_stage"]
  *
  * The latest version of the Unicode Character Database can be found at
  * http://www.unicode.org/Public/UNIDATA/
  * See http://www.unicode.org/reports/tr44/ and http://www.unicode.org/ucd/
+ * allkeys.txt is part of the Unicode Collation Algorithm: http://www.unicode.org/Public/UCA/
  */
 #include <iostream>
 #include <fstream>
@@ -26,24 +34,37 @@
 #include <cstdint>
 #include <algorithm>
 #include <unordered_map>
-#include <unordered_set>
+#include <chrono>
+#include <limits>
+#include <array>
 
 #include <boost/optional.hpp>
 #include <boost/functional/hash.hpp>
 
+#include "data_format.hpp"
+
 #ifndef UCD_PATH
 #define UCD_PATH "UCD/"
 #endif
 #ifndef UCD_VERSION
 #define UCD_VERSION
 #endif
+#ifndef UCA_PATH
+#define UCA_PATH UCD_PATH
+#endif
 #ifndef OUTDIR
 #define OUTDIR "src/generated/"
 #endif
+#ifndef TABLE_LAYOUT
+#define TABLE_LAYOUT "two_stage"
+#endif
 
 namespace {
   typedef std::uint32_t codepoint_t;
 
+  /// Size of the property tables: U+0000..U+10FFFF.  lookup_table.hpp returns 0 for anything above.
+  codepoint_t const codepoint_limit = 0x110000;
+
   template<typename I>
   codepoint_t
   string_to_codepoint(I begin, I end) {
@@ -96,10 +117,20 @@ namespace {
     }
   }
 
+  struct decomp_hash {
+    std::size_t operator()(std::vector<codepoint_t> const &v) const {
+      return boost::hash_range(v.begin(), v.end());
+    }
+  };
+
+  /// Maps each entry (length + prefix, codepoints) in decomp_map to its position.
+  typedef std::unordered_map<std::vector<codepoint_t>, std::size_t, decomp_hash> decomp_cache_t;
+
   /// Handle decomp_mapping (see UAX#44 5.7.3): [<prefix>] codepoint codepoint ...
   bool
   handle_decomp_mapping(codepoint_t cp, std::string const &str,
-                        std::vector<std::size_t> &decomp_index, std::vector<codepoint_t> &decomp_map, std::vector<std::string> &decomp_prefix)
+                        std::vector<std::size_t> &decomp_index, std::vector<codepoint_t> &decomp_map, std::vector<std::string> &decomp_prefix,
+                        decomp_cache_t &decomp_cache)
   {
     std::vector<codepoint_t> ret(1, 0); // first codepoint is length + prefix
     std::string::const_iterator const end = str.cend();
@@ -154,15 +185,11 @@ namespace {
     assert(ret.size() - 1 < 0xFF);
     ret[0] |= (ret.size() - 1) << 8;
 
-    auto j = std::search(decomp_map.cbegin(), decomp_map.cend(),
-                         ret.cbegin(), ret.cend());
-    if(j == decomp_map.cend()) {
-      decomp_index[cp] = decomp_map.size();
+    std::pair<decomp_cache_t::iterator, bool> const j = decomp_cache.insert(std::make_pair(ret, decomp_map.size()));
+    if(j.second) {
       decomp_map.insert(decomp_map.end(), ret.cbegin(), ret.cend());
     }
-    else {
-      decomp_index[cp] = j - decomp_map.cbegin();
-    }
+    decomp_index[cp] = j.first->second;
     return true;
   }
 
@@ -213,7 +240,7 @@ namespace {
   typename Cont::value_type
   container_max(Cont const &ct) {
     auto end = ct.end();
-    typename Cont::value_type m;
+    typename Cont::value_type m = typename Cont::value_type();
     for(auto i = ct.begin(); i != end; ++i) {
       m = std::max(m, *i);
     }
@@ -261,11 +288,10 @@ namespace {
     return getsize_<T>::getsize(t);
   }
 
-  template<typename Cont>
+  /// The type of an element of width bytes.
   char const*
-  gettype(Cont const &ct) {
-    std::size_t const n = getsize(container_max(ct));
-    switch(n) {
+  type_name(std::size_t width) {
+    switch(width) {
     case 1:
       return "std::uint8_t";
     case 2:
@@ -274,34 +300,99 @@ namespace {
       return "std::uint32_t";
     }
   }
+  template<typename Cont>
+  char const*
+  gettype(Cont const &ct) {
+    return type_name(getsize(container_max(ct)));
+  }
+
+
+  /// Hashes of the bins of size 1 in t.
+  template<typename Int>
+  std::vector<std::size_t>
+  element_hashes(std::vector<Int> const &t) {
+    std::vector<std::size_t> hashes(t.size());
+    boost::hash<Int> hash;
+    for(std::size_t i = 0; i < t.size(); ++i) {
+      hashes[i] = hash(t[i]);
+    }
+    return hashes;
+  }
+
+  /// Turns the hashes of bins of size n into the hashes of bins of size 2n (an incomplete bin is dropped).
+  inline
+  void
+  combine_hashes(std::vector<std::size_t> &hashes) {
+    for(std::size_t i = 0; i < hashes.size() / 2; ++i) {
+      std::size_t h = hashes[2*i];
+      boost::hash_combine(h, hashes[2*i + 1]);
+      hashes[i] = h;
+    }
+    hashes.resize(hashes.size() / 2);
+  }
+
+  /**
+   * Hashes and compares bins of 1 << shift elements in place (the key is a pointer to the first
+   * element).  The hashes are precomputed with element_hashes/combine_hashes.
+   */
+  template<typename Int>
+  struct bin_hash {
+    Int const *base;
+    std::size_t const *hashes;
+    std::size_t shift;
+
+    bin_hash(Int const *base, std::size_t const *hashes, std::size_t shift)
+      : base(base), hashes(hashes), shift(shift)
+    { }
+
+    std::size_t operator()(Int const *bin) const {
+      return hashes[(bin - base) >> shift];
+    }
+  };
+
+  template<typename Int>
+  struct bin_equal {
+    std::size_t size;
+
+    explicit bin_equal(std::size_t size) : size(size) { }
+
+    bool operator()(Int const *lhs, Int const *rhs) const {
+      return std::equal(lhs, lhs + size, rhs);
+    }
+  };
+
+  /// Maps the first occurrence of each distinct bin to its offset in the output table.
+  template<typename Int>
+  struct bincache_t : std::unordered_map<Int const*, std::size_t, bin_hash<Int>, bin_equal<Int>> {
+    bincache_t(std::vector<Int> const &t, std::vector<std::size_t> const &hashes, std::size_t shift)
+      : std::unordered_map<Int const*, std::size_t, bin_hash<Int>, bin_equal<Int>>(
+          hashes.size(), bin_hash<Int>(t.data(), hashes.data(), shift), bin_equal<Int>(std::size_t(1) << shift))
+    { }
+  };
 
   // inspired by makeunicodedata.py splitbins (see python source code)
   template<typename Int>
   void
   splitbins(std::vector<Int> const &t, std::vector<std::size_t> &t1, std::vector<Int> &t2, std::size_t &shift) {
-    struct hash {
-      std::size_t operator()(std::vector<Int> const &t) const {
-        return boost::hash_range(t.begin(), t.end());
-      }
-    };
-
     std::size_t const maxshift = floor_log2(t.size());
     std::size_t bytes = ~0;
+    Int const *const data = t.data();
 
+    std::vector<std::size_t> hashes = element_hashes(t);
     for(std::size_t shift2 = 0; shift2 < maxshift + 1; ++shift2) {
       std::size_t const size = 1 << shift2;
-      typedef std::unordered_set<std::vector<Int>, hash> bincache_t;
-      bincache_t bincache;
+      if(shift2 > 0) {
+        combine_hashes(hashes);
+      }
+      bincache_t<Int> bincache(t, hashes, shift2);
       std::size_t t1_size = 0;
       std::size_t t1_max = 0;
       std::size_t t2_size = 0;
       Int t2_max = 0;
-      for(std::size_t i = 0; i < t.size() - size; i += size) {
-        std::vector<Int> v(t.begin() + i, t.begin() + i + size);
-        std::pair<typename bincache_t::iterator, bool> const r = bincache.insert(v);
-        if(r.second) {
-          t2_size += v.end() - v.begin();
-          t2_max = std::max(t2_max, container_max(v));
+      for(std::size_t i = 0; i + size <= t.size(); i += size) {
+        if(bincache.insert(std::make_pair(data + i, t2_size)).second) {
+          t2_size += size;
+          t2_max = std::max(t2_max, *std::max_element(data + i, data + i + size));
         }
         t1_max = std::max(t1_max, t2_size >> shift2);
         ++t1_size;
@@ -314,23 +405,26 @@ namespace {
     }
 
     std::size_t const size = 1 << shift;
-    std::unordered_map<std::vector<Int>, std::size_t, hash> bincache;
+    hashes = element_hashes(t);
+    for(std::size_t i = 0; i < shift; ++i) {
+      combine_hashes(hashes);
+    }
+    bincache_t<Int> bincache(t, hashes, shift);
     t1.clear();
     t2.clear();
     for(std::size_t i = 0; i < t.size(); i += size) {
-      std::vector<Int> v(t.begin() + i, t.begin() + i + size);
-      auto iter = bincache.find(v);
-      std::size_t index;
-      if(iter == bincache.end()) {
-        index = t2.size();
-        bincache[v] = index;
-        t2.insert(t2.end(), v.begin(), v.end());
+      if(i + size > t.size()) { // incomplete last bin
+        t1.push_back(t2.size() >> shift);
+        t2.insert(t2.end(), t.begin() + i, t.end());
+        t2.resize(t2.size() + i + size - t.size(), Int());
+        break;
       }
-      else {
-        index = iter->second;
-      } 
-      t1.push_back(index >> shift);
-    }  
+      std::pair<typename bincache_t<Int>::iterator, bool> const r = bincache.insert(std::make_pair(data + i, t2.size()));
+      if(r.second) {
+        t2.insert(t2.end(), data + i, data + i + size);
+      }
+      t1.push_back(r.first->second >> shift);
+    }
   }
 
   template<typename Cont>
@@ -347,28 +441,532 @@ namespace {
     out << linebuf.str().substr(0, linebuf.str().size() - 2) << '\n';
   }
 
-  enum Quick_Check {
-    Yes,
-    Maybe,
-    No
+  enum table_layout {
+    two_stage,
+    latin1_two_stage,
+    bmp_trie,
+    table_layouts
   };
 
-  void
-  print_case_mapping(std::ostream &out, std::vector<codepoint_t> const &case_map, char const *name) {
+  char const *const table_layout_names[table_layouts] = {
+    "two_stage",
+    "latin1_two_stage",
+    "bmp_trie"
+  };
+
+  static_assert(int(two_stage) == int(libuni::data_format::two_stage_id) and
+                int(latin1_two_stage) == int(libuni::data_format::latin1_two_stage_id) and
+                int(bmp_trie) == int(libuni::data_format::bmp_trie_id), "table_layout has to match data_format::layout_id");
+
+  std::size_t const bmp_trie_shift = 6;
+  codepoint_t const bmp_end = 0x10000;
+
+  /// Generator side of the layouts in include/libuni/lookup_table.hpp. Keep lookup() in sync!
+  template<typename Int>
+  struct layout_table {
+    table_layout layout;
+    std::vector<Int> latin1;           // latin1_two_stage
+    std::vector<std::size_t> bmp_index; // bmp_trie
+    std::vector<std::size_t> index1;
+    std::vector<std::size_t> index2;    // bmp_trie
+    std::vector<Int> data;
     std::size_t shift;
-    std::vector<std::size_t> t1;
-    std::vector<codepoint_t> casedata;
-    splitbins(case_map, t1, casedata, shift);
+    std::size_t data_width; // at least (see width)
+
+    /** Width of the elements of the array in slot: the width the largest value needs, but at least
+     * two bytes for the indices and data_width for the data.  The minimum keeps the types (and
+     * therefore the data files, see data.c++) the same for most UCD versions.
+     */
+    std::size_t
+    width(libuni::data_format::array_slot slot) const {
+      using namespace libuni::data_format;
+      switch(slot) {
+      case bmp_index_slot:
+        return std::max(getsize(container_max(bmp_index)), std::size_t(2));
+      case index1_slot:
+        return std::max(getsize(container_max(index1)), std::size_t(2));
+      case index2_slot:
+        return std::max(getsize(container_max(index2)), std::size_t(2));
+      default: // latin1 has the type of data (see latin1_table)
+        return std::max(getsize(container_max(data)), data_width);
+      }
+    }
+
+    /** Appends zeros to the arrays until each is a multiple of four bytes long.  The AVX2 kernel of
+     * lookup_properties gathers the aligned 32 bit word containing an element (see properties.c++).
+     */
+    void
+    pad() {
+      using namespace libuni::data_format;
+      pad(latin1, width(latin1_slot));
+      pad(bmp_index, width(bmp_index_slot));
+      pad(index1, width(index1_slot));
+      pad(index2, width(index2_slot));
+      pad(data, width(data_slot));
+    }
+
+    template<typename T>
+    static
+    void
+    pad(std::vector<T> &v, std::size_t width) {
+      while(v.size() * width % 4 != 0) {
+        v.push_back(0);
+      }
+    }
+
+    Int
+    lookup_two_stage(codepoint_t cp) const {
+      return data[(index1[cp >> shift] << shift) + (cp & ((1 << shift) - 1))];
+    }
+
+    Int
+    lookup_latin1_two_stage(codepoint_t cp) const {
+      return cp < 0x100 ? latin1[cp] : lookup_two_stage(cp);
+    }
+
+    Int
+    lookup_bmp_trie(codepoint_t cp) const {
+      if(cp < bmp_end) {
+        return data[bmp_index[cp >> bmp_trie_shift] + (cp & ((1 << bmp_trie_shift) - 1))];
+      }
+      std::size_t const block = (cp - bmp_end) >> bmp_trie_shift;
+      std::size_t const i = index2[(index1[block >> shift] << shift) + (block & ((1 << shift) - 1))];
+      return data[(i << bmp_trie_shift) + (cp & ((1 << bmp_trie_shift) - 1))];
+    }
+
+    Int
+    lookup(codepoint_t cp) const {
+      switch(layout) {
+      case two_stage:
+        return lookup_two_stage(cp);
+      case latin1_two_stage:
+        return lookup_latin1_two_stage(cp);
+      default:
+        return lookup_bmp_trie(cp);
+      }
+    }
+
+    std::size_t
+    bytes() const {
+      using namespace libuni::data_format;
+      return
+        latin1.size() * width(latin1_slot) +
+        bmp_index.size() * width(bmp_index_slot) +
+        index1.size() * width(index1_slot) +
+        index2.size() * width(index2_slot) +
+        data.size() * width(data_slot);
+    }
+  };
 
-    out << "std::size_t const " << name << "_shift = " << shift << ";\n\n";
+  template<typename Int>
+  layout_table<Int>
+  build_layout(std::vector<Int> const &t, table_layout layout, std::size_t data_width = 1) {
+    layout_table<Int> table;
+    table.layout = layout;
+    table.data_width = data_width;
+    if(layout == latin1_two_stage) {
+      table.latin1.assign(t.begin(), t.begin() + 0x100);
+    }
+    if(layout != bmp_trie) {
+      splitbins(t, table.index1, table.data, table.shift);
+      table.pad();
+      return table;
+    }
+
+    // bmp_trie: deduplicate blocks over the whole range but only index the BMP directly.
+    std::size_t const size = 1 << bmp_trie_shift;
+    std::vector<std::size_t> hashes = element_hashes(t);
+    for(std::size_t i = 0; i < bmp_trie_shift; ++i) {
+      combine_hashes(hashes);
+    }
+    bincache_t<Int> bincache(t, hashes, bmp_trie_shift);
+    std::vector<std::size_t> supplementary_blocks;
+    for(std::size_t i = 0; i + size <= t.size(); i += size) {
+      std::pair<typename bincache_t<Int>::iterator, bool> const r = bincache.insert(std::make_pair(t.data() + i, table.data.size()));
+      if(r.second) {
+        table.data.insert(table.data.end(), t.begin() + i, t.begin() + i + size);
+      }
+      std::size_t const offset = r.first->second;
+      if(i < bmp_end) {
+        table.bmp_index.push_back(offset);
+      }
+      else {
+        supplementary_blocks.push_back(offset >> bmp_trie_shift);
+      }
+    }
+    splitbins(supplementary_blocks, table.index1, table.index2, table.shift);
+    table.pad();
+    return table;
+  }
+
+  volatile std::size_t benchmark_sink; // keeps the benchmark loop from being optimized away
+
+  template<typename Int, Int (layout_table<Int>::*Lookup)(codepoint_t) const>
+  double
+  time_lookups(layout_table<Int> const &table) {
+    // Runs of ASCII, Latin/Greek/Cyrillic, the rest of the BMP and supplementary code points.
+    static std::vector<codepoint_t> sample;
+    if(sample.empty()) {
+      std::uint32_t x = 2463534242u;
+      while(sample.size() < (1 << 16)) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        codepoint_t base, range;
+        switch(x % 10) {
+        case 0: case 1: case 2: case 3:
+          base = 0x00;
+          range = 0x80;
+          break;
+        case 4: case 5:
+          base = 0x80;
+          range = 0x400;
+          break;
+        case 6: case 7: case 8:
+          base = 0x400;
+          range = bmp_end - base;
+          break;
+        default:
+          base = bmp_end;
+          range = 0x20000;
+        }
+        base += (x >> 8) % range;
+        for(std::size_t run = 16 + (x >> 4) % 64; run > 0; --run) {
+          x ^= x << 13;
+          x ^= x >> 17;
+          x ^= x << 5;
+          sample.push_back(base + x % 0x80);
+        }
+      }
+    }
+
+    double best = std::numeric_limits<double>::max();
+    for(std::size_t rep = 0; rep < 15; ++rep) {
+      std::size_t acc = 0;
+      auto const start = std::chrono::steady_clock::now();
+      for(auto i = sample.cbegin(); i != sample.cend(); ++i) {
+        acc += (table.*Lookup)(*i);
+      }
+      auto const stop = std::chrono::steady_clock::now();
+      benchmark_sink = acc;
+      best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count() / sample.size());
+    }
+    return best;
+  }
+
+  /// Returns the average time of a lookup in nanoseconds.
+  template<typename Int>
+  double
+  benchmark_layout(layout_table<Int> const &table) {
+    switch(table.layout) {
+    case two_stage:
+      return time_lookups<Int, &layout_table<Int>::lookup_two_stage>(table);
+    case latin1_two_stage:
+      return time_lookups<Int, &layout_table<Int>::lookup_latin1_two_stage>(table);
+    default:
+      return time_lookups<Int, &layout_table<Int>::lookup_bmp_trie>(table);
+    }
+  }
+
+  /// Builds every layout for t and picks one according to TABLE_LAYOUT. Writes a summary to comment.
+  template<typename Int>
+  layout_table<Int>
+  select_layout(std::vector<Int> const &t, char const *name, std::string const &mode, std::ostream &comment,
+                std::size_t data_width = 1)
+  {
+    for(std::size_t i = 0; i < table_layouts; ++i) {
+      if(mode == table_layout_names[i]) {
+        comment << "// " << table_layout_names[i] << " (forced)\n";
+        return build_layout(t, static_cast<table_layout>(i), data_width);
+      }
+    }
+    std::vector<layout_table<Int>> candidates;
+    for(std::size_t i = 0; i < table_layouts; ++i) {
+      if(i == latin1_two_stage) { // same split as two_stage
+        candidates.push_back(candidates[two_stage]);
+        candidates.back().layout = latin1_two_stage;
+        candidates.back().latin1.assign(t.begin(), t.begin() + 0x100);
+      }
+      else {
+        candidates.push_back(build_layout(t, static_cast<table_layout>(i), data_width));
+      }
+    }
+    bool const by_speed = mode != "size";
+    if(by_speed and mode != "speed") {
+      std::cerr << "WARNING: Unknown TABLE_LAYOUT `" << mode << "' using `speed'\n";
+    }
 
-    out << gettype(t1) << " const " << name << "_index[] = {\n";
-    print_list(out, t1);
+    std::size_t best = 0;
+    std::vector<double> ns(candidates.size(), 0.0);
+    for(std::size_t i = 0; i < candidates.size(); ++i) {
+      if(by_speed) {
+        ns[i] = benchmark_layout(candidates[i]);
+      }
+      comment << "// " << table_layout_names[i] << ": " << candidates[i].bytes() << " bytes\n";
+      if(by_speed) { // not in the generated files: they have to be the same for every run
+        std::cout << name << ": " << table_layout_names[i] << ' ' << ns[i] << " ns/lookup\n";
+      }
+
+      bool better;
+      if(by_speed) { // only switch to a bigger table if it is notably faster
+        better =
+          (ns[i] < ns[best] * 0.9) or
+          (ns[i] < ns[best] * 1.1 and candidates[i].bytes() < candidates[best].bytes());
+      }
+      else {
+        better = candidates[i].bytes() < candidates[best].bytes();
+      }
+      if(better) {
+        best = i;
+      }
+    }
+    comment << "// selected " << table_layout_names[best] << " by " << (by_speed ? "speed" : "size") << '\n';
+    return candidates[best];
+  }
+
+  /// Collects the tables for the binary data file (see data_format.hpp).
+  struct data_file {
+    struct array {
+      std::uint32_t width;
+      std::vector<std::uint32_t> values;
+    };
+
+    struct section {
+      std::string name;
+      std::uint32_t layout;
+      std::uint32_t shift;
+      array arrays[libuni::data_format::array_slots];
+    };
+
+    std::vector<section> sections;
+
+    /// width 0 means the width of the type gettype() prints for ct.
+    template<typename Cont>
+    static
+    array
+    make_array(Cont const &ct, std::size_t width = 0) {
+      array a;
+      a.width = width ? width : getsize(container_max(ct));
+      a.values.assign(ct.begin(), ct.end());
+      return a;
+    }
+
+    template<typename Int>
+    void
+    add(std::string const &name, layout_table<Int> const &t) {
+      using namespace libuni::data_format;
+      section s;
+      s.name = name;
+      s.layout = t.layout;
+      s.shift = t.shift;
+      s.arrays[latin1_slot] = make_array(t.latin1, t.width(latin1_slot));
+      s.arrays[bmp_index_slot] = make_array(t.bmp_index, t.width(bmp_index_slot));
+      s.arrays[index1_slot] = make_array(t.index1, t.width(index1_slot));
+      s.arrays[index2_slot] = make_array(t.index2, t.width(index2_slot));
+      s.arrays[data_slot] = make_array(t.data, t.width(data_slot));
+      sections.push_back(s);
+    }
+
+    template<typename Cont>
+    void
+    add_array(std::string const &name, Cont const &ct, std::size_t width = 0) {
+      section s;
+      s.name = name;
+      s.layout = libuni::data_format::plain_array_id;
+      s.shift = 0;
+      for(std::size_t i = 0; i < libuni::data_format::array_slots; ++i) {
+        s.arrays[i].width = 1;
+      }
+      s.arrays[libuni::data_format::index1_slot] = make_array(ct, width);
+      sections.push_back(s);
+    }
+
+    bool
+    write(char const *path, std::string const &unicode_version) const {
+      using namespace libuni::data_format;
+      auto const align = [](std::uint64_t n) { return (n + alignment - 1) / alignment * alignment; };
+
+      std::vector<section_entry> entries(sections.size());
+      std::uint64_t offset = align(sizeof(header) + sizeof(section_entry) * sections.size());
+      for(std::size_t i = 0; i < sections.size(); ++i) {
+        section_entry &e = entries[i];
+        std::fill(e.name, e.name + sizeof(e.name), '\0');
+        assert(sections[i].name.size() < sizeof(e.name));
+        std::copy(sections[i].name.begin(), sections[i].name.end(), e.name);
+        e.layout = sections[i].layout;
+        e.shift = sections[i].shift;
+        for(std::size_t j = 0; j < array_slots; ++j) {
+          array const &a = sections[i].arrays[j];
+          e.arrays[j].width = a.width;
+          e.arrays[j].count = a.values.size();
+          e.arrays[j].offset = a.values.empty() ? 0 : offset;
+          offset = align(offset + a.width * a.values.size());
+        }
+      }
+
+      header h;
+      std::copy(magic, magic + sizeof(magic), h.magic);
+      h.version = version;
+      h.byte_order = byte_order;
+      std::fill(h.unicode_version, h.unicode_version + sizeof(h.unicode_version), '\0');
+      unicode_version.copy(h.unicode_version, sizeof(h.unicode_version) - 1);
+      h.section_count = sections.size();
+      h.reserved = 0;
+      h.size = offset;
+
+      std::ofstream out(path, std::ios::binary);
+      if(not out) {
+        std::cerr << "Failed to open: `" << path << "'\n";
+        return false;
+      }
+      std::vector<char> buf(reinterpret_cast<char const*>(&h), reinterpret_cast<char const*>(&h + 1));
+      buf.insert(buf.end(), reinterpret_cast<char const*>(entries.data()), reinterpret_cast<char const*>(entries.data() + entries.size()));
+      for(std::size_t i = 0; i < sections.size(); ++i) {
+        for(std::size_t j = 0; j < array_slots; ++j) {
+          array const &a = sections[i].arrays[j];
+          if(a.values.empty()) {
+            continue;
+          }
+          buf.resize(entries[i].arrays[j].offset, '\0');
+          for(auto v = a.values.cbegin(); v != a.values.cend(); ++v) {
+            std::uint8_t const u8 = *v;
+            std::uint16_t const u16 = *v;
+            char const *p = a.width == 1 ? reinterpret_cast<char const*>(&u8) :
+                            a.width == 2 ? reinterpret_cast<char const*>(&u16) : reinterpret_cast<char const*>(&*v);
+            buf.insert(buf.end(), p, p + a.width);
+          }
+        }
+      }
+      buf.resize(offset, '\0');
+      out.write(buf.data(), buf.size());
+      return bool(out);
+    }
+  };
+
+  /// Extracts the version from the first line of a UCD file, e.g., "# DerivedNormalizationProps-6.1.0.txt"
+  inline
+  std::string
+  ucd_version(std::string const &first_line) {
+    std::string::size_type const dash = first_line.rfind('-');
+    std::string::size_type const txt = first_line.rfind(".txt");
+    if(dash == std::string::npos or txt == std::string::npos or txt < dash) {
+      return "unknown";
+    }
+    return first_line.substr(dash + 1, txt - dash - 1);
+  }
+
+  /**
+   * Prints t as <name>_table (see lookup_table.hpp) with the layout selected by TABLE_LAYOUT and adds it to db.
+   * The data takes at least data_width bytes per element (0: the size of Int, at most 4).
+   */
+  template<typename Int>
+  void
+  print_table(std::ostream &out, std::vector<Int> const &t, char const *name, data_file &db,
+              std::size_t data_width = 0, std::string const &mode = TABLE_LAYOUT)
+  {
+    using namespace libuni::data_format;
+    std::stringstream comment;
+    layout_table<Int> const table = select_layout(t, name, mode, comment,
+                                                  data_width ? data_width : std::min(sizeof(Int), std::size_t(4)));
+    char const *const latin1_type = type_name(table.width(latin1_slot));
+    char const *const bmp_index_type = type_name(table.width(bmp_index_slot));
+    char const *const index1_type = type_name(table.width(index1_slot));
+    char const *const index2_type = type_name(table.width(index2_slot));
+    char const *const data_type = type_name(table.width(data_slot));
+    db.add(name, table);
+    out << "// " << name << '\n' << comment.str();
+
+    // aligned and padded to whole 32 bit words (see layout_table::pad)
+    if(not table.latin1.empty()) {
+      out << "alignas(4) constexpr " << latin1_type << " " << name << "_latin1[] = {\n";
+      print_list(out, table.latin1);
+      out << "};\n\n";
+    }
+    if(not table.bmp_index.empty()) {
+      out << "alignas(4) constexpr " << bmp_index_type << " " << name << "_bmp_index[] = {\n";
+      print_list(out, table.bmp_index);
+      out << "};\n\n";
+    }
+    out << "alignas(4) constexpr " << index1_type << " " << name << "_index1[] = {\n";
+    print_list(out, table.index1);
+    out << "};\n\n";
+    if(not table.index2.empty()) {
+      out << "alignas(4) constexpr " << index2_type << " " << name << "_index2[] = {\n";
+      print_list(out, table.index2);
+      out << "};\n\n";
+    }
+    out << "alignas(4) constexpr " << data_type << " " << name << "_data[] = {\n";
+    print_list(out, table.data);
     out << "};\n\n";
 
-    out << "libuni::codepoint_t const " << name << "[] = {\n";
-    print_list(out, casedata);
+    switch(table.layout) {
+    case two_stage:
+      out << "constexpr libuni::helper::two_stage_table<" << index1_type << ", " << data_type << "> "
+          << name << "_table = {\n  "
+          << name << "_index1, " << name << "_data, " << table.shift << "\n};\n\n";
+      break;
+    case latin1_two_stage:
+      out << "constexpr libuni::helper::latin1_table<" << index1_type << ", " << data_type << "> "
+          << name << "_table = {\n  "
+          << name << "_latin1, { " << name << "_index1, " << name << "_data, " << table.shift << " }\n};\n\n";
+      break;
+    default:
+      out << "constexpr libuni::helper::bmp_trie<" << bmp_index_type << ", " << index1_type << ", "
+          << index2_type << ", " << data_type << "> "
+          << name << "_table = {\n  "
+          << name << "_bmp_index, " << name << "_index1, " << name << "_index2, " << name << "_data, " << table.shift << "\n};\n\n";
+    }
+  }
+
+  /// Appends a NUL-separated list of names to out and db (see breaks_names and script_names).
+  void
+  print_names(std::ostream &out, std::vector<std::string> const &names, char const *name, data_file &db) {
+    std::string joined;
+    for(auto i = names.cbegin(); i != names.cend(); ++i) {
+      joined += *i;
+      joined.push_back('\0');
+    }
+    out << "constexpr char " << name << "[] = {\n";
+    print_list(out, joined);
     out << "};\n\n";
+    db.add_array(name, joined, 1);
+  }
+
+  enum Quick_Check {
+    Yes,
+    Maybe,
+    No
+  };
+
+  /**
+   * Collects the primary composites: code points with a canonical decomposition into two code
+   * points which are not excluded from composition (NFC_QC=No).  Writes sorted records of the two
+   * code points and the composite (see data_format.hpp) to composition_map.
+   */
+  inline
+  void
+  composition(std::vector<std::uint16_t> const &qc, std::vector<std::size_t> const &decomp_index,
+              std::vector<codepoint_t> const &decomp_map, std::vector<std::uint32_t> &composition_map)
+  {
+    std::vector<std::array<std::uint32_t, libuni::data_format::composition_size>> records;
+    for(codepoint_t cp = 0; cp < decomp_index.size(); ++cp) {
+      std::size_t const index = decomp_index[cp];
+      if(index == 0 or ((qc[cp] >> 4) & 3) == No) {
+        continue;
+      }
+      codepoint_t const info = decomp_map[index];
+      if((info & 0xFF) == 0 and ((info >> 8) & 0xFF) == 2) {
+        std::array<std::uint32_t, libuni::data_format::composition_size> const r = {
+          { decomp_map[index + 1], decomp_map[index + 2], cp }
+        };
+        records.push_back(r);
+      }
+    }
+    std::sort(records.begin(), records.end());
+    composition_map.clear();
+    for(auto i = records.begin(); i != records.end(); ++i) {
+      composition_map.insert(composition_map.end(), i->begin(), i->end());
+    }
   }
 
   enum break_value_shift {
@@ -380,31 +978,36 @@ namespace {
   /**
    * Checks whether the string codepoint contains a single code point or a code point range and
    * uses binary-OR to append value to each code point entry in  the random-access container ct.
+   * Code points outside of ct are ignored.
    */
   template<typename Cont, typename T>
   void
   assign_codepoint(std::string const &codepoint, Cont &ct, T value) {
     std::string::size_type const dot = codepoint.find('.');
+    codepoint_t first, last;
     if(dot != std::string::npos) { // range
-      codepoint_t i = string_to_codepoint(codepoint.begin(), codepoint.begin() + dot);
+      first = string_to_codepoint(codepoint.begin(), codepoint.begin() + dot);
       if(dot+2 > codepoint.size()) { // bad code range format!
         std::cerr << "WARNING: Bad Code Range Format `" << codepoint << "'\n";
         throw "todo";
       }
-      codepoint_t const end = string_to_codepoint(codepoint.begin() + dot, codepoint.end());
-      for(; i <= end; ++i) {
-        ct[i] |= value;
-      }
+      last = string_to_codepoint(codepoint.begin() + dot, codepoint.end());
     }
     else {
-      codepoint_t cp = string_to_codepoint(codepoint.begin(), codepoint.end());
-      ct[cp] |= value;
+      first = last = string_to_codepoint(codepoint.begin(), codepoint.end());
+    }
+    if(last >= ct.size()) {
+      std::cerr << "WARNING: Code point out of range `" << codepoint << "'\n";
+      last = ct.size() - 1;
+    }
+    for(auto i = ct.begin() + first, end = ct.begin() + last + 1; i < end; ++i) {
+      *i |= value;
     }
   }
 
   bool
-  text_segmentation() {
-    std::vector<std::uint16_t> break_values(0xff0000, 0);
+  text_segmentation(data_file &db) {
+    std::vector<std::uint16_t> break_values(codepoint_limit, 0);
     std::vector<std::string> value_names(1, "X_none");
 
     std::ifstream in(UCD_PATH "auxiliary/WordBreakProperty" UCD_VERSION ".txt");
@@ -433,6 +1036,7 @@ namespace {
       "#define LIBUNI_GENERATED_SEGMENTATION_DATABASE_HPP\n\n"
       "//This file is autogenerated by create_two_stage_table.c++\n\n"
       "#include <libuni/codepoint.hpp>\n"
+      "#include <libuni/lookup_table.hpp>\n"
       "#include <cstddef>\n"
       "#include <cstdint>\n\n"
       "namespace {\n";
@@ -444,20 +1048,293 @@ namespace {
     out << "  " << value_names[value_names.size()-1] << "_ = " << value_names.size()-1 << '\n';
     out << "};\n\n";
 
-    std::vector<std::size_t> index;
-    std::vector<std::uint16_t> values;
-    std::size_t shift;
-    splitbins(break_values, index, values, shift);
+    print_table(out, break_values, "breaks", db);
+
+    // The loader (data.c++) checks that a data file uses the same values
+    print_names(out, value_names, "breaks_names", db);
+
+    out << "} // namespace\n\n#endif\n";
+    return true;
+  }
+
+  /// Index of the General_Category value name in data_format::properties::general_category_names.
+  std::uint16_t
+  general_category(std::string const &name) {
+    using namespace libuni::data_format::properties;
+    for(std::size_t i = 0; i < general_categories; ++i) {
+      if(name == general_category_names[i]) {
+        return i;
+      }
+    }
+    std::cerr << "WARNING: Unknown General_Category `" << name << "'\n";
+    return 0;
+  }
+
+  /// Adds the Script of each code point listed in Scripts.txt (in) to props and its name to script_names.
+  void
+  read_scripts(std::istream &in, std::vector<std::uint16_t> &props, std::vector<std::string> &script_names) {
+    using namespace libuni::data_format::properties;
+    for(boost::optional<std::vector<std::string>> line; in; line = parse_line(in)) {
+      if(not line or line->size() < 2) {
+        continue;
+      }
+      std::uint16_t const script = insert_unique(script_names, (*line)[1]);
+      assign_codepoint((*line)[0], props, std::uint16_t(script << script_shift));
+    }
+  }
+
+  /**
+   * Adds Script (Scripts.txt) and the Cased and Alphabetic properties (DerivedCoreProperties.txt) to
+   * props, which contains the General_Category of each code point (see data_format::properties).
+   * Without DerivedCoreProperties.txt the properties are approximated by the General_Category
+   * (without the Other_Lowercase, Other_Uppercase and Other_Alphabetic code points).
+   */
+  inline
+  bool
+  character_properties(data_file &db, std::vector<std::uint16_t> &props) {
+    using namespace libuni::data_format::properties;
+    std::vector<std::string> script_names(1, "Unknown");
+    std::ifstream in(UCD_PATH "Scripts" UCD_VERSION ".txt");
+    if(not in) {
+      std::cerr << "WARNING: Failed to open: `" UCD_PATH "Scripts" UCD_VERSION ".txt' (Script is Unknown)\n";
+    }
+    read_scripts(in, props, script_names);
+    in.close();
+
+    in.open(UCD_PATH "DerivedCoreProperties" UCD_VERSION ".txt");
+    if(in) {
+      for(boost::optional<std::vector<std::string>> line; in; line = parse_line(in)) {
+        if(not line or line->size() != 2) {
+          continue;
+        }
+        else if((*line)[1] == "Cased") {
+          assign_codepoint((*line)[0], props, std::uint16_t(cased));
+        }
+        else if((*line)[1] == "Alphabetic") {
+          assign_codepoint((*line)[0], props, std::uint16_t(alphabetic));
+        }
+      }
+    }
+    else {
+      std::cerr << "WARNING: Failed to open: `" UCD_PATH "DerivedCoreProperties" UCD_VERSION ".txt' "
+        "(Cased and Alphabetic are derived from the General_Category)\n";
+      std::uint16_t const Lu = general_category("Lu"), Lt = general_category("Lt"), Lo = general_category("Lo");
+      std::uint16_t const Nl = general_category("Nl");
+      for(auto i = props.begin(); i != props.end(); ++i) {
+        std::uint16_t const gc = *i & category_mask;
+        if(Lu <= gc and gc <= Lt) {
+          *i |= cased;
+        }
+        if((Lu <= gc and gc <= Lo) or gc == Nl) {
+          *i |= alphabetic;
+        }
+      }
+    }
+
+    std::ofstream out(OUTDIR "property_database.hpp");
+    if(not out) {
+      std::cerr << "Failed to open: `" OUTDIR "property_database.hpp'\n";
+      return false;
+    }
+    out <<
+      "#ifndef LIBUNI_GENERATED_PROPERTY_DATABASE_HPP\n"
+      "#define LIBUNI_GENERATED_PROPERTY_DATABASE_HPP\n\n"
+      "//This file is autogenerated by create_two_stage_table.c++\n\n"
+      "#include <libuni/codepoint.hpp>\n"
+      "#include <libuni/lookup_table.hpp>\n"
+      "#include <cstdint>\n\n"
+      "namespace {\n";
+
+    // lookup_properties gathers from the BMP stage of this layout (see properties.c++)
+    print_table(out, props, "properties", db, 0, "bmp_trie");
+    print_names(out, script_names, "script_names", db);
+
+    out << "} // namespace\n\n#endif\n";
+    return true;
+  }
+
+  /// Base of the implicit weights (UCA 10.1.3) of a unified ideograph or 0.
+  inline
+  std::uint32_t
+  implicit_weight_base(codepoint_t cp, std::string const &name, std::string const &decomp_mapping) {
+    bool const unified =
+      name.compare(0, 22, "CJK UNIFIED IDEOGRAPH-") == 0 or name.compare(0, 14, "<CJK Ideograph") == 0 or
+      (name.compare(0, 28, "CJK COMPATIBILITY IDEOGRAPH-") == 0 and decomp_mapping.empty()); // FA0E, FA0F, FA11, ...
+    if(not unified) {
+      return 0;
+    }
+    else if((0x4E00 <= cp and cp <= 0x9FFF) or (0xF900 <= cp and cp <= 0xFAFF)) { // Core Han
+      return 0xFB40;
+    }
+    else {
+      return 0xFB80;
+    }
+  }
+
+  /// Packs the collation elements of an allkeys.txt entry, e.g., "[.1FA1.0020.0008][.0000.0025.0002]".
+  bool
+  parse_collation_elements(std::string const &str, std::vector<std::uint32_t> &ces) {
+    using namespace libuni::data_format::collation;
+    ces.clear();
+    for(std::string::size_type i = str.find('['); i != std::string::npos; i = str.find('[', i)) {
+      std::string::size_type const end = str.find(']', i);
+      if(end == std::string::npos or end < i + 2) {
+        return false;
+      }
+      std::uint32_t weights[3] = { 0, 0, 0 };
+      std::string::size_type from = i + 2;
+      for(std::size_t w = 0; w < 3 and from <= end; ++w) {
+        std::string::size_type const to = std::min(str.find('.', from), end);
+        weights[w] = string_to_codepoint(str.begin() + from, str.begin() + to);
+        from = to + 1;
+      }
+      if(weights[0] > 0xFFFF or weights[1] > 0x1FF or weights[2] > 0x1F) {
+        return false;
+      }
+      ces.push_back(weights[0] << primary_shift | weights[1] << secondary_shift | weights[2] << tertiary_shift |
+                    (str[i + 1] == '*' ? variable : 0));
+      i = end;
+    }
+    return not ces.empty();
+  }
+
+  /**
+   * Reads the Default Unicode Collation Element Table (allkeys.txt).  collation_index has to contain
+   * the implicit weights of the unified ideographs (see implicit_weight_base).  Without allkeys.txt
+   * the tables are empty and the version is "".
+   */
+  inline
+  bool
+  collation(data_file &db, std::vector<std::uint32_t> &collation_index) {
+    using namespace libuni::data_format::collation;
+    std::ifstream in(UCA_PATH "allkeys.txt");
+    std::string version = "unknown";
+    if(not in) {
+      std::cerr << "WARNING: Failed to open: `" UCA_PATH "allkeys.txt' (every code point gets an implicit weight,"
+        " see http://www.unicode.org/Public/UCA/)\n";
+      version.clear();
+    }
+    std::vector<std::uint32_t> elements;
+    std::vector<std::vector<std::uint32_t>> contractions;
+    std::vector<std::uint32_t> implicit;
+    std::unordered_map<std::vector<std::uint32_t>, std::size_t, decomp_hash> elements_cache;
+    std::vector<std::uint32_t> ces;
+    for(boost::optional<std::vector<std::string>> line; in; line = parse_line(in)) {
+      if(not line or line->empty() or (*line)[0].empty()) {
+        continue;
+      }
+      std::string const &key = (*line)[0];
+      if(key.compare(0, 9, "@version ") == 0) {
+        version = create_trimmed_string(key.begin() + 9, key.end());
+        continue;
+      }
+      else if(key.compare(0, 17, "@implicitweights ") == 0 and line->size() == 2) {
+        std::string const range = create_trimmed_string(key.begin() + 17, key.end());
+        std::uint32_t const base = string_to_codepoint((*line)[1]);
+        codepoint_t const first = string_to_codepoint(range.begin(), std::find(range.begin(), range.end(), '.'));
+        assign_codepoint(range, collation_index, base << offset_shift);
+        std::size_t i = 0;
+        while(i < implicit.size() and implicit[i] != base) {
+          i += 2;
+        }
+        if(i == implicit.size()) {
+          implicit.push_back(base);
+          implicit.push_back(first);
+        }
+        implicit[i + 1] = std::min(implicit[i + 1], first); // BBBB is relative to the first range
+        continue;
+      }
+      else if(key[0] == '@' or line->size() < 2) {
+        continue;
+      }
+
+      std::vector<codepoint_t> cps;
+      std::istringstream keyin(key);
+      for(std::string cp; keyin >> cp;) {
+        cps.push_back(string_to_codepoint(cp));
+      }
+      if(not parse_collation_elements((*line)[1], ces) or ces.size() > count_mask or
+         cps.empty() or cps.size() > contraction_length or cps[0] >= codepoint_limit)
+      {
+        std::cerr << "WARNING: Unsupported collation element table entry `" << key << "'\n";
+        continue;
+      }
+      std::pair<decltype(elements_cache.begin()), bool> const j = elements_cache.insert(std::make_pair(ces, elements.size()));
+      if(j.second) {
+        elements.insert(elements.end(), ces.cbegin(), ces.cend());
+      }
+      std::uint32_t const ref = std::uint32_t(j.first->second) << offset_shift | ces.size();
+
+      if(cps.size() == 1) {
+        collation_index[cps[0]] = (collation_index[cps[0]] & has_contractions) | ref;
+      }
+      else {
+        collation_index[cps[0]] |= has_contractions;
+        cps.resize(contraction_length, 0);
+        cps.push_back(ref);
+        contractions.push_back(cps);
+      }
+    }
+    in.close();
+    std::sort(contractions.begin(), contractions.end());
+
+    std::ofstream out(OUTDIR "collation_database.hpp");
+    if(not out) {
+      std::cerr << "Failed to open: `" OUTDIR "collation_database.hpp'\n";
+      return false;
+    }
+    out <<
+      "#ifndef LIBUNI_GENERATED_COLLATION_DATABASE_HPP\n"
+      "#define LIBUNI_GENERATED_COLLATION_DATABASE_HPP\n\n"
+      "//This file is autogenerated by create_two_stage_table.c++\n\n"
+      "#include <libuni/codepoint.hpp>\n"
+      "#include <libuni/lookup_table.hpp>\n"
+      "#include <cstdint>\n\n"
+      "namespace {\n";
+
+    out << "constexpr char collation_version[] = \"" << version << "\";\n\n";
+    db.add_array("collation_version", version + '\0', 1);
 
-    out << "std::size_t const break_shift = " << shift << ";\n\n";
+    print_table(out, collation_index, "collation_index", db);
 
-    out << gettype(index) << " const breaks_index[] = {\n";
-    print_list(out, index);
+    if(elements.empty()) { // no zero-sized arrays (without allkeys.txt)
+      elements.push_back(0);
+    }
+    out << "constexpr std::uint32_t collation_elements[] = {\n";
+    print_list(out, elements);
+    out << "};\n\n";
+    db.add_array("collation_elements", elements, sizeof(std::uint32_t));
+
+    std::vector<std::uint32_t> flat;
+    for(auto i = contractions.cbegin(); i != contractions.cend(); ++i) {
+      flat.insert(flat.end(), i->begin(), i->end());
+    }
+    if(flat.empty()) { // no zero-sized arrays
+      flat.assign(contraction_size, 0);
+    }
+    out << "constexpr std::uint32_t collation_contractions[] = {\n";
+    print_list(out, flat);
     out << "};\n\n";
+    db.add_array("collation_contractions", flat, sizeof(std::uint32_t));
 
-    out << "std::uint16_t const breaks[] = {\n";
-    print_list(out, values);
+    if(implicit.empty()) {
+      implicit.assign(2, 0);
+    }
+    out << "constexpr std::uint32_t collation_implicit[] = {\n";
+    print_list(out, implicit);
     out << "};\n\n";
+    db.add_array("collation_implicit", implicit, sizeof(std::uint32_t));
+
+    std::vector<std::uint32_t> ascii(ascii_size, 0);
+    for(codepoint_t cp = 0; cp < ascii_size; ++cp) {
+      if((collation_index[cp] & (has_contractions | count_mask)) == 1) {
+        ascii[cp] = elements[collation_index[cp] >> offset_shift];
+      }
+    }
+    out << "constexpr std::uint32_t collation_ascii[] = {\n";
+    print_list(out, ascii);
+    out << "};\n\n";
+    db.add_array("collation_ascii", ascii, sizeof(std::uint32_t));
 
     out << "} // namespace\n\n#endif\n";
     return true;
@@ -467,15 +1344,20 @@ namespace {
 #ifndef TEST // This is required by test/test_generate_two_stage_table.c++!
 int
 main() {
-  std::vector<std::uint16_t> qc(0xff0000, 0x0000);
+  std::vector<std::uint16_t> qc(codepoint_limit, 0x0000);
 
-  std::vector<codepoint_t> simple_uppercase_mapping(0xff0000, 0);
-  std::vector<codepoint_t> simple_lowercase_mapping(0xff0000, 0);
-  std::vector<codepoint_t> simple_titlecase_mapping(0xff0000, 0);
+  std::vector<codepoint_t> simple_uppercase_mapping(codepoint_limit, 0);
+  std::vector<codepoint_t> simple_lowercase_mapping(codepoint_limit, 0);
+  std::vector<codepoint_t> simple_titlecase_mapping(codepoint_limit, 0);
 
   std::vector<codepoint_t> decomp_map(1, 0); // decomp_map[0] => 0
-  std::vector<std::size_t> decomp_index(0xff0000, 0x00);
+  std::vector<std::size_t> decomp_index(codepoint_limit, 0x00);
   std::vector<std::string> decomp_prefix(1, "x_none"); // decomp_prefix[0] => no prefix
+  decomp_cache_t decomp_cache;
+
+  std::vector<std::uint32_t> collation_index(codepoint_limit, 0);
+  std::vector<std::uint16_t> properties(codepoint_limit, 0); // General_Category (see character_properties)
+  codepoint_t range_first = 0;
 
   std::ifstream inud(UCD_PATH "UnicodeData" UCD_VERSION ".txt");
   if(not inud) {
@@ -489,13 +1371,36 @@ main() {
 
     // 0 . Codepoint
     codepoint_t const cp = string_to_codepoint((*line)[0]);
+    if(cp >= codepoint_limit) {
+      std::cerr << "WARNING: Code point out of range `" << (*line)[0] << "'\n";
+      continue;
+    }
+
+    // 1. Name: implicit collation weights of unified ideographs (ranges are given by First/Last)
+    std::string const &name = (*line)[1];
+    if(name.size() > 7 and name.compare(name.size() - 7, 7, ", Last>") == 0 and range_first <= cp) {
+      for(codepoint_t c = range_first; c <= cp; ++c) {
+        collation_index[c] = implicit_weight_base(c, name, (*line)[5]) << libuni::data_format::collation::offset_shift;
+      }
+    }
+    else {
+      collation_index[cp] = implicit_weight_base(cp, name, (*line)[5]) << libuni::data_format::collation::offset_shift;
+    }
+    if(name.size() > 8 and name.compare(name.size() - 8, 8, ", First>") == 0) {
+      range_first = cp;
+    }
+
+    // 2. General_Category
+    std::uint16_t const gc = general_category((*line)[2]);
+    bool const last = name.size() > 7 and name.compare(name.size() - 7, 7, ", Last>") == 0 and range_first <= cp;
+    std::fill(properties.begin() + (last ? range_first : cp), properties.begin() + cp + 1, gc);
 
     // 3. Canonical Combining Class
     std::uint8_t const combining_class = std::stoul((*line)[3]);
     qc[cp] |= std::uint16_t(combining_class) << 8;
 
     // 5. Decomposition_Type and Decomposition_Mapping
-    handle_decomp_mapping(cp, (*line)[5], decomp_index, decomp_map, decomp_prefix);
+    handle_decomp_mapping(cp, (*line)[5], decomp_index, decomp_map, decomp_prefix, decomp_cache);
 
     // 12. Simple Uppercase Mapping
     simple_uppercase_mapping[cp] = string_to_codepoint((*line)[12]);
@@ -514,6 +1419,9 @@ main() {
     std::cerr << "Failed to open: `" UCD_PATH "DerivedNormalizationProps" UCD_VERSION ".txt'\n";
     return 1;
   }
+  std::string first_line;
+  std::getline(in, first_line);
+  std::string const unicode_version = ucd_version(first_line);
   for(boost::optional<std::vector<std::string>> line; in; line = parse_line(in)) {
     if(not line) {
       continue;
@@ -528,8 +1436,8 @@ main() {
         value = No;
         break;
       case 'M':
-        break;
         value = Maybe;
+        break;
       }
 
       std::string const &type = (*line)[1];
@@ -546,6 +1454,9 @@ main() {
       else if(type == "NFKC_QC") {
         shift = 6;
       }
+      else { // FC_NFKC, NFKC_CF, ...
+        continue;
+      }
 
       assign_codepoint((*line)[0], qc, value << shift);
     }
@@ -561,46 +1472,34 @@ main() {
     "#define LIBUNI_GENERATED_NORMALIZATION_DATABASE_HPP\n\n"
     "//This file is autogenerated by create_two_stage_table.c++\n\n"
     "#include <libuni/codepoint.hpp>\n"
+    "#include <libuni/lookup_table.hpp>\n"
     "#include <cstdint>\n\n"
     "namespace {\n";
 
-  // Quick Check
-  std::vector<std::size_t> t1;
-  std::vector<std::uint16_t> t2;
-  std::size_t shift;
-  splitbins(qc, t1, t2, shift);
-
-  out << "std::size_t const quick_check_shift = " << shift << ";\n\n";
+  data_file db;
 
-  out << gettype(t1) << " const quick_check_index[] = {\n";
-  print_list(out, t1);
-  out << "};\n\n"; 
+  out << "constexpr char unicode_version[] = \"" << unicode_version << "\";\n\n";
 
-  out << "std::uint16_t const quick_check[] = {\n";
-  print_list(out, t2);
-  out << "};\n\n";
+  // Quick Check
+  print_table(out, qc, "quick_check", db);
 
   // Decomp
-  out << "libuni::codepoint_t const decomp_map[] = {\n";
+  out << "constexpr libuni::codepoint_t decomp_map[] = {\n";
   print_list(out, decomp_map);
   out << "};\n\n";
-
-  qc.clear(); // free memory
-  t2.clear();
-  std::vector<std::size_t> decomp_index2;
-  splitbins(decomp_index, t1, decomp_index2, shift);
-
-  out << "std::size_t const decomp_shift = " << shift << ";\n\n";
-
-  out << gettype(t1) << " const decomp_index1[] = {\n";
-  print_list(out, t1);
+  db.add_array("decomp_map", decomp_map, sizeof(codepoint_t));
+
+  // Canonical Composition: the primary composites (canonical decompositions of two code points,
+  // excluding the Full_Composition_Exclusion ones, which are exactly those with NFC_QC=No)
+  std::vector<std::uint32_t> composition_map;
+  composition(qc, decomp_index, decomp_map, composition_map);
+  out << "constexpr std::uint32_t composition_map[] = {\n";
+  print_list(out, composition_map);
   out << "};\n\n";
-  t1.clear();
+  db.add_array("composition_map", composition_map, sizeof(std::uint32_t));
 
-  out << gettype(decomp_index2) << " const decomp_index2[] = {\n";
-  print_list(out, decomp_index2);
-  out << "};\n\n";
-  decomp_index2.clear();
+  qc.clear(); // free memory
+  print_table(out, decomp_index, "decomp_index", db, 2); // indices into decomp_map
 
   out << "} // namespace\n\n#endif\n";
   out.close();
@@ -620,20 +1519,36 @@ main() {
     "#define LIBUNI_GENERATED_CASE_DATABASE_HPP\n\n"
     "//This file is autogenerated by create_two_stage_table.c++\n\n"
     "#include <libuni/codepoint.hpp>\n"
+    "#include <libuni/lookup_table.hpp>\n"
     "#include <cstdint>\n\n"
     "namespace {\n";
 
-  print_case_mapping(out, simple_uppercase_mapping, "simple_uppercase_mapping");
+  print_table(out, simple_uppercase_mapping, "simple_uppercase_mapping", db);
   simple_uppercase_mapping.clear();
-  print_case_mapping(out, simple_lowercase_mapping, "simple_lowercase_mapping");
+  print_table(out, simple_lowercase_mapping, "simple_lowercase_mapping", db);
   simple_lowercase_mapping.clear();
-  print_case_mapping(out, simple_titlecase_mapping, "simple_titlecase_mapping");
+  print_table(out, simple_titlecase_mapping, "simple_titlecase_mapping", db);
   simple_titlecase_mapping.clear();
 
   out << "} // namespace\n\n#endif\n";
 
   // Text Segmentation (GraphemeBreak, LineBreak, SentenceBreak, WordBreak)
-  if(not text_segmentation()) {
+  if(not text_segmentation(db)) {
+    return 1;
+  }
+
+  // General_Category, Script, Cased and Alphabetic
+  if(not character_properties(db, properties)) {
+    return 1;
+  }
+  properties.clear();
+
+  // Unicode Collation Algorithm (DUCET)
+  if(not collation(db, collation_index)) {
+    return 1;
+  }
+
+  if(not db.write(OUTDIR "libuni.dat", unicode_version)) {
     return 1;
   }
 }
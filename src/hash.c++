@@ -0,0 +1,58 @@
+#include <libuni/hash.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace libuni { namespace helper {
+  namespace hashing {
+    /// Loads 8 bytes in little-endian order.
+    inline
+    std::uint64_t
+    load64(char8_t const *p) {
+      std::uint64_t w;
+      std::memcpy(&w, p, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      w = __builtin_bswap64(w);
+#endif
+      return w;
+    }
+  }
+
+  void
+  hash_bytes(hash_state &s, char8_t const *p, std::size_t n) {
+    s.length += n;
+    while(s.tail_size != 0 and n != 0) { // complete the tail first
+      s.tail |= std::uint64_t(*p++) << (8 * s.tail_size);
+      --n;
+      if(++s.tail_size == 8) {
+        s.h = hash_mix(s.h, s.tail);
+        s.tail = 0;
+        s.tail_size = 0;
+      }
+    }
+    std::uint64_t h = s.h;
+    for(; n >= 8; n -= 8, p += 8) {
+      h = hash_mix(h, hashing::load64(p));
+    }
+    s.h = h;
+    for(; n != 0; --n) {
+      s.tail |= std::uint64_t(*p++) << (8 * s.tail_size++);
+    }
+  }
+
+  std::size_t
+  hash_final(hash_state const &s) {
+    std::uint64_t h = s.h;
+    if(s.tail_size != 0) {
+      h = hash_mix(h, s.tail);
+    }
+    h ^= s.length;
+    // fmix64 of MurmurHash3
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+  }
+}}
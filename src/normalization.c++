@@ -1,26 +1,26 @@
 #include <libuni/normalization.hpp>
-#include "generated/normalization_database.hpp"
+#include "database.hpp"
+#include "data_format.hpp"
 
 #include <cstdint>
 
 namespace libuni { namespace helper {
   std::uint16_t
   get_quick_check(codepoint_t cp) {
-    std::size_t const index = quick_check_index[cp >> quick_check_shift];
-    return quick_check[(index << quick_check_shift) + (cp & ( (1 << quick_check_shift) - 1))];
+    return database::active.quick_check.lookup(cp);
   }
 
   bool
   get_decomp_mapping(codepoint_t cp, std::size_t &prefix, codepoint_t const *&begin, codepoint_t const *&end) {
-    std::size_t const index1 = decomp_index1[cp >> decomp_shift];
-    std::size_t const index = decomp_index2[ (index1 << decomp_shift) + (cp & ( (1 << decomp_shift) - 1)) ];
+    std::size_t const index = database::active.decomp_index.lookup(cp);
 
-    assert(index < sizeof(decomp_map)/sizeof(decomp_map[0]));
+    assert(index < database::active.decomp_map_size);
 
     if(index == 0) {
       return false;
     }
     else {
+      codepoint_t const *decomp_map = database::active.decomp_map;
       codepoint_t const info = decomp_map[index];
       prefix = info & 0xFF;
       std::size_t const len = (info >> 8) & 0xFF;
@@ -29,4 +29,64 @@ namespace libuni { namespace helper {
       return true;
     }
   }
+
+  codepoint_t
+  get_composition(codepoint_t first, codepoint_t second) {
+    if(hangul::LBase <= first and first < hangul::LBase + hangul::LCount and
+       hangul::VBase <= second and second < hangul::VBase + hangul::VCount) { // LV
+      return hangul::SBase + ((first - hangul::LBase) * hangul::VCount + second - hangul::VBase) * hangul::TCount;
+    }
+    else if(hangul::SBase <= first and first < hangul::SBase + hangul::SCount and
+            (first - hangul::SBase) % hangul::TCount == 0 and
+            hangul::TBase < second and second < hangul::TBase + hangul::TCount) { // LV + T
+      return first + second - hangul::TBase;
+    }
+
+    std::size_t const size = data_format::composition_size;
+    std::uint32_t const *const begin = database::active.composition_map;
+    std::size_t lo = 0, hi = database::active.composition_map_size / size;
+    while(lo < hi) {
+      std::size_t const mid = (lo + hi) / 2;
+      std::uint32_t const *const record = begin + mid * size;
+      if(record[0] < first or (record[0] == first and record[1] < second)) {
+        lo = mid + 1;
+      }
+      else {
+        hi = mid;
+      }
+    }
+    std::uint32_t const *const record = begin + lo * size;
+    if(lo * size < database::active.composition_map_size and record[0] == first and record[1] == second) {
+      return record[2];
+    }
+    return 0;
+  }
+
+  std::size_t
+  compose(codepoint_t *begin, codepoint_t *end) {
+    // Canonical Composition Algorithm (D117)
+    codepoint_t *starter = 0x0; // last starter, if nothing blocks it
+    std::uint8_t last_class = 0;
+    codepoint_t *out = begin;
+    for(codepoint_t *i = begin; i != end; ++i) {
+      codepoint_t const cp = *i;
+      std::uint16_t const qc = get_quick_check(cp);
+      std::uint8_t const canonical_class = get_canonical_class(qc);
+      // only code points with NFC_QC=Maybe can be the second one of a primary composite
+      if(starter and is_allowed<NFC>(qc) == Maybe and
+         (last_class < canonical_class or (last_class == 0 and out - 1 == starter))) {
+        if(codepoint_t const composite = get_composition(*starter, cp)) {
+          LIBUNI_STATS_COUNT(compositions);
+          *starter = composite;
+          continue;
+        }
+      }
+      if(canonical_class == 0) {
+        starter = out;
+      }
+      last_class = canonical_class;
+      *out++ = cp;
+    }
+    return out - begin;
+  }
 }}
@@ -0,0 +1,145 @@
+#include <libuni/properties.hpp>
+#include <libuni/simd.hpp>
+#include "database.hpp"
+#include "data_format.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LIBUNI_SIMD_X86 1
+#endif
+
+namespace libuni {
+  namespace helper { namespace property_lookup {
+    static_assert(sizeof(character_properties) == sizeof(std::uint16_t), "lookup_properties stores 16 bit values");
+    static_assert(general_categories == data_format::properties::general_categories,
+                  "general_category has to match data_format::properties::general_category_names");
+    static_assert(data_format::properties::category_mask == 0x1F and data_format::properties::cased == 0x20 and
+                  data_format::properties::alphabetic == 0x40 and data_format::properties::script_shift == 8,
+                  "character_properties has to match data_format::properties");
+
+    LIBUNI_LINKAGE
+    void
+    lookup_portable(codepoint_t const *p, std::size_t n, character_properties *out) {
+      for(std::size_t i = 0; i < n; ++i) {
+        out[i].bits = database::active.properties.lookup(p[i]);
+      }
+    }
+
+#ifdef LIBUNI_SIMD_X86
+    /** Returns base[i] for each of the eight indices.  Gathers the aligned 32 bit words containing
+     * the elements.  The generator aligns the arrays and pads them to whole words (data::load checks
+     * the padding), so these words are part of the array.
+     */
+    template<typename T>
+    __attribute__((target("avx2")))
+    __m256i
+    gather(T const *base, __m256i i) {
+      std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(base);
+      int const *const words = reinterpret_cast<int const*>(address & ~std::uintptr_t(3));
+      __m256i const bytes = _mm256_add_epi32(_mm256_slli_epi32(i, sizeof(T) == 1 ? 0 : sizeof(T) == 2 ? 1 : 2),
+                                             _mm256_set1_epi32(address & 3));
+      __m256i const w = _mm256_i32gather_epi32(words, _mm256_srli_epi32(bytes, 2), 4);
+      if(sizeof(T) == 4) {
+        return w;
+      }
+      __m256i const shift = _mm256_slli_epi32(_mm256_and_si256(bytes, _mm256_set1_epi32(3)), 3);
+      return _mm256_and_si256(_mm256_srlv_epi32(w, shift), _mm256_set1_epi32(0xFFFFFFFFu >> (32 - 8 * sizeof(T))));
+    }
+
+    /** Gathers the BMP stage of the trie (bmp_index, data) and, if the eight code points contain
+     * supplementary ones, the other stages (index1, index2, data) as well.
+     */
+    template<typename BmpIndex, typename Index1, typename Index2, typename T>
+    __attribute__((target("avx2")))
+    void
+    lookup_avx2(bmp_trie<BmpIndex, Index1, Index2, T> const &t, codepoint_t const *p, std::size_t n,
+                character_properties *out)
+    {
+      __m256i const bmp_max = _mm256_set1_epi32(0xFFFF);
+      __m256i const offset_mask = _mm256_set1_epi32((1 << bmp_trie_shift) - 1);
+      __m256i const block_mask = _mm256_set1_epi32((1 << t.shift) - 1);
+      __m256i const shift = _mm256_set1_epi32(t.shift);
+      std::size_t i = 0;
+      for(; i + 8 <= n; i += 8) {
+        __m256i const cp = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+        __m256i const bmp = _mm256_min_epu32(cp, bmp_max);
+        __m256i const offset = _mm256_and_si256(cp, offset_mask);
+        __m256i const block = gather(t.bmp_index, _mm256_srli_epi32(bmp, bmp_trie_shift));
+        __m256i v = gather(t.data, _mm256_add_epi32(block, offset));
+        __m256i const in_bmp = _mm256_cmpeq_epi32(bmp, cp);
+        if(_mm256_movemask_ps(_mm256_castsi256_ps(in_bmp)) != 0xFF) {
+          // clamped to U+10000..U+10FFFF, so every lane has valid indices
+          __m256i const limited = _mm256_min_epu32(_mm256_max_epu32(cp, _mm256_set1_epi32(0x10000)),
+                                                   _mm256_set1_epi32(table_limit - 1));
+          __m256i const s = _mm256_srli_epi32(_mm256_sub_epi32(limited, _mm256_set1_epi32(0x10000)), bmp_trie_shift);
+          __m256i const i1 = gather(t.index1, _mm256_srlv_epi32(s, shift));
+          __m256i const i2 = gather(t.index2, _mm256_add_epi32(_mm256_sllv_epi32(i1, shift), _mm256_and_si256(s, block_mask)));
+          __m256i const sv = gather(t.data, _mm256_add_epi32(_mm256_slli_epi32(i2, bmp_trie_shift), offset));
+          __m256i const valid = _mm256_cmpeq_epi32(limited, cp); // not above U+10FFFF
+          v = _mm256_blendv_epi8(_mm256_and_si256(sv, valid), v, in_bmp);
+        }
+        __m256i const packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+      }
+      for(; i < n; ++i) {
+        out[i].bits = t.lookup(p[i]);
+      }
+    }
+#endif
+  }}
+
+  LIBUNI_LINKAGE
+  character_properties
+  get_properties(codepoint_t cp) {
+    character_properties const ret = { helper::database::active.properties.lookup(cp) };
+    return ret;
+  }
+
+  LIBUNI_LINKAGE
+  void
+  lookup_properties(codepoint_t const *p, std::size_t n, character_properties *out) {
+#ifdef LIBUNI_SIMD_X86
+    if(simd::active_level() >= simd::avx2) {
+      helper::property_lookup::lookup_avx2(helper::database::active.properties, p, n, out);
+      return;
+    }
+#endif
+    helper::property_lookup::lookup_portable(p, n, out);
+  }
+
+  LIBUNI_LINKAGE
+  char const*
+  script_name(script_t s) {
+    char const *name = helper::database::active.script_names;
+    char const *const end = name + helper::database::active.script_names_size;
+    for(; s > 0 and name != end; --s) {
+      name += std::strlen(name) + 1;
+    }
+    return name == end ? 0x0 : name;
+  }
+
+  LIBUNI_LINKAGE
+  bool
+  find_script(char const *name, script_t &s) {
+    for(unsigned i = 0; i <= 0xFF; ++i) {
+      char const *const n = script_name(i);
+      if(not n) {
+        break;
+      }
+      else if(std::strcmp(n, name) == 0) {
+        s = i;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  LIBUNI_LINKAGE
+  char const*
+  general_category_name(general_category::type c) {
+    return c < general_categories ? data_format::properties::general_category_names[c] : 0x0;
+  }
+}
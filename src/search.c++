@@ -0,0 +1,148 @@
+#include <libuni/search.hpp>
+#include <libuni/case.hpp>
+#include <libuni/normalization.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace libuni { namespace helper {
+  namespace folding {
+    /// Appends cp to out unless it is an ignored accent and moves it to its place in canonical order.
+    inline
+    void
+    append(codepoint_t cp, std::size_t begin, std::size_t end, search::options const &opt,
+           std::vector<folded_codepoint> &out)
+    {
+      std::uint8_t const canonical_class = get_canonical_class(get_quick_check(cp));
+      if(canonical_class != 0 and opt.ignore_accents) {
+        return;
+      }
+      folded_codepoint const f = { cp, canonical_class, begin, end };
+      out.push_back(f);
+      if(canonical_class != 0) { // Canonical Ordering Algorithm (D109), one step of an insertion sort
+        for(std::size_t i = out.size() - 1; i > 0 and out[i - 1].canonical_class > canonical_class; --i) {
+          std::swap(out[i - 1], out[i]);
+        }
+      }
+    }
+
+    inline
+    codepoint_t
+    case_fold(codepoint_t cp) {
+      return lowercase_mapping(uppercase_mapping(cp));
+    }
+  }
+
+  std::size_t
+  fold(codepoint_t cp, std::size_t begin, std::size_t end, search::options const &opt,
+       std::vector<folded_codepoint> &out)
+  {
+    if(cp < 0x80) { // no decomposition and canonical class 0
+      if(opt.ignore_case and 'A' <= cp and cp <= 'Z') {
+        cp += 'a' - 'A';
+      }
+      folded_codepoint const f = { cp, 0, begin, end };
+      out.push_back(f);
+      return out.size() - 1;
+    }
+
+    codepoint_t stack[20];
+    std::size_t stacksize = 0;
+    stack[stacksize++] = cp;
+    while(stacksize) {
+      codepoint_t code = stack[--stacksize];
+
+      if(hangul::SBase <= code and code < hangul::SBase + hangul::SCount) { // Hangul Syllable Decomposition
+        codepoint_t const SIndex = code - hangul::SBase;
+        folding::append(hangul::LBase + SIndex / hangul::NCount, begin, end, opt, out);
+        folding::append(hangul::VBase + (SIndex % hangul::NCount) / hangul::TCount, begin, end, opt, out);
+        if(SIndex % hangul::TCount != 0) {
+          folding::append(hangul::TBase + SIndex % hangul::TCount, begin, end, opt, out);
+        }
+        continue;
+      }
+
+      std::size_t prefix;
+      codepoint_t const *mapping_begin = 0x0, *mapping_end = 0x0;
+      if(get_decomp_mapping(code, prefix, mapping_begin, mapping_end) and prefix == 0) {
+        assert(mapping_end - mapping_begin + stacksize < sizeof(stack)/sizeof(stack[0]));
+        while(mapping_end != mapping_begin) {
+          stack[stacksize++] = *--mapping_end;
+        }
+        continue;
+      }
+
+      if(opt.ignore_case) {
+        codepoint_t const folded = folding::case_fold(code);
+        if(folded != code and get_decomp_mapping(folded, prefix, mapping_begin, mapping_end) and prefix == 0) {
+          // the case folding of a decomposed code point is not necessarily decomposed
+          assert(mapping_end - mapping_begin + stacksize < sizeof(stack)/sizeof(stack[0]));
+          while(mapping_end != mapping_begin) {
+            stack[stacksize++] = *--mapping_end;
+          }
+          continue;
+        }
+        code = folded;
+      }
+      folding::append(code, begin, end, opt, out);
+    }
+
+    std::size_t last_starter = out.size();
+    while(last_starter > 0 and out[last_starter - 1].canonical_class != 0) {
+      --last_starter;
+    }
+    return last_starter == 0 ? 0 : last_starter - 1;
+  }
+
+  void
+  prepare(codepoint_t const *begin, codepoint_t const *end, folded_pattern &p) {
+    std::vector<folded_codepoint> folded;
+    for(; begin != end; ++begin) {
+      fold(*begin, 0, 0, p.opt, folded);
+    }
+    p.cps.clear();
+    for(std::vector<folded_codepoint>::const_iterator i = folded.begin(); i != folded.end(); ++i) {
+      p.cps.push_back(i->cp);
+    }
+
+    // Horspool's bad character shift.  Code points sharing the low byte share an entry, which
+    // only makes the shift smaller.
+    std::size_t const m = p.cps.size();
+    std::fill(p.shift, p.shift + 256, m);
+    for(std::size_t j = 0; j + 1 < m; ++j) {
+      p.shift[p.cps[j] & 0xFF] = m - 1 - j;
+    }
+  }
+
+  bool
+  horspool(folded_pattern const &p, std::vector<folded_codepoint> const &text, std::size_t &pos,
+           std::size_t final, std::size_t &match_begin, std::size_t &match_end)
+  {
+    std::size_t const m = p.cps.size();
+    assert(m > 0 and final <= text.size());
+    codepoint_t const *const pattern = p.cps.data();
+    while(pos + m <= final) {
+      codepoint_t const last = text[pos + m - 1].cp;
+      if(last == pattern[m - 1]) {
+        std::size_t j = m - 1;
+        while(j > 0 and text[pos + j - 1].cp == pattern[j - 1]) {
+          --j;
+        }
+        // a match must not end in front of a non-starter which belongs to its last character
+        if(j == 0 and (pos + m == text.size() or text[pos + m].canonical_class == 0)) {
+          match_begin = text[pos].begin;
+          match_end = text[pos].end;
+          for(std::size_t k = pos + 1; k < pos + m; ++k) {
+            match_begin = std::min(match_begin, text[k].begin);
+            match_end = std::max(match_end, text[k].end);
+          }
+          return true;
+        }
+      }
+      pos += p.shift[last & 0xFF];
+    }
+    return false;
+  }
+}}
@@ -1,5 +1,5 @@
 #include <libuni/segmentation.hpp>
-#include "generated/segmentation_database.hpp"
+#include "database.hpp"
 
 #include <cstddef>
 
@@ -15,23 +15,24 @@ namespace {
 namespace helper {
   unsigned
   get_word_breaks(codepoint_t cp) {
-    std::size_t const index = breaks_index[cp >> break_shift];
-    std::uint16_t const info = breaks[(index << break_shift) + (cp & ( (1 << break_shift) - 1))];
+    std::uint16_t const info = database::active.breaks.lookup(cp);
     return static_cast<value_names>( (info >> Word) & 0xF );
   }
 }
 
-  unsigned const break_property::None = X_none_;
-  unsigned const break_property::CR = CR_;
-  unsigned const break_property::LF = LF_;
-  unsigned const break_property::Newline = Newline_;
-  unsigned const break_property::Extend = Extend_;
-  unsigned const break_property::Format = Format_;
-  unsigned const break_property::Katakana = Katakana_;
-  unsigned const break_property::ALetter = ALetter_;
-  unsigned const break_property::MidLetter = MidLetter_;
-  unsigned const break_property::MidNum = MidNum_;
-  unsigned const break_property::MidNumLet = MidNumLet_;
-  unsigned const break_property::Numeric = Numeric_;
-  unsigned const break_property::ExtendNumLet = ExtendNumLet_;
+namespace break_property { // internal linkage constants if LIBUNI_HEADER_ONLY (no extern declaration)
+  unsigned const None = X_none_;
+  unsigned const CR = CR_;
+  unsigned const LF = LF_;
+  unsigned const Newline = Newline_;
+  unsigned const Extend = Extend_;
+  unsigned const Format = Format_;
+  unsigned const Katakana = Katakana_;
+  unsigned const ALetter = ALetter_;
+  unsigned const MidLetter = MidLetter_;
+  unsigned const MidNum = MidNum_;
+  unsigned const MidNumLet = MidNumLet_;
+  unsigned const Numeric = Numeric_;
+  unsigned const ExtendNumLet = ExtendNumLet_;
+}
 } // namespace libuni
@@ -0,0 +1,472 @@
+#include <libuni/simd.hpp>
+#include <libuni/utf8.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LIBUNI_SIMD_X86 1
+#endif
+
+namespace libuni {
+  // utf8.hpp includes simd.hpp before it defines next_codepoint (LIBUNI_HEADER_ONLY)
+  namespace utf8 {
+    template<typename I>
+    utf_status
+    next_codepoint(I &i, I end, codepoint_t &cp);
+  }
+
+namespace simd {
+  namespace helper {
+    struct kernels {
+      level l;
+      std::size_t (*ascii_prefix)(char8_t const *p, std::size_t n);
+      std::size_t (*ascii_to_utf32)(char8_t const *p, std::size_t n, codepoint_t *out); // returns the ASCII prefix length
+      std::size_t (*ascii_flip_case)(char8_t *p, std::size_t n, char8_t first); // see ascii_to_lower
+    };
+
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_prefix_portable(char8_t const *p, std::size_t n) {
+      std::size_t i = 0;
+      for(; i + 8 <= n; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        if(w & 0x8080808080808080ull) {
+          break;
+        }
+      }
+      while(i < n and p[i] < 0x80) {
+        ++i;
+      }
+      return i;
+    }
+
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_utf32_portable(char8_t const *p, std::size_t n, codepoint_t *out) {
+      std::size_t i = 0;
+      while(i < n and p[i] < 0x80) {
+        out[i] = p[i];
+        ++i;
+      }
+      return i;
+    }
+
+    /** Flips the case (xor 0x20) of the letters [first, first + 26) in the ASCII prefix of [p, p + n)
+     * and returns the length of the prefix.
+     */
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_flip_case_portable(char8_t *p, std::size_t n, char8_t first) {
+      std::uint64_t const ones = 0x0101010101010101ull;
+      std::uint64_t const high = 0x80 * ones;
+      std::uint64_t const from = (0x80 - first) * ones;   // sets the high bit of bytes >= first
+      std::uint64_t const to = (0x80 - first - 26) * ones; // and of bytes >= first + 26
+      std::size_t i = 0;
+      for(; i + 8 <= n; i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        if(w & high) {
+          break;
+        }
+        std::uint64_t const letters = (w + from) & ~(w + to) & high; // no carries: all bytes < 0x80
+        w ^= letters >> 2;
+        std::memcpy(p + i, &w, 8);
+      }
+      for(; i < n and p[i] < 0x80; ++i) {
+        if(char8_t(p[i] - first) < 26) {
+          p[i] ^= 0x20;
+        }
+      }
+      return i;
+    }
+
+#ifdef LIBUNI_SIMD_X86
+    __attribute__((target("sse4.2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_prefix_sse42(char8_t const *p, std::size_t n) {
+      std::size_t i = 0;
+      for(; i + 16 <= n; i += 16) {
+        int const m = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i)));
+        if(m) {
+          return i + __builtin_ctz(m);
+        }
+      }
+      return i + ascii_prefix_portable(p + i, n - i);
+    }
+
+    __attribute__((target("sse4.2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_utf32_sse42(char8_t const *p, std::size_t n, codepoint_t *out) {
+      std::size_t i = 0;
+      for(; i + 16 <= n; i += 16) {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+        if(_mm_movemask_epi8(v)) {
+          break;
+        }
+        __m128i *const o = reinterpret_cast<__m128i*>(out + i);
+        _mm_storeu_si128(o, _mm_cvtepu8_epi32(v));
+        _mm_storeu_si128(o + 1, _mm_cvtepu8_epi32(_mm_srli_si128(v, 4)));
+        _mm_storeu_si128(o + 2, _mm_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+        _mm_storeu_si128(o + 3, _mm_cvtepu8_epi32(_mm_srli_si128(v, 12)));
+      }
+      return i + ascii_to_utf32_portable(p + i, n - i, out + i);
+    }
+
+    __attribute__((target("sse4.2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_flip_case_sse42(char8_t *p, std::size_t n, char8_t first) {
+      __m128i const before = _mm_set1_epi8(first - 1);
+      __m128i const after = _mm_set1_epi8(first + 26);
+      __m128i const flip = _mm_set1_epi8(0x20);
+      std::size_t i = 0;
+      for(; i + 16 <= n; i += 16) {
+        __m128i *const q = reinterpret_cast<__m128i*>(p + i);
+        __m128i const v = _mm_loadu_si128(q);
+        if(_mm_movemask_epi8(v)) {
+          break;
+        }
+        __m128i const letters = _mm_and_si128(_mm_cmpgt_epi8(v, before), _mm_cmplt_epi8(v, after));
+        _mm_storeu_si128(q, _mm_xor_si128(v, _mm_and_si128(letters, flip)));
+      }
+      return i + ascii_flip_case_portable(p + i, n - i, first);
+    }
+
+    __attribute__((target("avx2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_prefix_avx2(char8_t const *p, std::size_t n) {
+      std::size_t i = 0;
+      for(; i + 32 <= n; i += 32) {
+        unsigned const m = _mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i)));
+        if(m) {
+          return i + __builtin_ctz(m);
+        }
+      }
+      return i + ascii_prefix_sse42(p + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_utf32_avx2(char8_t const *p, std::size_t n, codepoint_t *out) {
+      std::size_t i = 0;
+      for(; i + 32 <= n; i += 32) {
+        if(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i)))) {
+          break;
+        }
+        for(std::size_t j = 0; j < 32; j += 8) {
+          __m128i const v = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p + i + j));
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + j), _mm256_cvtepu8_epi32(v));
+        }
+      }
+      return i + ascii_to_utf32_sse42(p + i, n - i, out + i);
+    }
+
+    __attribute__((target("avx2")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_flip_case_avx2(char8_t *p, std::size_t n, char8_t first) {
+      __m256i const before = _mm256_set1_epi8(first - 1);
+      __m256i const after = _mm256_set1_epi8(first + 26);
+      __m256i const flip = _mm256_set1_epi8(0x20);
+      std::size_t i = 0;
+      for(; i + 32 <= n; i += 32) {
+        __m256i *const q = reinterpret_cast<__m256i*>(p + i);
+        __m256i const v = _mm256_loadu_si256(q);
+        if(_mm256_movemask_epi8(v)) {
+          break;
+        }
+        __m256i const letters = _mm256_and_si256(_mm256_cmpgt_epi8(v, before), _mm256_cmpgt_epi8(after, v));
+        _mm256_storeu_si256(q, _mm256_xor_si256(v, _mm256_and_si256(letters, flip)));
+      }
+      return i + ascii_flip_case_sse42(p + i, n - i, first);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_prefix_avx512(char8_t const *p, std::size_t n) {
+      std::size_t i = 0;
+      for(; i + 64 <= n; i += 64) {
+        __mmask64 const m = _mm512_movepi8_mask(_mm512_loadu_si512(p + i));
+        if(m) {
+          return i + __builtin_ctzll(m);
+        }
+      }
+      return i + ascii_prefix_avx2(p + i, n - i);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_to_utf32_avx512(char8_t const *p, std::size_t n, codepoint_t *out) {
+      std::size_t i = 0;
+      for(; i + 64 <= n; i += 64) {
+        if(_mm512_movepi8_mask(_mm512_loadu_si512(p + i))) {
+          break;
+        }
+        for(std::size_t j = 0; j < 64; j += 16) {
+          __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i + j));
+          // maskz because GCC 12 warns about _mm512_undefined_epi32 in _mm512_cvtepu8_epi32
+          _mm512_storeu_si512(out + i + j, _mm512_maskz_cvtepu8_epi32(0xFFFF, v));
+        }
+      }
+      return i + ascii_to_utf32_avx2(p + i, n - i, out + i);
+    }
+
+    __attribute__((target("avx512f,avx512bw")))
+    LIBUNI_LINKAGE
+    std::size_t
+    ascii_flip_case_avx512(char8_t *p, std::size_t n, char8_t first) {
+      __m512i const base = _mm512_set1_epi8(first);
+      __m512i const count = _mm512_set1_epi8(26);
+      __m512i const flip = _mm512_set1_epi8(0x20);
+      std::size_t i = 0;
+      for(; i + 64 <= n; i += 64) {
+        __m512i const v = _mm512_loadu_si512(p + i);
+        if(_mm512_movepi8_mask(v)) {
+          break;
+        }
+        __mmask64 const letters = _mm512_cmplt_epu8_mask(_mm512_sub_epi8(v, base), count);
+        _mm512_storeu_si512(p + i, _mm512_mask_blend_epi8(letters, v, _mm512_xor_si512(v, flip)));
+      }
+      return i + ascii_flip_case_avx2(p + i, n - i, first);
+    }
+#endif
+
+    LIBUNI_LINKAGE
+    kernels
+    get_kernels(level l) {
+      kernels k;
+      k.l = l;
+      switch(l) {
+#ifdef LIBUNI_SIMD_X86
+      case avx512:
+        k.ascii_prefix = ascii_prefix_avx512;
+        k.ascii_to_utf32 = ascii_to_utf32_avx512;
+        k.ascii_flip_case = ascii_flip_case_avx512;
+        break;
+      case avx2:
+        k.ascii_prefix = ascii_prefix_avx2;
+        k.ascii_to_utf32 = ascii_to_utf32_avx2;
+        k.ascii_flip_case = ascii_flip_case_avx2;
+        break;
+      case sse42:
+        k.ascii_prefix = ascii_prefix_sse42;
+        k.ascii_to_utf32 = ascii_to_utf32_sse42;
+        k.ascii_flip_case = ascii_flip_case_sse42;
+        break;
+#endif
+      default:
+        k.l = portable;
+        k.ascii_prefix = ascii_prefix_portable;
+        k.ascii_to_utf32 = ascii_to_utf32_portable;
+        k.ascii_flip_case = ascii_flip_case_portable;
+      }
+      return k;
+    }
+
+    /// Selects the kernels the first time they are used (LIBUNI_SIMD overrides the detected level).
+    LIBUNI_LINKAGE
+    kernels
+    initial_kernels() {
+      level l = detected_level();
+      char const *const env = std::getenv("LIBUNI_SIMD");
+      if(env and *env) {
+        level forced;
+        if(not parse_level(env, forced)) {
+          std::cerr << "libuni: unknown LIBUNI_SIMD `" << env << "'\n";
+        }
+        else if(forced > l) {
+          std::cerr << "libuni: LIBUNI_SIMD `" << env << "' is not supported by this CPU, using `" << level_name(l) << "'\n";
+        }
+        else {
+          l = forced;
+        }
+      }
+      return get_kernels(l);
+    }
+
+    LIBUNI_LINKAGE
+    kernels&
+    active() {
+      static kernels k = initial_kernels();
+      return k;
+    }
+
+    /// Returns the length of the well-formed sequence (Table 3-7) at p or 0.
+    inline
+    std::size_t
+    sequence_length(char8_t const *p, std::size_t n) {
+      char8_t const c = p[0];
+      std::size_t len;
+      char8_t lo = 0x80, hi = 0xBF; // range of the second byte
+      if(c < 0x80) {
+        return 1;
+      }
+      else if(0xC2 <= c and c <= 0xDF) {
+        len = 2;
+      }
+      else if(0xE0 <= c and c <= 0xEF) {
+        len = 3;
+        if(c == 0xE0) {
+          lo = 0xA0;
+        }
+        else if(c == 0xED) {
+          hi = 0x9F;
+        }
+      }
+      else if(0xF0 <= c and c <= 0xF4) {
+        len = 4;
+        if(c == 0xF0) {
+          lo = 0x90;
+        }
+        else if(c == 0xF4) {
+          hi = 0x8F;
+        }
+      }
+      else {
+        return 0;
+      }
+      if(n < len or p[1] < lo or hi < p[1]) {
+        return 0;
+      }
+      for(std::size_t i = 2; i < len; ++i) {
+        if((p[i] & 0xC0) != 0x80) {
+          return 0;
+        }
+      }
+      return len;
+    }
+  }
+
+  LIBUNI_LINKAGE
+  level
+  detected_level() {
+#ifdef LIBUNI_SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512bw")) {
+      return avx512;
+    }
+    else if(__builtin_cpu_supports("avx2")) {
+      return avx2;
+    }
+    else if(__builtin_cpu_supports("sse4.2")) {
+      return sse42;
+    }
+#endif
+    return portable;
+  }
+
+  LIBUNI_LINKAGE
+  level
+  active_level() {
+    return helper::active().l;
+  }
+
+  LIBUNI_LINKAGE
+  bool
+  set_level(level l) {
+    if(l >= levels or l > detected_level()) {
+      return false;
+    }
+    helper::active() = helper::get_kernels(l);
+    return true;
+  }
+
+  LIBUNI_LINKAGE
+  char const*
+  level_name(level l) {
+    switch(l) {
+    case portable:
+      return "portable";
+    case sse42:
+      return "sse4.2";
+    case avx2:
+      return "avx2";
+    case avx512:
+      return "avx512";
+    default:
+      return "unknown";
+    }
+  }
+
+  LIBUNI_LINKAGE
+  bool
+  parse_level(char const *name, level &l) {
+    for(unsigned i = 0; i < levels; ++i) {
+      if(std::strcmp(name, level_name(level(i))) == 0) {
+        l = level(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  LIBUNI_LINKAGE
+  std::size_t
+  ascii_prefix(char8_t const *p, std::size_t n) {
+    return helper::active().ascii_prefix(p, n);
+  }
+
+  LIBUNI_LINKAGE
+  std::size_t
+  ascii_to_lower(char8_t *p, std::size_t n) {
+    return helper::active().ascii_flip_case(p, n, 'A');
+  }
+
+  LIBUNI_LINKAGE
+  std::size_t
+  ascii_to_upper(char8_t *p, std::size_t n) {
+    return helper::active().ascii_flip_case(p, n, 'a');
+  }
+
+  LIBUNI_LINKAGE
+  bool
+  utf8_is_wellformed(char8_t const *p, std::size_t n) {
+    helper::kernels const &k = helper::active();
+    for(std::size_t i = 0; i < n;) {
+      if(p[i] < 0x80) {
+        i += k.ascii_prefix(p + i, n - i);
+      }
+      else {
+        std::size_t const len = helper::sequence_length(p + i, n - i);
+        if(len == 0) {
+          return false;
+        }
+        i += len;
+      }
+    }
+    return true;
+  }
+
+  LIBUNI_LINKAGE
+  std::size_t
+  utf8_to_utf32(char8_t const *p, std::size_t n, codepoint_t *out) {
+    helper::kernels const &k = helper::active();
+    char8_t const *const end = p + n;
+    codepoint_t *o = out;
+    while(p != end) {
+      if(*p < 0x80) {
+        std::size_t const ascii = k.ascii_to_utf32(p, end - p, o);
+        p += ascii;
+        o += ascii;
+      }
+      else if(utf8::next_codepoint(p, end, *o) == utf_ok) {
+        ++o;
+      }
+      else {
+        break;
+      }
+    }
+    return o - out;
+  }
+}}
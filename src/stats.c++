@@ -0,0 +1,115 @@
+#include <libuni/stats.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace libuni { namespace stats {
+  namespace helper {
+    // Blocks of the running threads and the sum of the exited threads.
+    struct registry {
+      std::mutex mutex;
+      std::vector<thread_stats*> threads;
+      snapshot exited;
+    };
+
+    LIBUNI_LINKAGE
+    registry&
+    get_registry() {
+      static registry r; // zero initialized
+      return r;
+    }
+
+    /// Adds the counts of t since the last reset() to s.  The caller has to hold the mutex of the registry.
+    LIBUNI_LINKAGE
+    void
+    add_to(snapshot &s, thread_stats const &t) {
+      for(std::size_t c = 0; c < counters; ++c) {
+        s.counters[c] += t.counters[c].load(std::memory_order_relaxed) - t.at_reset.counters[c];
+      }
+      for(std::size_t h = 0; h < histograms; ++h) {
+        for(std::size_t b = 0; b < buckets; ++b) {
+          s.histograms[h][b] += t.histograms[h][b].load(std::memory_order_relaxed) - t.at_reset.histograms[h][b];
+        }
+      }
+    }
+
+    LIBUNI_LINKAGE
+    void
+    clear(thread_stats &t) {
+      for(std::size_t c = 0; c < counters; ++c) {
+        t.counters[c].store(0, std::memory_order_relaxed);
+      }
+      for(std::size_t h = 0; h < histograms; ++h) {
+        for(std::size_t b = 0; b < buckets; ++b) {
+          t.histograms[h][b].store(0, std::memory_order_relaxed);
+        }
+      }
+      t.at_reset = snapshot();
+    }
+
+    struct thread_block {
+      thread_stats stats;
+
+      thread_block() {
+        clear(stats);
+        registry &r = get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(&stats);
+      }
+
+      ~thread_block() {
+        registry &r = get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        add_to(r.exited, stats);
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), &stats));
+      }
+    };
+
+    LIBUNI_LINKAGE
+    thread_stats&
+    local() {
+      static thread_local thread_block block;
+      return block.stats;
+    }
+  }
+
+  LIBUNI_LINKAGE
+  snapshot
+  get() {
+    helper::registry &r = helper::get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    snapshot s = r.exited;
+    for(auto i = r.threads.begin(); i != r.threads.end(); ++i) {
+      helper::add_to(s, **i);
+    }
+    return s;
+  }
+
+  LIBUNI_LINKAGE
+  snapshot
+  get_thread() {
+    helper::thread_stats &t = helper::local();
+    helper::registry &r = helper::get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    snapshot s = snapshot();
+    helper::add_to(s, t);
+    return s;
+  }
+
+  LIBUNI_LINKAGE
+  void
+  reset() {
+    helper::registry &r = helper::get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.exited = snapshot();
+    // Setting the counters to zero could race with the load and store of helper::add, which would
+    // write the old count back.  Remember the current counts instead (add_to subtracts them).
+    for(auto i = r.threads.begin(); i != r.threads.end(); ++i) {
+      snapshot now = snapshot();
+      (*i)->at_reset = snapshot();
+      helper::add_to(now, **i);
+      (*i)->at_reset = now;
+    }
+  }
+}}
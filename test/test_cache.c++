@@ -0,0 +1,131 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/cache.hpp>
+
+#include <libuni/utf8.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace libuni;
+
+namespace {
+  std::string const words[] = {
+    "Re\xCC\x81sume\xCC\x81",        // NFD of Résumé
+    "R\xC3\xA9sum\xC3\xA9",          // NFC
+    "\xEF\xAC\x81le \xE2\x84\xAB",   // ﬁle Å (compatibility characters)
+    "H\xC3\x96LLE",
+    "plain ascii",
+    "PLAIN ASCII",
+    std::string(200, 'A')            // too long to be cached
+  };
+  std::size_t const word_count = sizeof(words) / sizeof(words[0]);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_results) {
+  normalization_cache cache(64, 4);
+  for(std::size_t round = 0; round < 3; ++round) { // computed, then cached
+    for(std::size_t i = 0; i < word_count; ++i) {
+      std::string const &w = words[i];
+      BOOST_CHECK_EQUAL(cache.toNFD(w), toNFD(w));
+      BOOST_CHECK_EQUAL(cache.toNFKD(w), toNFKD(w));
+      BOOST_CHECK_EQUAL(cache.toNFC(w), toNFC(w));
+      BOOST_CHECK_EQUAL(cache.toNFKC(w), toNFKC(w));
+      BOOST_CHECK_EQUAL(cache.toLowercase(w), toLowercase(w));
+      BOOST_CHECK_EQUAL(cache.toUppercase(w), toUppercase(w));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_stats) {
+  normalization_cache cache;
+  std::string const decomposed = "Re\xCC\x81sume\xCC\x81";
+  cache.toNFC(decomposed);
+  cache.toNFC(decomposed);
+  cache.toNFC(toNFC(decomposed)); // the quick check says it is NFC
+  cache.toNFD(decomposed);
+  cache.toLowercase(std::string(200, 'A'));
+  cache_stats s = cache.stats();
+  BOOST_CHECK_EQUAL(s.misses, 1u);
+  BOOST_CHECK_EQUAL(s.hits, 1u);
+  BOOST_CHECK_EQUAL(s.bypasses, 2u);
+  BOOST_CHECK_EQUAL(s.uncached, 1u);
+  BOOST_CHECK_EQUAL(s.evictions, 0u);
+
+  cache.clear();
+  BOOST_CHECK_EQUAL(cache.toNFC(decomposed), toNFC(decomposed));
+  BOOST_CHECK_EQUAL(cache.stats().misses, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_eviction) {
+  normalization_cache cache(4, 1); // a single set
+  std::vector<std::string> keys;
+  for(char c = 'A'; c <= 'Z'; ++c) {
+    keys.push_back(std::string("key ") + c);
+  }
+  for(std::size_t i = 0; i < keys.size(); ++i) {
+    BOOST_CHECK_EQUAL(cache.toLowercase(keys[i]), toLowercase(keys[i]));
+  }
+  cache_stats const s = cache.stats();
+  BOOST_CHECK_EQUAL(s.misses, keys.size());
+  BOOST_CHECK_EQUAL(s.evictions, keys.size() - 4);
+
+  // a referenced slot survives the next eviction
+  BOOST_CHECK_EQUAL(cache.toLowercase(keys[25]), "key z");
+  BOOST_CHECK_EQUAL(cache.toLowercase(keys[0]), "key a"); // evicts one of the others
+  BOOST_CHECK_EQUAL(cache.toLowercase(keys[25]), "key z");
+  BOOST_CHECK_EQUAL(cache.stats().hits, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_threads) {
+  normalization_cache cache(16, 2); // small: inserts evict what other threads read
+  std::vector<std::string> keys;
+  for(std::size_t i = 0; i < 64; ++i) {
+    keys.push_back(std::string("Re\xCC\x81sume\xCC\x81 ") + std::string(i % 40, 'X') + char('a' + i % 26));
+  }
+  bool ok[4] = { true, true, true, true };
+  std::vector<std::thread> threads;
+  for(std::size_t t = 0; t < 4; ++t) {
+    threads.push_back(std::thread([&keys, &cache, &ok, t]() {
+      for(std::size_t round = 0; round < 200; ++round) {
+        for(std::size_t i = 0; i < keys.size(); ++i) {
+          std::string const &k = keys[(i * 7 + t) % keys.size()];
+          if(cache.toNFC(k) != toNFC(k) or cache.toUppercase(k) != toUppercase(k)) {
+            ok[t] = false;
+          }
+        }
+      }
+    }));
+  }
+  for(std::size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+  for(std::size_t t = 0; t < 4; ++t) {
+    BOOST_CHECK(ok[t]);
+  }
+  cache_stats const s = cache.stats();
+  BOOST_CHECK_EQUAL(s.hits + s.misses + s.bypasses + s.uncached, 4u * 200 * 64 * 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_cache_layout) {
+  BOOST_CHECK_EQUAL(sizeof(helper::cache_slot), 3 * helper::cache_line);
+  BOOST_CHECK_EQUAL(sizeof(helper::cache_counters), helper::cache_line);
+  BOOST_CHECK_EQUAL(sizeof(helper::cache_shard) % helper::cache_line, 0u);
+  for(std::size_t n = 1; n < 5; ++n) {
+    helper::cache_aligned_array<helper::cache_slot> slots;
+    slots.reset(n);
+    BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(&slots[0]) % helper::cache_line, 0u);
+    BOOST_CHECK_EQUAL(slots[n - 1].tag.load(), 0u);
+  }
+
+  // every thread keeps its stripe, consecutive threads get different ones
+  std::size_t const mine = helper::cache_stripe();
+  BOOST_CHECK_EQUAL(helper::cache_stripe(), mine);
+  std::size_t other = mine;
+  std::thread([&other]() { other = helper::cache_stripe(); }).join();
+  BOOST_CHECK_NE(other, mine);
+}
@@ -11,6 +11,7 @@ BOOST_AUTO_TEST_CASE(test_uppercase_mapping) {
   BOOST_CHECK_EQUAL(libuni::uppercase_mapping(0x61), 0x41); // a -> A
   BOOST_CHECK_EQUAL(libuni::uppercase_mapping(0x41), 0x41); // A -> A
   BOOST_CHECK_EQUAL(libuni::uppercase_mapping(0xFC), 0xDC); // ü -> Ü
+  BOOST_CHECK_EQUAL(libuni::uppercase_mapping(0x1FFFFF), 0x1FFFFF); // beyond U+10FFFF
 }
 
 BOOST_AUTO_TEST_CASE(test_toUppercase) {
@@ -34,6 +35,85 @@ BOOST_AUTO_TEST_CASE(test_toLowercase) {
   BOOST_CHECK_EQUAL(libuni::toLowercase(std::string("hЁLLÖ WöRLd")), "hёllö wörld");
 }
 
+BOOST_AUTO_TEST_CASE(test_toXcase_unchanged) {
+  // the prefix which does not change is copied, the rest is mapped
+  std::string const lower = "already lowercase text, long enough to be allocated";
+  BOOST_CHECK_EQUAL(libuni::toLowercase(lower), lower);
+  BOOST_CHECK_EQUAL(libuni::toLowercase(lower + "\xC3\x9C"), lower + "\xC3\xBC");
+  BOOST_CHECK_EQUAL(libuni::toLowercase(std::string("abc\xC3")), "abc"); // ill-formed input ends the output
+
+  // an rvalue is moved to the result if nothing changes
+  std::string s = lower;
+  char const *const data = s.data();
+  std::string const t = libuni::toLowercase(std::move(s));
+  BOOST_CHECK_EQUAL(t, lower);
+  BOOST_CHECK(t.data() == data);
+  std::u32string const u = libuni::toUppercase(std::u32string(U"Wörld"));
+  BOOST_CHECK(u == U"WÖRLD");
+}
+
+namespace {
+  /// std::allocator with an id to tell copies apart.
+  template<typename T>
+  struct tagged_allocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+      typedef tagged_allocator<U> other;
+    };
+
+    int id;
+
+    explicit tagged_allocator(int id = 0)
+      : id(id)
+    { }
+
+    template<typename U>
+    tagged_allocator(tagged_allocator<U> const &rhs)
+      : id(rhs.id)
+    { }
+  };
+
+  template<typename T, typename U>
+  bool
+  operator==(tagged_allocator<T> const &lhs, tagged_allocator<U> const &rhs) {
+    return lhs.id == rhs.id;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_toXcase_allocator) {
+  typedef std::basic_string<char, std::char_traits<char>, tagged_allocator<char>> string_t;
+  tagged_allocator<char> const alloc(42);
+  string_t const in("Gr\xC3\xBC\xC3\x9F Gott", alloc);
+  string_t const upper = libuni::toUppercase(in);
+  BOOST_CHECK(upper == string_t("GR\xC3\x9C\xC3\x9F GOTT"));
+  BOOST_CHECK(upper.get_allocator() == alloc);
+  BOOST_CHECK(libuni::toLowercase(in).get_allocator() == alloc);
+  BOOST_CHECK(libuni::toLowercase(string_t("lower", alloc)).get_allocator() == alloc);
+}
+
+BOOST_AUTO_TEST_CASE(test_inplace) {
+  std::string const text[] = {
+    "Hello World, this is a longer ASCII text to get past the SIMD block size!",
+    "H\xD0\x81LL\xC3\x96 W\xC3\xB6RLd \xCE\xA3\xCE\x8A\xCE\xA3\xCE\xA5\xCE\xA6\xCE\x9F\xCE\xA3",
+    "abc \xC8\xBA def", // U+023A lowercase is U+2C65: the encoding grows
+    "ABC \xE2\xB1\xA5 DEF", // U+2C65 uppercase is U+023A: the encoding shrinks
+    "ABC\xC3",
+    ""
+  };
+  for(std::size_t i = 0; i < sizeof(text)/sizeof(*text); ++i) {
+    std::string lower = text[i];
+    libuni::to_lower_inplace(lower);
+    BOOST_CHECK_EQUAL(lower, libuni::toLowercase(text[i]));
+    std::string upper = text[i];
+    libuni::to_upper_inplace(upper);
+    BOOST_CHECK_EQUAL(upper, libuni::toUppercase(text[i]));
+  }
+
+  std::string s = "XY \xC8\xBA Z";
+  BOOST_CHECK_EQUAL(libuni::to_lower_inplace(reinterpret_cast<libuni::char8_t*>(&s[0]), s.size()), 3);
+  BOOST_CHECK_EQUAL(s, "xy \xC8\xBA Z"); // stops in front of U+023A
+}
+
 BOOST_AUTO_TEST_CASE(test_isLowercase) {
   BOOST_CHECK(libuni::isLowercase(std::string("combining mark")));
   BOOST_CHECK(not libuni::isLowercase(std::string("Combining Mark")));
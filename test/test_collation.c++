@@ -0,0 +1,178 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/collation.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace libuni;
+
+namespace {
+  /// Returns whether libuni was built with the DUCET (allkeys.txt), which the ordering tests need.
+  bool
+  ducet() {
+    return collation::version()[0] != '\0';
+  }
+
+  /// Checks that the strings are in strictly ascending order.
+  void
+  check_order(char const *const *strings, std::size_t n, collation::options const &opt = collation::options()) {
+    for(std::size_t i = 1; i < n; ++i) {
+      BOOST_CHECK_MESSAGE(sort_key(std::string(strings[i - 1]), opt) < sort_key(std::string(strings[i]), opt),
+                          "`" << strings[i - 1] << "' < `" << strings[i] << "'");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_levels) {
+  if(not ducet()) {
+    return;
+  }
+  char const *const strings[] = {
+    "a", "A", "\xC3\xA1", "\xC3\x81", "ab", "b", "cote", "cot\xC3\xA9", "c\xC3\xB4te", "c\xC3\xB4t\xC3\xA9"
+  };
+  check_order(strings, sizeof(strings)/sizeof(strings[0]));
+
+  collation::options const primary(collation::primary);
+  BOOST_CHECK(sort_key(std::string("resume"), primary) == sort_key(std::string("R\xC3\xA9sum\xC3\xA9"), primary));
+  collation::options const secondary(collation::secondary);
+  BOOST_CHECK(sort_key(std::string("resume"), secondary) == sort_key(std::string("Resume"), secondary));
+  BOOST_CHECK(sort_key(std::string("resume"), secondary) < sort_key(std::string("r\xC3\xA9sum\xC3\xA9"), secondary));
+  BOOST_CHECK(collate(std::string("a"), std::string("a")) == 0);
+  BOOST_CHECK(collate(std::string("b"), std::string("A")) > 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_key_format) {
+  if(not ducet()) {
+    return;
+  }
+  unsigned char key[16];
+  std::size_t const n = sort_key(std::string("a"), key, sizeof(key));
+  BOOST_REQUIRE_EQUAL(n, 2 + 2 + 2 + 2 + 1);
+  BOOST_CHECK_EQUAL(key[2], 0); // level separators
+  BOOST_CHECK_EQUAL(key[3], 0);
+  BOOST_CHECK_EQUAL(key[4], 0);
+  BOOST_CHECK_EQUAL(key[5], 0x20); // common secondary
+  BOOST_CHECK_EQUAL(key[8], 0x02); // common tertiary
+
+  unsigned char small[3] = { 0xAA, 0xAA, 0xAA };
+  BOOST_CHECK_EQUAL(sort_key(std::string("a"), small, 2), n);
+  BOOST_CHECK_EQUAL(small[0], key[0]);
+  BOOST_CHECK_EQUAL(small[1], key[1]);
+  BOOST_CHECK_EQUAL(small[2], 0xAA);
+
+  BOOST_CHECK_EQUAL(sort_key(std::string(), key, sizeof(key)), 2 + 2);
+
+  std::string const str("Collation, \xC3\xA9t\xC3\xA9 \xD0\xB8\xCC\x86"); // the returned key has the same bytes
+  unsigned char buffer[128];
+  std::size_t const m = sort_key(str, buffer, sizeof(buffer));
+  BOOST_CHECK(sort_key(str) == std::string(reinterpret_cast<char*>(buffer), m));
+  collation::options const quaternary(collation::quaternary, collation::shifted);
+  BOOST_CHECK(sort_key(str, quaternary).size() == sort_key(str, buffer, sizeof(buffer), quaternary));
+}
+
+namespace {
+  /// std::allocator with an id to tell copies apart.
+  template<typename T>
+  struct tagged_allocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+      typedef tagged_allocator<U> other;
+    };
+
+    int id;
+
+    explicit tagged_allocator(int id = 0)
+      : id(id)
+    { }
+
+    template<typename U>
+    tagged_allocator(tagged_allocator<U> const &rhs)
+      : id(rhs.id)
+    { }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(test_key_allocator) {
+  std::string const str("a key which does not fit the small string buffer");
+  tagged_allocator<char> const alloc(42);
+  std::basic_string<char, std::char_traits<char>, tagged_allocator<char>> const key =
+    sort_key(str, collation::options(), alloc);
+  BOOST_CHECK_EQUAL(key.get_allocator().id, 42);
+  BOOST_CHECK(std::string(key.begin(), key.end()) == sort_key(str));
+}
+
+BOOST_AUTO_TEST_CASE(test_normalization) {
+  if(not ducet()) {
+    return;
+  }
+  // Latin-1 fast path and NFD give the same key
+  BOOST_CHECK(sort_key(std::string("\xC3\xA9")) == sort_key(std::string("e\xCC\x81")));
+  BOOST_CHECK(sort_key(std::u32string(U"\u00E9\u0101")) == sort_key(std::u32string(U"e\u0301a\u0304")));
+  // Hangul syllables are decomposed into jamo
+  BOOST_CHECK(sort_key(std::u32string(U"\uAC00")) == sort_key(std::u32string(U"\u1100\u1161")));
+}
+
+BOOST_AUTO_TEST_CASE(test_contractions) {
+  if(not ducet()) {
+    return;
+  }
+  // Catalan l·l: contraction with the middle dot
+  char const *const strings[] = { "Ll", "L\xC2\xB7l", "Lm" };
+  check_order(strings, sizeof(strings)/sizeof(strings[0]));
+
+  // Cyrillic short i is the contraction и + breve, which also matches with a dot below (ccc 220) in between
+  collation::options const primary(collation::primary);
+  std::string const short_i = sort_key(std::u32string(U"\u0439"), primary);
+  BOOST_CHECK(sort_key(std::u32string(U"\u0438\u0323\u0306"), primary) == short_i);
+  BOOST_CHECK(sort_key(std::u32string(U"\u0439\u0323"), primary) == short_i);
+  BOOST_CHECK(sort_key(std::u32string(U"\u0438\u0323"), primary) != short_i);
+  // but not if it is blocked
+  BOOST_CHECK(sort_key(std::u32string(U"\u0438\u0301\u0306"), primary) != short_i);
+}
+
+BOOST_AUTO_TEST_CASE(test_implicit_weights) {
+  if(not ducet()) {
+    return;
+  }
+  char const *const strings[] = {
+    "z",
+    "\xF0\x97\x80\x80", // U+17000 Tangut (@implicitweights)
+    "\xE4\xB8\x80",     // U+4E00 core Han
+    "\xE9\xBE\xA5",     // U+9FA5
+    "\xE3\x90\x80",     // U+3400 extension A
+    "\xF0\xA0\x80\x80", // U+20000 extension B
+  };
+  check_order(strings, sizeof(strings)/sizeof(strings[0]));
+  BOOST_CHECK(sort_key(std::u32string(U"\U000E0080")) > sort_key(std::u32string(U"\U00020000"))); // unassigned
+}
+
+BOOST_AUTO_TEST_CASE(test_variable_weighting) {
+  if(not ducet()) {
+    return;
+  }
+  char const *const non_ignorable[] = { "a b", "a-b", "ab", "ab-" };
+  check_order(non_ignorable, sizeof(non_ignorable)/sizeof(non_ignorable[0]));
+
+  collation::options const shifted(collation::tertiary, collation::shifted);
+  BOOST_CHECK(sort_key(std::string("a-b"), shifted) == sort_key(std::string("ab"), shifted));
+  BOOST_CHECK(sort_key(std::string("a-b"), shifted) < sort_key(std::string("aB"), shifted));
+
+  collation::options const quaternary(collation::quaternary, collation::shifted);
+  char const *const strings[] = { "a b", "a-b", "ab", "aB" };
+  check_order(strings, sizeof(strings)/sizeof(strings[0]), quaternary);
+}
+
+BOOST_AUTO_TEST_CASE(test_version) {
+  BOOST_CHECK(collation::version());
+}
+
+BOOST_AUTO_TEST_CASE(test_without_ducet) {
+  if(ducet()) {
+    return;
+  }
+  // without allkeys.txt every code point gets an implicit weight
+  char const *const strings[] = { "", "A", "a", "b", "\xC3\xA9" };
+  check_order(strings, sizeof(strings)/sizeof(strings[0]));
+}
@@ -0,0 +1,159 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/data.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+#include <libuni/segmentation.hpp>
+#include <libuni/collation.hpp>
+#include "data_format.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+  /// Combines all lookups for cp into one value
+  std::size_t
+  lookups(libuni::codepoint_t cp) {
+    std::size_t prefix = 0;
+    libuni::codepoint_t const *begin = 0x0, *end = 0x0;
+    std::size_t h = libuni::helper::get_quick_check(cp);
+    if(libuni::helper::get_decomp_mapping(cp, prefix, begin, end)) {
+      h = h * 31 + prefix;
+      for(; begin != end; ++begin) {
+        h = h * 31 + *begin;
+      }
+    }
+    h = h * 31 + libuni::uppercase_mapping(cp);
+    h = h * 31 + libuni::lowercase_mapping(cp);
+    h = h * 31 + libuni::titlecase_mapping(cp);
+    h = h * 31 + libuni::helper::get_word_breaks(cp);
+    return h;
+  }
+
+  std::string
+  read_data_file() {
+    std::ifstream in(DATA_FILE, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  }
+
+  /// Returns the section name of the data file in content.
+  libuni::data_format::section_entry &
+  section(std::string &content, char const *name) {
+    using namespace libuni::data_format;
+    header const *const head = reinterpret_cast<header const*>(content.data());
+    section_entry *const sections = reinterpret_cast<section_entry*>(&content[sizeof(header)]);
+    for(std::size_t i = 0; i < head->section_count; ++i) {
+      if(std::strcmp(sections[i].name, name) == 0) {
+        return sections[i];
+      }
+    }
+    BOOST_FAIL("no section " << name);
+    return sections[0];
+  }
+
+  /// Sets element i of the array in slot of section name to value.
+  void
+  set_element(std::string &content, char const *name, libuni::data_format::array_slot slot, std::size_t i,
+              std::uint32_t value)
+  {
+    libuni::data_format::array_entry const &a = section(content, name).arrays[slot];
+    BOOST_REQUIRE_LT(i, a.count);
+    std::memcpy(&content[a.offset + i * a.width], &value, a.width); // little endian
+  }
+
+  /// Returns true if data::load rejects content.
+  bool
+  rejected(std::string const &content) {
+    char const *path = "test_data_corrupt.dat";
+    std::ofstream(path, std::ios::binary).write(content.data(), content.size());
+    std::string error;
+    bool const ret = not libuni::data::load(path, &error) and not error.empty();
+    std::remove(path);
+    libuni::data::use_compiled_in();
+    return ret;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_load) {
+  std::vector<std::size_t> compiled_in;
+  for(libuni::codepoint_t cp = 0; cp < 0x110000; ++cp) {
+    compiled_in.push_back(lookups(cp));
+  }
+  std::string const version = libuni::data::unicode_version();
+  std::string const collation_version = libuni::collation::version();
+  std::u32string const text = U"L\u00B7l \u0438\u0323\u0306 \uAC00 \u4E00 \U00017000 \U000E0080";
+  std::string const key = libuni::sort_key(text);
+
+  std::string error;
+  BOOST_REQUIRE_MESSAGE(libuni::data::load(DATA_FILE, &error), error);
+  BOOST_CHECK_EQUAL(libuni::data::unicode_version(), version);
+  for(libuni::codepoint_t cp = 0; cp < 0x110000; ++cp) {
+    if(lookups(cp) != compiled_in[cp]) {
+      BOOST_ERROR("lookups differ for " << cp);
+      break;
+    }
+  }
+  BOOST_CHECK_EQUAL(libuni::toNFD(std::string("UÜO")), "UU\xCC\x88O");
+  BOOST_CHECK_EQUAL(libuni::collation::version(), collation_version);
+  BOOST_CHECK(libuni::sort_key(text) == key);
+
+  libuni::data::use_compiled_in();
+  BOOST_CHECK_EQUAL(lookups(0xDC), compiled_in[0xDC]);
+}
+
+BOOST_AUTO_TEST_CASE(test_load_bad_file) {
+  std::string error;
+  BOOST_CHECK(not libuni::data::load("/nonexistent/libuni.dat", &error));
+  BOOST_CHECK(not error.empty());
+
+  // truncated data file
+  std::string const content = read_data_file();
+  BOOST_REQUIRE(content.size() > 1000);
+  char const *path = "test_data_truncated.dat";
+  std::ofstream(path, std::ios::binary).write(content.data(), 1000);
+  error.clear();
+  BOOST_CHECK(not libuni::data::load(path, &error));
+  BOOST_CHECK(not error.empty());
+  std::remove(path);
+
+  // still using the compiled-in tables
+  BOOST_CHECK_EQUAL(libuni::uppercase_mapping(0x61), 0x41);
+}
+
+BOOST_AUTO_TEST_CASE(test_load_corrupt_file) {
+  using namespace libuni::data_format;
+  std::string const content = read_data_file();
+  BOOST_REQUIRE(not rejected(content));
+
+  std::string c = content; // the index has to cover every code point
+  section(c, "quick_check").arrays[index1_slot].count = 1;
+  BOOST_CHECK(rejected(c));
+
+  c = content; // a block beyond data
+  set_element(c, "simple_uppercase_mapping", index1_slot, 5, 0xFFFF);
+  BOOST_CHECK(rejected(c));
+
+  c = content;
+  set_element(c, "properties", bmp_index_slot, 3, 0xFFFF);
+  BOOST_CHECK(rejected(c));
+
+  c = content;
+  set_element(c, "properties", index2_slot, 0, 0xFFFF);
+  BOOST_CHECK(rejected(c));
+
+  c = content; // offsets into the other arrays
+  set_element(c, "decomp_index", data_slot, 0, 0xFFFF);
+  BOOST_CHECK(rejected(c));
+
+  c = content;
+  set_element(c, "collation_index", data_slot, 0, 0xFFFFFF01);
+  BOOST_CHECK(rejected(c));
+
+  c = content;
+  section(c, "collation_ascii").arrays[index1_slot].count = 0x40;
+  BOOST_CHECK(rejected(c));
+}
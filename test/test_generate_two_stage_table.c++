@@ -91,10 +91,11 @@ BOOST_AUTO_TEST_CASE(test_handle_decomp_mapping) {
   std::vector<std::size_t> index(11, 0);
   std::vector<codepoint_t> map;
   std::vector<std::string> prefix;
+  decomp_cache_t cache;
 
   codepoint_t cp = 1;
   std::string str = "004C 004A";
-  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix));
+  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix, cache));
   BOOST_CHECK_EQUAL(index[cp], 0);
   BOOST_REQUIRE_EQUAL(map.size(), 3);
   BOOST_CHECK_EQUAL(map[0] >> 8, 2);
@@ -104,7 +105,7 @@ BOOST_AUTO_TEST_CASE(test_handle_decomp_mapping) {
 
   cp = 2;
   str = "<compat> 0064 017E";
-  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix));
+  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix, cache));
   BOOST_CHECK_EQUAL(index[cp], 3);
   BOOST_REQUIRE_EQUAL(map.size(), 6);
   BOOST_CHECK_EQUAL(map[3], 2 << 8);
@@ -115,7 +116,7 @@ BOOST_AUTO_TEST_CASE(test_handle_decomp_mapping) {
 
   cp = 3;
   str = "004C 004A";
-  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix));
+  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix, cache));
   BOOST_CHECK_EQUAL(index[cp], 0);
   BOOST_CHECK_EQUAL(map.size(), 6);
   BOOST_CHECK_EQUAL(map[0] >> 8, 2);
@@ -124,7 +125,7 @@ BOOST_AUTO_TEST_CASE(test_handle_decomp_mapping) {
 
   cp = 4;
   str = "<noBreak> 0020";
-  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix));
+  BOOST_REQUIRE(handle_decomp_mapping(cp, str, index, map, prefix, cache));
   BOOST_CHECK_EQUAL(index[cp], 6);
   BOOST_REQUIRE_EQUAL(map.size(), 8);
   BOOST_CHECK_EQUAL(map[6], 1 << 8 | 1);
@@ -132,3 +133,139 @@ BOOST_AUTO_TEST_CASE(test_handle_decomp_mapping) {
   BOOST_REQUIRE_EQUAL(prefix.size(), 2);
   BOOST_CHECK_EQUAL(prefix[1], "noBreak");
 }
+
+BOOST_AUTO_TEST_CASE(test_build_layout) {
+  std::vector<std::uint16_t> t(0x30000, 0);
+  for(codepoint_t cp = 0; cp < t.size(); ++cp) {
+    if(cp % 7 == 0 or (0x1F600 <= cp and cp < 0x1F650)) {
+      t[cp] = cp & 0xFFF;
+    }
+  }
+  for(std::size_t layout = 0; layout < table_layouts; ++layout) {
+    layout_table<std::uint16_t> const table = build_layout(t, static_cast<table_layout>(layout));
+    BOOST_CHECK_EQUAL(table.layout, layout);
+    BOOST_CHECK_LT(table.bytes(), t.size() * sizeof(t[0]));
+    for(codepoint_t cp = 0; cp < t.size(); ++cp) {
+      if(table.lookup(cp) != t[cp]) {
+        BOOST_ERROR("lookup(" << cp << ") failed for " << table_layout_names[layout]);
+        break;
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_layout_width) {
+  using namespace libuni::data_format;
+  std::vector<std::uint16_t> t(0x30000, 0); // one block: every index fits in a byte
+  t[0x41] = 1;
+  layout_table<std::uint16_t> const table = build_layout(t, bmp_trie, 4);
+  BOOST_CHECK_EQUAL(table.width(bmp_index_slot), 2);
+  BOOST_CHECK_EQUAL(table.width(index1_slot), 2);
+  BOOST_CHECK_EQUAL(table.width(index2_slot), 2);
+  BOOST_CHECK_EQUAL(table.width(data_slot), 4);
+  BOOST_CHECK_EQUAL(build_layout(t, two_stage).width(data_slot), 1);
+  t[0x42] = 0xFFFF;
+  BOOST_CHECK_EQUAL(build_layout(t, two_stage).width(data_slot), 2);
+
+  // padded to whole 32 bit words for lookup_properties
+  for(std::size_t layout = 0; layout < table_layouts; ++layout) {
+    layout_table<std::uint16_t> const padded = build_layout(t, static_cast<table_layout>(layout));
+    BOOST_CHECK_EQUAL(padded.latin1.size() * padded.width(latin1_slot) % 4, 0);
+    BOOST_CHECK_EQUAL(padded.bmp_index.size() * padded.width(bmp_index_slot) % 4, 0);
+    BOOST_CHECK_EQUAL(padded.index1.size() * padded.width(index1_slot) % 4, 0);
+    BOOST_CHECK_EQUAL(padded.index2.size() * padded.width(index2_slot) % 4, 0);
+    BOOST_CHECK_EQUAL(padded.data.size() * padded.width(data_slot) % 4, 0);
+    BOOST_CHECK_EQUAL(padded.lookup(0x42), 0xFFFF);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_select_layout) {
+  std::vector<std::uint16_t> t(0x30000, 0);
+  std::stringstream comment;
+  BOOST_CHECK_EQUAL(select_layout(t, "t", "bmp_trie", comment).layout, bmp_trie);
+  BOOST_CHECK_EQUAL(select_layout(t, "t", "two_stage", comment).layout, two_stage);
+
+  layout_table<std::uint16_t> const smallest = select_layout(t, "t", "size", comment);
+  for(std::size_t layout = 0; layout < table_layouts; ++layout) {
+    BOOST_CHECK_LE(smallest.bytes(), build_layout(t, static_cast<table_layout>(layout)).bytes());
+  }
+
+  std::stringstream timed; // the timings are not written to the generated files
+  select_layout(t, "t", "speed", timed);
+  BOOST_CHECK_EQUAL(timed.str().find("ns/lookup"), std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_ucd_version) {
+  BOOST_CHECK_EQUAL(ucd_version("# DerivedNormalizationProps-6.1.0.txt"), "6.1.0");
+  BOOST_CHECK_EQUAL(ucd_version("# Unicode Data"), "unknown");
+}
+
+BOOST_AUTO_TEST_CASE(test_read_scripts) {
+  using namespace libuni::data_format::properties;
+  std::ifstream in(TEST_DATA_PATH "Scripts.txt");
+  BOOST_REQUIRE(in);
+  std::vector<std::uint16_t> props(codepoint_limit, 0);
+  props[0x41] = 1; // the General_Category is kept
+  std::vector<std::string> names(1, "Unknown");
+  read_scripts(in, props, names);
+  std::string const expected[] = { "Unknown", "Common", "Latin", "Greek", "Han", "Inherited" };
+  BOOST_CHECK_EQUAL_COLLECTIONS(names.begin(), names.end(), expected, expected + 6);
+
+  layout_table<std::uint16_t> const table = build_layout(props, bmp_trie);
+  BOOST_CHECK_EQUAL(table.lookup(0x41), 2 << script_shift | 1); // A
+  BOOST_CHECK_EQUAL(table.lookup(0x7A) >> script_shift, 2); // z
+  BOOST_CHECK_EQUAL(table.lookup(0x30) >> script_shift, 1); // 0
+  BOOST_CHECK_EQUAL(table.lookup(0x0391) >> script_shift, 3); // Α
+  BOOST_CHECK_EQUAL(table.lookup(0x03A2) >> script_shift, 0); // unassigned
+  BOOST_CHECK_EQUAL(table.lookup(0x0301) >> script_shift, 5);
+  BOOST_CHECK_EQUAL(table.lookup(0x4E00) >> script_shift, 4);
+  BOOST_CHECK_EQUAL(table.lookup(0x9FCC) >> script_shift, 4);
+  BOOST_CHECK_EQUAL(table.lookup(0x20000) >> script_shift, 4);
+  BOOST_CHECK_EQUAL(table.lookup(0x2A6D7) >> script_shift, 0);
+  BOOST_CHECK_EQUAL(table.lookup(0x1F600) >> script_shift, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_collation_elements) {
+  using namespace libuni::data_format::collation;
+  std::vector<std::uint32_t> ces;
+  BOOST_REQUIRE(parse_collation_elements("[.1FA1.0020.0008][.0000.0025.0002]", ces));
+  BOOST_REQUIRE_EQUAL(ces.size(), 2);
+  BOOST_CHECK_EQUAL(ces[0], 0x1FA1u << primary_shift | 0x20 << secondary_shift | 0x08 << tertiary_shift);
+  BOOST_CHECK_EQUAL(ces[1], 0x25u << secondary_shift | 0x02 << tertiary_shift);
+  BOOST_REQUIRE(parse_collation_elements("[*0209.0020.0002]", ces));
+  BOOST_REQUIRE_EQUAL(ces.size(), 1);
+  BOOST_CHECK_EQUAL(ces[0], 0x0209u << primary_shift | 0x20 << secondary_shift | 0x02 << tertiary_shift | variable);
+  BOOST_CHECK(not parse_collation_elements("", ces));
+  BOOST_CHECK(not parse_collation_elements("[.0000.0200.0002]", ces)); // secondary too large
+}
+
+BOOST_AUTO_TEST_CASE(test_implicit_weight_base) {
+  BOOST_CHECK_EQUAL(implicit_weight_base(0x4E00, "<CJK Ideograph, First>", ""), 0xFB40);
+  BOOST_CHECK_EQUAL(implicit_weight_base(0x4E01, "CJK UNIFIED IDEOGRAPH-4E01", ""), 0xFB40);
+  BOOST_CHECK_EQUAL(implicit_weight_base(0xFA0E, "CJK COMPATIBILITY IDEOGRAPH-FA0E", ""), 0xFB40);
+  BOOST_CHECK_EQUAL(implicit_weight_base(0xF900, "CJK COMPATIBILITY IDEOGRAPH-F900", "8C48"), 0);
+  BOOST_CHECK_EQUAL(implicit_weight_base(0x3400, "<CJK Ideograph Extension A, First>", ""), 0xFB80);
+  BOOST_CHECK_EQUAL(implicit_weight_base(0x0041, "LATIN CAPITAL LETTER A", ""), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_general_category) {
+  using namespace libuni::data_format::properties;
+  BOOST_CHECK_EQUAL(general_category("Cn"), 0);
+  BOOST_CHECK_EQUAL(general_category_names[general_category("Lu")], std::string("Lu"));
+  BOOST_CHECK_EQUAL(general_category_names[general_category("Co")], std::string("Co"));
+  BOOST_CHECK_EQUAL(general_category("LC"), 0); // not a value of UnicodeData.txt
+}
+
+BOOST_AUTO_TEST_CASE(test_splitbins) {
+  std::vector<std::uint8_t> t(1000, 1); // not a power of two
+  for(std::size_t i = 0; i < t.size(); i += 3) {
+    t[i] = i % 5;
+  }
+  std::vector<std::size_t> t1;
+  std::vector<std::uint8_t> t2;
+  std::size_t shift = 0;
+  splitbins(t, t1, t2, shift);
+  for(std::size_t i = 0; i < t.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(t2[(t1[i >> shift] << shift) + (i & ((1 << shift) - 1))], t[i]);
+  }
+}
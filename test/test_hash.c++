@@ -0,0 +1,60 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/hash.hpp>
+
+#include <libuni/utf8.hpp>
+#include <libuni/utf16.hpp>
+#include <libuni/utf32.hpp>
+
+#include <string>
+
+using namespace libuni;
+
+BOOST_AUTO_TEST_CASE(test_hash_bytes) {
+  std::string const s = "The quick brown fox jumps over the lazy dog";
+  char8_t const *const p = reinterpret_cast<char8_t const*>(s.data());
+  helper::hash_state whole;
+  helper::hash_bytes(whole, p, s.size());
+  for(std::size_t split = 0; split <= s.size(); ++split) {
+    helper::hash_state parts;
+    helper::hash_bytes(parts, p, split);
+    helper::hash_bytes(parts, p + split, s.size() - split);
+    BOOST_CHECK_EQUAL(helper::hash_final(parts), helper::hash_final(whole));
+  }
+  helper::hash_state shorter;
+  helper::hash_bytes(shorter, p, s.size() - 1);
+  BOOST_CHECK_NE(helper::hash_final(shorter), helper::hash_final(whole));
+}
+
+BOOST_AUTO_TEST_CASE(test_nfc_hash) {
+  std::string const composed = "R\xC3\xA9sum\xC3\xA9";
+  std::string const decomposed = "Re\xCC\x81sume\xCC\x81";
+  BOOST_CHECK_EQUAL(nfc_hash(composed), nfc_hash(decomposed));
+  BOOST_CHECK_EQUAL(nfd_hash(composed), nfd_hash(decomposed));
+  BOOST_CHECK_NE(nfc_hash(composed), nfc_hash(std::string("Resume")));
+
+  // the fast path (input already normalized) and the normalizing path agree
+  BOOST_CHECK_EQUAL(nfc_hash(composed), nfc_hash(toNFC(decomposed)));
+  BOOST_CHECK_EQUAL(nfd_hash(decomposed), nfd_hash(toNFD(composed)));
+
+  // the encoding of the input does not matter
+  BOOST_CHECK_EQUAL(nfc_hash(std::u32string(U"Résumé")), nfc_hash(composed));
+  BOOST_CHECK_EQUAL(nfd_hash(std::u32string(U"Résumé")), nfd_hash(decomposed));
+
+  // canonical order and Hangul
+  BOOST_CHECK_EQUAL(nfc_hash(std::string("a\xCC\x81\xCC\xA3")), nfc_hash(std::string("a\xCC\xA3\xCC\x81")));
+  BOOST_CHECK_EQUAL(nfc_hash(std::u32string(U"각")), nfc_hash(std::u32string(U"각")));
+  BOOST_CHECK_EQUAL(nfc_hash(std::string()), nfd_hash(std::string()));
+}
+
+BOOST_AUTO_TEST_CASE(test_canonically_equal) {
+  BOOST_CHECK(canonically_equal(std::string("caf\xC3\xA9"), std::string("cafe\xCC\x81")));
+  BOOST_CHECK(canonically_equal(std::string("a\xCC\x81\xCC\xA3"), std::string("a\xCC\xA3\xCC\x81")));
+  BOOST_CHECK(canonically_equal(std::string("\xE2\x84\xAB"), std::string("\xC3\x85"))); // ANGSTROM SIGN
+  BOOST_CHECK(canonically_equal(std::u32string(U"가"), std::u32string(U"가")));
+  BOOST_CHECK(not canonically_equal(std::string("caf\xC3\xA9"), std::string("cafe")));
+  BOOST_CHECK(not canonically_equal(std::string("cafe"), std::string("cafe\xCC\x81")));
+  BOOST_CHECK(not canonically_equal(std::string("\xEF\xAC\x81"), std::string("fi"))); // compatibility only
+  BOOST_CHECK(canonically_equal(std::string(), std::string()));
+}
@@ -0,0 +1,92 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/literal.hpp>
+
+#include <libuni/utf8.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+
+#include <string>
+
+using namespace libuni;
+
+namespace {
+  // evaluated by the compiler
+  constexpr auto nfc = literal_nfc("Re\xCC\x81sume\xCC\x81");
+  static_assert(nfc.size() == 8, "e + U+0301 is composed to U+00E9");
+  static_assert(nfc[1] == '\xC3' and nfc[2] == '\xA9', "U+00E9");
+  static_assert(literal_nfd("\xEA\xB0\x81").size() == 9, "a Hangul syllable has three Jamo");
+  static_assert(literal_nfkc("\xEF\xAC\x81").size() == 2, "U+FB01 is fi");
+  static_assert(literal_lowercase("ABC").c_str()[0] == 'a', "");
+  static_assert(literal_nfc("").size() == 0, "");
+  static_assert(literal_nfc("x\xC0\x80y").size() == 1, "an overlong NUL ends the input");
+  static_assert(literal_nfc("x\xE0\x80\x80y").size() == 1, "overlong");
+  static_assert(literal_nfc("x\xED\xA0\x80y").size() == 1, "a surrogate ends the input");
+  static_assert(literal_nfc("x\xF4\x90\x80\x80y").size() == 1, "above U+10FFFF");
+  static_assert(literal_nfc("x\xF5\x80\x80\x80y").size() == 1, "F5 is no lead byte");
+
+  std::string const samples[] = {
+    "Re\xCC\x81sume\xCC\x81 R\xC3\xA9sum\xC3\xA9",
+    "\xEF\xAC\x81le \xE2\x84\xAB \xE2\x91\xA0 \xEF\xB7\xBA",       // ﬁle Å ① U+FDFA
+    "\xEA\xB0\x81\xE1\x84\x80\xE1\x85\xA1\xE1\x86\xA8",             // Hangul syllable and Jamo
+    "a\xCC\x95\xCC\x81\xCC\xA3 q\xCC\x87\xCC\xA3 \xE1\xBE\x82",     // reordering
+    "H\xC3\x96LLE \xC8\xBA \xE2\xB1\xA5 \xCE\xA3\xCE\x8A"
+  };
+}
+
+BOOST_AUTO_TEST_CASE(test_literal_next_codepoint) {
+  char const s[] = "a\xC3\xA9\xE2\x82\xAC\xF0\x9D\x84\x9E";
+  char const *i = s;
+  char const *const end = s + sizeof(s) - 1;
+  codepoint_t cp = 0;
+  std::u32string out;
+  char encoded[sizeof(s)] = { };
+  std::size_t n = 0;
+  while(literal::next_codepoint(i, end, cp) == utf_ok) {
+    out += cp;
+    n += literal::codepoint_to_utf8(cp, encoded + n);
+  }
+  BOOST_CHECK(out == U"aé€𝄞");
+  BOOST_CHECK_EQUAL(std::string(encoded, n), std::string(s));
+  char const bad[] = "\xE2\x82";
+  i = bad;
+  BOOST_CHECK_EQUAL(literal::next_codepoint(i, bad + 2, cp), incomplete_sequence);
+
+  // the ill-formed sequences rejected by utf8::find_illformed as well
+  char const *const illformed[] = { "\xC0\x80", "\xC1\xBF", "\xE0\x9F\xBF", "\xED\xA0\x80", "\xF0\x8F\xBF\xBF",
+                                    "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xF8\x88\x80\x80" };
+  for(std::size_t k = 0; k < sizeof(illformed) / sizeof(illformed[0]); ++k) {
+    std::string const seq(illformed[k]);
+    i = seq.data();
+    BOOST_CHECK_EQUAL(literal::next_codepoint(i, seq.data() + seq.size(), cp), invalid_sequence);
+    unsigned char const *const bytes = reinterpret_cast<unsigned char const*>(seq.data());
+    BOOST_CHECK(utf8::find_illformed(bytes, bytes + seq.size()) == bytes);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_literal_runtime_equal) {
+  // the same literals through the constexpr functions (called at runtime here) and the library
+#define LIBUNI_CHECK_LITERAL(s, i)                                        \
+  BOOST_CHECK_EQUAL(literal_nfd(s).str(), toNFD(samples[i]));             \
+  BOOST_CHECK_EQUAL(literal_nfkd(s).str(), toNFKD(samples[i]));           \
+  BOOST_CHECK_EQUAL(literal_nfc(s).str(), toNFC(samples[i]));             \
+  BOOST_CHECK_EQUAL(literal_nfkc(s).str(), toNFKC(samples[i]));           \
+  BOOST_CHECK_EQUAL(literal_lowercase(s).str(), toLowercase(samples[i])); \
+  BOOST_CHECK_EQUAL(literal_uppercase(s).str(), toUppercase(samples[i]))
+
+  LIBUNI_CHECK_LITERAL("Re\xCC\x81sume\xCC\x81 R\xC3\xA9sum\xC3\xA9", 0);
+  LIBUNI_CHECK_LITERAL("\xEF\xAC\x81le \xE2\x84\xAB \xE2\x91\xA0 \xEF\xB7\xBA", 1);
+  LIBUNI_CHECK_LITERAL("\xEA\xB0\x81\xE1\x84\x80\xE1\x85\xA1\xE1\x86\xA8", 2);
+  LIBUNI_CHECK_LITERAL("a\xCC\x95\xCC\x81\xCC\xA3 q\xCC\x87\xCC\xA3 \xE1\xBE\x82", 3);
+  LIBUNI_CHECK_LITERAL("H\xC3\x96LLE \xC8\xBA \xE2\xB1\xA5 \xCE\xA3\xCE\x8A", 4);
+#undef LIBUNI_CHECK_LITERAL
+
+  // an ill-formed sequence ends the input (toNFC returns input the quick check accepts as is)
+  BOOST_CHECK_EQUAL(literal_nfc("abc\xC3 def").str(), "abc");
+  BOOST_CHECK_EQUAL(literal_uppercase("abc\xC3 def").str(), toUppercase(std::string("abc\xC3 def")));
+
+  constexpr auto key = literal_nfkc("\xEF\xAC\x81le");
+  BOOST_CHECK_EQUAL(key.str(), "file");
+  BOOST_CHECK_EQUAL(std::string(key.c_str()), "file");
+}
@@ -107,6 +107,48 @@ namespace {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_normalize_unchanged) {
+  std::string const nfc = "R\xC3\xA9sum\xC3\xA9 is already in NFC and long enough to be allocated";
+  std::string s = nfc;
+  char const *const data = s.data();
+  std::string const t = libuni::toNFC(std::move(s)); // moved
+  BOOST_CHECK_EQUAL(t, nfc);
+  BOOST_CHECK(t.data() == data);
+  BOOST_CHECK_EQUAL(libuni::toNFD(std::string(nfc)), libuni::toNFD(nfc));
+  BOOST_CHECK_EQUAL(libuni::toNFKC(std::string("\xEF\xAC\x81")), "fi");
+
+  std::string buffer;
+  BOOST_CHECK(&libuni::normalize_if_needed<libuni::helper::NFC>(nfc, buffer) == &nfc);
+  BOOST_CHECK(buffer.empty());
+  std::string const &d = libuni::normalize_if_needed<libuni::helper::NFD>(nfc, buffer);
+  BOOST_CHECK(&d == &buffer);
+  BOOST_CHECK_EQUAL(d, libuni::toNFD(nfc));
+  BOOST_CHECK_EQUAL(libuni::normalize_if_needed<libuni::helper::NFKC>(std::string("\xEF\xAC\x81"), buffer), "fi");
+  std::u32string buffer32;
+  BOOST_CHECK(libuni::normalize_if_needed<libuni::helper::NFKD>(std::u32string(U"\u212B"), buffer32) ==
+              U"A\u030A");
+
+  libuni::normalization_context<> context;
+  BOOST_CHECK(&libuni::normalize_if_needed<libuni::helper::NFC>(nfc, buffer, context) == &nfc);
+  BOOST_CHECK(context.buffer.empty());
+  BOOST_CHECK(&libuni::normalize_if_needed<libuni::helper::NFD>(nfc, buffer, context) == &buffer);
+  BOOST_CHECK_EQUAL(buffer, libuni::toNFD(nfc));
+  std::size_t const capacity = context.buffer.capacity();
+  BOOST_CHECK_GT(capacity, 0);
+  BOOST_CHECK_EQUAL(libuni::normalize_if_needed<libuni::helper::NFKC>(std::string("\xEF\xAC\x81"), buffer, context), "fi");
+  BOOST_CHECK_EQUAL(context.buffer.capacity(), capacity); // reused
+
+  // buffer keeps its capacity: no allocation once it is large enough
+  std::string const decomposable = "\xC3\x9C" + nfc;
+  std::string const &first = libuni::normalize_if_needed<libuni::helper::NFD>(decomposable, buffer, context);
+  char const *const allocated = first.data();
+  BOOST_CHECK_EQUAL(libuni::normalize_if_needed<libuni::helper::NFD>(std::string("\xC3\x96 x"), buffer, context),
+                    "O\xCC\x88 x");
+  BOOST_CHECK(buffer.data() == allocated);
+  BOOST_CHECK_EQUAL(libuni::normalize_if_needed<libuni::helper::NFD>(decomposable, buffer), libuni::toNFD(decomposable));
+  BOOST_CHECK(buffer.data() == allocated);
+}
+
 BOOST_AUTO_TEST_CASE(test_to_codepoint_string) {
   libuni::codepoint_string_t s = to_codepoint_string("FF 800 3C0");
   BOOST_REQUIRE_EQUAL(s.size(), 3);
@@ -158,8 +200,135 @@ BOOST_AUTO_TEST_CASE(test_toNFD_UCD) {
         BOOST_CHECK_EQUAL(c5_u8, libuni::toNFKD(c4_u8));
         BOOST_CHECK_EQUAL(c5_u8, libuni::toNFKD(c5_u8));
 
-        // TODO other NF* and UTF16
+        BOOST_CHECK(c2 == libuni::toNFC(c1));
+        BOOST_CHECK(c2 == libuni::toNFC(c2));
+        BOOST_CHECK(c2 == libuni::toNFC(c3));
+        BOOST_CHECK(c4 == libuni::toNFC(c4));
+        BOOST_CHECK(c4 == libuni::toNFC(c5));
+
+        BOOST_CHECK(c4 == libuni::toNFKC(c1));
+        BOOST_CHECK(c4 == libuni::toNFKC(c2));
+        BOOST_CHECK(c4 == libuni::toNFKC(c3));
+        BOOST_CHECK(c4 == libuni::toNFKC(c4));
+        BOOST_CHECK(c4 == libuni::toNFKC(c5));
+
+        BOOST_CHECK_EQUAL(c2_u8, libuni::toNFC(c1_u8));
+        BOOST_CHECK_EQUAL(c2_u8, libuni::toNFC(c3_u8));
+        BOOST_CHECK_EQUAL(c4_u8, libuni::toNFC(c5_u8));
+        BOOST_CHECK_EQUAL(c4_u8, libuni::toNFKC(c1_u8));
+        BOOST_CHECK_EQUAL(c4_u8, libuni::toNFKC(c5_u8));
+
+        // TODO UTF16
       }
     }
   }
 }
+
+namespace {
+  template<bool Kompatibility, bool Compose>
+  libuni::codepoint_string_t
+  read_normalized(libuni::codepoint_string_t const &in) {
+    typedef libuni::helper::decoder<libuni::codepoint_string_t::const_iterator,
+                                    libuni::utf_trait<libuni::codepoint_string_t>> decoder_t;
+    libuni::helper::normalizing_reader<decoder_t, Kompatibility, Compose> r(decoder_t(in.begin(), in.end()));
+    libuni::codepoint_string_t out;
+    for(libuni::codepoint_t cp; r.next(cp); ) {
+      out.push_back(cp);
+    }
+    return out;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_normalizing_reader_UCD) {
+  std::ifstream in(UCD_PATH "NormalizationTest" UCD_VERSION ".txt");
+  if(in) {
+    for(boost::optional<std::vector<std::string>> line; in; line = parse_line(in)) {
+      if(not line or line->size() < 5) {
+        continue;
+      }
+      libuni::codepoint_string_t c[5];
+      for(std::size_t i = 0; i < 5; ++i) {
+        c[i] = to_codepoint_string((*line)[i]);
+      }
+      for(std::size_t i = 0; i < 5; ++i) {
+        libuni::codepoint_string_t const &nfd = i < 3 ? c[2] : c[4];
+        libuni::codepoint_string_t const &nfc = i < 3 ? c[1] : c[3];
+        BOOST_CHECK((read_normalized<false, false>(c[i]) == nfd));
+        BOOST_CHECK((read_normalized<false, true>(c[i]) == nfc));
+        BOOST_CHECK((read_normalized<true, false>(c[i]) == c[4]));
+        BOOST_CHECK((read_normalized<true, true>(c[i]) == c[3]));
+      }
+    }
+  }
+}
+
+namespace {
+  /// Counts the allocations made through any of its copies.
+  template<typename T>
+  struct counting_allocator {
+    typedef T value_type;
+
+    std::size_t *count;
+
+    explicit counting_allocator(std::size_t *count)
+      : count(count)
+    { }
+
+    template<typename U>
+    counting_allocator(counting_allocator<U> const &rhs)
+      : count(rhs.count)
+    { }
+
+    T *
+    allocate(std::size_t n) {
+      ++*count;
+      return std::allocator<T>().allocate(n);
+    }
+
+    void
+    deallocate(T *p, std::size_t n) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  };
+
+  template<typename T, typename U>
+  bool
+  operator==(counting_allocator<T> const &lhs, counting_allocator<U> const &rhs) {
+    return lhs.count == rhs.count;
+  }
+
+  template<typename T, typename U>
+  bool
+  operator!=(counting_allocator<T> const &lhs, counting_allocator<U> const &rhs) {
+    return lhs.count != rhs.count;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_normalization_allocator) {
+  typedef std::basic_string<char, std::char_traits<char>, counting_allocator<char>> string_t;
+  std::size_t strings = 0, buffers = 0;
+  counting_allocator<char> const alloc(&strings);
+  string_t const in("Ame\xCC\x81lie, long enough not to fit the small string buffer \xE2\x84\xAB", alloc);
+
+  BOOST_CHECK(libuni::simd::helper::contiguous_bytes<string_t::const_iterator>::value); // SIMD quick check
+
+  // the results use the allocator of the input
+  string_t const nfc = libuni::toNFC(in);
+  BOOST_CHECK(nfc == string_t("Am\xC3\xA9lie, long enough not to fit the small string buffer \xC3\x85", alloc));
+  BOOST_CHECK(nfc.get_allocator() == alloc);
+  BOOST_CHECK(libuni::toNFKD(in).get_allocator() == alloc);
+  BOOST_CHECK(libuni::is_nfd(libuni::toNFD(in)));
+
+  // the scratch buffer of a context is only allocated once
+  libuni::normalization_context<counting_allocator<libuni::codepoint_t>> context(
+    (counting_allocator<libuni::codepoint_t>(&buffers)));
+  std::size_t const before = strings;
+  for(std::size_t i = 0; i < 10; ++i) {
+    BOOST_CHECK(libuni::toNFC(in, context) == nfc);
+    BOOST_CHECK(libuni::toNFD(in, context) == libuni::toNFD(in));
+  }
+  BOOST_CHECK_EQUAL(buffers, 1u);
+  BOOST_CHECK(strings > before);
+  BOOST_CHECK(libuni::toNFKC(nfc, context) == nfc);
+  BOOST_CHECK_EQUAL(buffers, 1u);
+}
@@ -0,0 +1,96 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/properties.hpp>
+
+#include <libuni/simd.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace libuni;
+
+BOOST_AUTO_TEST_CASE(test_general_category) {
+  BOOST_CHECK_EQUAL(get_properties('A').category(), general_category::Lu);
+  BOOST_CHECK_EQUAL(get_properties('a').category(), general_category::Ll);
+  BOOST_CHECK_EQUAL(get_properties('1').category(), general_category::Nd);
+  BOOST_CHECK_EQUAL(get_properties(' ').category(), general_category::Zs);
+  BOOST_CHECK_EQUAL(get_properties('\n').category(), general_category::Cc);
+  BOOST_CHECK_EQUAL(get_properties(0x01C5).category(), general_category::Lt); // Dž
+  BOOST_CHECK_EQUAL(get_properties(0x0300).category(), general_category::Mn);
+  BOOST_CHECK_EQUAL(get_properties(0x0378).category(), general_category::Cn);
+  BOOST_CHECK_EQUAL(get_properties(0x4E00).category(), general_category::Lo);
+  BOOST_CHECK_EQUAL(get_properties(0x1F600).category(), general_category::So);
+  BOOST_CHECK_EQUAL(get_properties(0x10FFFF).category(), general_category::Cn);
+  BOOST_CHECK_EQUAL(get_properties(0x110000).category(), general_category::Cn);
+
+  BOOST_CHECK_EQUAL(std::string(general_category_name(general_category::Lu)), "Lu");
+  BOOST_CHECK_EQUAL(std::string(general_category_name(general_category::Co)), "Co");
+  BOOST_CHECK(not general_category_name(general_category::type(general_categories)));
+}
+
+BOOST_AUTO_TEST_CASE(test_cased_alphabetic) {
+  BOOST_CHECK(get_properties('A').cased() and get_properties('A').alphabetic());
+  BOOST_CHECK(get_properties(0x00E9).cased() and get_properties(0x00E9).alphabetic()); // é
+  BOOST_CHECK(not get_properties('1').cased() and not get_properties('1').alphabetic());
+  BOOST_CHECK(not get_properties(0x4E00).cased() and get_properties(0x4E00).alphabetic());
+  BOOST_CHECK(get_properties(0x2160).alphabetic()); // Ⅰ (Nl)
+  BOOST_CHECK(not get_properties(0x0378).cased() and not get_properties(0x0378).alphabetic());
+}
+
+BOOST_AUTO_TEST_CASE(test_script) {
+  BOOST_REQUIRE(script_name(0));
+  BOOST_CHECK_EQUAL(std::string(script_name(0)), "Unknown");
+  BOOST_CHECK_EQUAL(get_properties(0x0378).script(), 0);
+  BOOST_CHECK_EQUAL(get_properties(0x110000).script(), 0);
+
+  script_t s = 42;
+  BOOST_CHECK(find_script("Unknown", s));
+  BOOST_CHECK_EQUAL(s, 0);
+  BOOST_CHECK(not find_script("Klingon", s));
+
+  script_t latin, greek, han;
+  // without Scripts.txt in the UCD everything is Unknown (test_read_scripts uses test/data/Scripts.txt)
+  if(not find_script("Latin", latin)) {
+    BOOST_CHECK(not script_name(1));
+    BOOST_CHECK_EQUAL(get_properties('A').script(), 0);
+    return;
+  }
+  BOOST_REQUIRE(find_script("Greek", greek));
+  BOOST_REQUIRE(find_script("Han", han));
+  BOOST_CHECK_EQUAL(std::string(script_name(latin)), "Latin");
+  BOOST_CHECK_EQUAL(get_properties('A').script(), latin);
+  BOOST_CHECK_EQUAL(get_properties(0x0391).script(), greek); // Α
+  BOOST_CHECK_EQUAL(get_properties(0x4E00).script(), han);
+  BOOST_CHECK_EQUAL(get_properties(0x20000).script(), han);
+}
+
+BOOST_AUTO_TEST_CASE(test_lookup_properties) {
+  std::vector<codepoint_t> cps;
+  for(codepoint_t cp = 0; cp < 0x110000; cp += 7) {
+    cps.push_back(cp);
+  }
+  codepoint_t const odd[] = { 0x110000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF, 0xFFFF, 0x10000, 'x' };
+  cps.insert(cps.end(), odd, odd + sizeof(odd) / sizeof(odd[0]));
+
+  for(unsigned l = 0; l <= simd::detected_level(); ++l) {
+    BOOST_REQUIRE(simd::set_level(simd::level(l)));
+    for(std::size_t offset = 0; offset < 9; ++offset) { // unaligned and every length of the tail
+      std::size_t const n = cps.size() - offset;
+      std::vector<character_properties> out(n + 1);
+      out[n].bits = 0xABCD;
+      lookup_properties(cps.data() + offset, n, out.data());
+      BOOST_CHECK_EQUAL(out[n].bits, 0xABCD);
+      for(std::size_t i = 0; i < n; ++i) {
+        if(out[i].bits != get_properties(cps[offset + i]).bits) {
+          BOOST_ERROR("level " << simd::level_name(simd::level(l)) << " U+" << std::hex << cps[offset + i]);
+          break;
+        }
+      }
+    }
+    character_properties last = { 0xABCD };
+    lookup_properties(cps.data(), 0, &last);
+    BOOST_CHECK_EQUAL(last.bits, 0xABCD);
+  }
+  simd::set_level(simd::detected_level());
+}
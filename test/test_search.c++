@@ -0,0 +1,87 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/search.hpp>
+
+#include <libuni/utf8.hpp>
+#include <libuni/utf16.hpp>
+#include <libuni/utf32.hpp>
+
+#include <string>
+
+using namespace libuni;
+
+BOOST_AUTO_TEST_CASE(test_find) {
+  std::string const text = "Le CAFÉ, le café et le cafe\xCC\x81.";
+  searcher const s(std::string("café"));
+  std::size_t begin, end = 0;
+  BOOST_REQUIRE(s.find(text, begin, end, end));
+  BOOST_CHECK_EQUAL(text.substr(begin, end - begin), "CAFÉ");
+  BOOST_REQUIRE(s.find(text, begin, end, end));
+  BOOST_CHECK_EQUAL(text.substr(begin, end - begin), "café");
+  BOOST_REQUIRE(s.find(text, begin, end, end));
+  BOOST_CHECK_EQUAL(text.substr(begin, end - begin), "cafe\xCC\x81");
+  BOOST_CHECK(not s.find(text, begin, end, end));
+
+  BOOST_CHECK_EQUAL(find(text, std::string("cafe\xCC\x81")), 3);
+  BOOST_CHECK_EQUAL(find(text, std::string("le")), 0);
+  BOOST_CHECK_EQUAL(find(text, std::string("le"), search::options(false)), 10);
+  BOOST_CHECK_EQUAL(find(text, std::string("tea")), search::npos);
+  BOOST_CHECK_EQUAL(find(text, std::string()), 0);
+  BOOST_CHECK_EQUAL(find(std::string(), std::string("a")), search::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_combining_marks) {
+  // cafe does not match café unless accents are ignored
+  BOOST_CHECK_EQUAL(find(std::string("café"), std::string("cafe")), search::npos);
+  BOOST_CHECK_EQUAL(find(std::string("cafe\xCC\x81"), std::string("cafe")), search::npos);
+  search::options const ignore_accents = search::options::accent_insensitive();
+  BOOST_CHECK(ignore_accents.ignore_case and ignore_accents.ignore_accents);
+  BOOST_CHECK_EQUAL(find(std::string("café"), std::string("cafe"), ignore_accents), 0);
+  BOOST_CHECK_EQUAL(find(std::string("Café"), std::string("cafe"), ignore_accents), 0);
+  BOOST_CHECK_EQUAL(find(std::string("x CAFE\xCC\x81"), std::string("café"), ignore_accents), 2);
+  std::size_t begin, end;
+  BOOST_REQUIRE(searcher(std::string("cafe"), ignore_accents).find(std::string("le café"), begin, end));
+  BOOST_CHECK_EQUAL(begin, 3);
+  BOOST_CHECK_EQUAL(end, 8);
+
+  // canonical order: dot below (220) and acute (230) in either order
+  std::string const text = "xa\xCC\x81\xCC\xA3y";
+  BOOST_REQUIRE(searcher(std::string("A\xCC\xA3\xCC\x81")).find(text, begin, end));
+  BOOST_CHECK_EQUAL(begin, 1);
+  BOOST_CHECK_EQUAL(end, text.size() - 1);
+  BOOST_CHECK_EQUAL(find(std::string("xạ́y"), std::string("ạ")), search::npos); // acute follows
+  BOOST_CHECK_EQUAL(find(std::string("xạ́y"), std::string("ạ́y")), 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_decomposition) {
+  BOOST_CHECK_EQUAL(find(std::string("ΣΊΣΥΦΟΣ"), std::string("σίσυφος")), 0); // final sigma
+  BOOST_CHECK_EQUAL(find(std::string("한국어"), std::string("국")), 3); // Hangul syllables
+  BOOST_CHECK_EQUAL(find(std::string("Å"), std::string("\xE2\x84\xAB")), 0); // ANGSTROM SIGN
+  BOOST_CHECK_EQUAL(find(std::u32string(U"abcÅ"), std::u32string(U"Å")), 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_long_text) {
+  std::string text;
+  for(std::size_t i = 0; i < 10000; ++i) {
+    text += "Ärger ";
+  }
+  std::size_t const pos = text.size();
+  text += "Übermäßig";
+  BOOST_CHECK_EQUAL(find(text, std::string("ÜBERMÄSSIG")), search::npos); // no special casing
+  BOOST_CHECK_EQUAL(find(text, std::string("übermäßig")), pos);
+  BOOST_CHECK_EQUAL(searcher(std::string("ärger ärger")).find(text, 7), 7);
+
+  // a context keeps its buffer from one search to the next
+  search::context context;
+  searcher const s(std::string("übermäßig"));
+  std::size_t begin, end;
+  BOOST_REQUIRE(s.find(text, begin, end, 0, context));
+  BOOST_CHECK_EQUAL(begin, pos);
+  std::size_t const capacity = context.folded.capacity();
+  helper::folded_codepoint const *const allocated = context.folded.data();
+  BOOST_REQUIRE(s.find(text, begin, end, 0, context));
+  BOOST_CHECK_EQUAL(begin, pos);
+  BOOST_CHECK_EQUAL(context.folded.capacity(), capacity);
+  BOOST_CHECK(context.folded.data() == allocated);
+}
@@ -117,3 +117,93 @@ BOOST_AUTO_TEST_CASE(test_WordBreakTest) {
     BOOST_CHECK(breaks.second.empty());
   }
 }
+
+namespace {
+/// Returns the words of str as found by next_word.
+std::vector<codepoints> forward_words(codepoints const &str) {
+  std::vector<codepoints> words;
+  auto word_begin = str.cbegin();
+  auto word_end = word_begin;
+  while(libuni::next_word(word_begin, word_end, str.cend())) {
+    words.push_back(codepoints{word_begin, word_end});
+  }
+  return words;
+}
+
+void check_previous_word(codepoints const &str) {
+  std::vector<codepoints> words = forward_words(str);
+  auto word_begin = str.cend();
+  auto word_end = word_begin;
+  while(libuni::previous_word(word_begin, word_end, str.cbegin())) {
+    BOOST_REQUIRE(not words.empty());
+    BOOST_CHECK_EQUAL(codepoints(word_begin, word_end), words.back());
+    words.pop_back();
+  }
+  BOOST_CHECK(words.empty());
+}
+
+void check_word_at(codepoints const &str) {
+  std::vector<codepoints> const words = forward_words(str);
+  auto const begin = str.cbegin();
+  auto const end = str.cend();
+  std::size_t word = 0;
+  std::size_t offset_in_word = 0;
+  for(auto pos = begin; pos != end; ++pos) {
+    while(offset_in_word == words[word].size()) {
+      ++word;
+      offset_in_word = 0;
+    }
+    ++offset_in_word;
+    auto word_begin = end;
+    auto word_end = end;
+    BOOST_REQUIRE(libuni::word_at(word_begin, word_end, begin, pos, end));
+    BOOST_CHECK_EQUAL(codepoints(word_begin, word_end), words[word]);
+  }
+  auto word_begin = end;
+  auto word_end = end;
+  BOOST_CHECK(not libuni::word_at(word_begin, word_end, begin, end, end));
+}
+
+// "Hello, world! 3.14 can't\r\n a:b ü̈ テスト_1"
+codepoints const sample = {
+  0x48, 0x65, 0x6C, 0x6C, 0x6F, 0x2C, 0x20, 0x77, 0x6F, 0x72, 0x6C, 0x64, 0x21, 0x20,
+  0x33, 0x2E, 0x31, 0x34, 0x20, 0x63, 0x61, 0x6E, 0x27, 0x74, 0x0D, 0x0A, 0x20,
+  0x61, 0x3A, 0x62, 0x20, 0xFC, 0x308, 0x20, 0x30C6, 0x30B9, 0x30C8, 0x5F, 0x31
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_is_word_boundary) {
+  using namespace libuni;
+  using namespace libuni::break_property;
+  BOOST_CHECK(not helper::is_word_boundary(CR, LF));
+  BOOST_CHECK(helper::is_word_boundary(LF, CR));
+  BOOST_CHECK(helper::is_word_boundary(ALetter, None));
+  BOOST_CHECK(helper::is_word_boundary(None, ALetter));
+  BOOST_CHECK(not helper::is_word_boundary(ALetter, ALetter));
+  BOOST_CHECK(not helper::is_word_boundary(ALetter, Extend));
+  BOOST_CHECK(not helper::is_word_boundary(Extend, ALetter));
+  BOOST_CHECK(not helper::is_word_boundary(MidLetter, ALetter));
+}
+
+BOOST_AUTO_TEST_CASE(test_previous_word) {
+  check_previous_word(sample);
+  check_previous_word(codepoints());
+
+  std::ifstream in(UCD_PATH "auxiliary/WordBreakTest.txt");
+  breaks_t breaks;
+  std::string line;
+  while(get_next_break_test(in, breaks, line)) {
+    check_previous_word(breaks.first);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_word_at) {
+  check_word_at(sample);
+
+  std::ifstream in(UCD_PATH "auxiliary/WordBreakTest.txt");
+  breaks_t breaks;
+  std::string line;
+  while(get_next_break_test(in, breaks, line)) {
+    check_word_at(breaks.first);
+  }
+}
@@ -0,0 +1,162 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/simd.hpp>
+#include <libuni/utf8.hpp>
+#include <libuni/utf_convert.hpp>
+#include <libuni/normalization.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+using namespace libuni;
+
+namespace {
+  std::uint32_t
+  random(std::uint32_t n) {
+    static std::uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x % n;
+  }
+
+  /// Mostly ASCII with multi-byte sequences and (if invalid) bad bytes at random positions.
+  std::string
+  random_utf8(std::size_t size, bool invalid) {
+    static char const *const pieces[] = {
+      "\xC3\xBC", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xED\x9F\xBF", "\xF4\x8F\xBF\xBF", "\xEE\x80\x80"
+    };
+    static char const *const bad[] = {
+      "\x80", "\xC0\xAF", "\xE0\x80\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xFF", "\xC3", "\xF0\x9F\x98"
+    };
+    std::string s;
+    while(s.size() < size) {
+      std::uint32_t const r = random(64);
+      if(r < 4) {
+        s += pieces[random(sizeof(pieces)/sizeof(pieces[0]))];
+      }
+      else if(r == 4 and invalid) {
+        s += bad[random(sizeof(bad)/sizeof(bad[0]))];
+      }
+      else {
+        s.push_back(char(' ' + random(95)));
+      }
+    }
+    return s;
+  }
+
+  std::size_t
+  ascii_prefix_reference(std::string const &s) {
+    std::size_t i = 0;
+    while(i < s.size() and static_cast<unsigned char>(s[i]) < 0x80) {
+      ++i;
+    }
+    return i;
+  }
+
+  /// Runs f for every level the CPU supports.
+  template<typename F>
+  void
+  for_each_level(F f) {
+    for(unsigned l = simd::portable; l <= simd::detected_level(); ++l) {
+      BOOST_REQUIRE(simd::set_level(simd::level(l)));
+      BOOST_TEST_CHECKPOINT("level " << simd::level_name(simd::level(l)));
+      f();
+    }
+    simd::set_level(simd::detected_level());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_levels) {
+  simd::level l;
+  BOOST_CHECK(simd::parse_level("avx2", l));
+  BOOST_CHECK_EQUAL(l, simd::avx2);
+  BOOST_CHECK(simd::parse_level("portable", l));
+  BOOST_CHECK_EQUAL(l, simd::portable);
+  BOOST_CHECK(not simd::parse_level("mmx", l));
+  BOOST_CHECK_EQUAL(l, simd::portable);
+  BOOST_CHECK(not simd::set_level(simd::levels));
+  BOOST_CHECK(simd::active_level() <= simd::detected_level());
+}
+
+BOOST_AUTO_TEST_CASE(test_ascii_prefix) {
+  for_each_level([]() {
+      for(std::size_t n = 0; n < 200; ++n) {
+        std::string s(n, 'a');
+        for(std::size_t pos = 0; pos <= n; pos += 7) {
+          std::string t = s;
+          if(pos < n) {
+            t[pos] = '\xC3';
+          }
+          BOOST_CHECK_EQUAL(simd::ascii_prefix(reinterpret_cast<char8_t const*>(t.data()), t.size()),
+                            ascii_prefix_reference(t));
+        }
+      }
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_ascii_case) {
+  for_each_level([]() {
+      for(std::size_t i = 0; i < 300; ++i) {
+        std::string const s = random_utf8(random(200), false);
+        std::size_t const prefix = ascii_prefix_reference(s);
+        std::string lower = s, upper = s, expected_lower = s, expected_upper = s;
+        for(std::size_t j = 0; j < prefix; ++j) {
+          if('A' <= s[j] and s[j] <= 'Z') {
+            expected_lower[j] = s[j] + ('a' - 'A');
+          }
+          else if('a' <= s[j] and s[j] <= 'z') {
+            expected_upper[j] = s[j] - ('a' - 'A');
+          }
+        }
+        BOOST_CHECK_EQUAL(simd::ascii_to_lower(reinterpret_cast<char8_t*>(&lower[0]), lower.size()), prefix);
+        BOOST_CHECK_EQUAL(lower, expected_lower);
+        BOOST_CHECK_EQUAL(simd::ascii_to_upper(reinterpret_cast<char8_t*>(&upper[0]), upper.size()), prefix);
+        BOOST_CHECK_EQUAL(upper, expected_upper);
+      }
+      std::string edges = "@AZ[`az{@AZ[`az{@AZ[`az{@AZ[`az{@AZ[`az{@AZ[`az{@AZ[`az{@AZ[`az{\x7F";
+      simd::ascii_to_lower(reinterpret_cast<char8_t*>(&edges[0]), edges.size());
+      BOOST_CHECK_EQUAL(edges, "@az[`az{@az[`az{@az[`az{@az[`az{@az[`az{@az[`az{@az[`az{@az[`az{\x7F");
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_is_wellformed) {
+  for_each_level([]() {
+      for(std::size_t i = 0; i < 500; ++i) {
+        std::string const s = random_utf8(random(300), i % 2);
+        std::deque<char8_t> const l(s.begin(), s.end()); // not contiguous: byte by byte validation
+        bool const expected = utf8::is_wellformed(l.begin(), l.end());
+        BOOST_CHECK_EQUAL(simd::utf8_is_wellformed(reinterpret_cast<char8_t const*>(s.data()), s.size()),
+                          expected);
+        BOOST_CHECK_EQUAL(utf8::is_wellformed(s.begin(), s.end()), expected);
+      }
+      char8_t const surrogate[] = { 'a', 'b', 0xED, 0xA0, 0x80 };
+      BOOST_CHECK(not utf8::is_wellformed(surrogate, surrogate + sizeof(surrogate)));
+      BOOST_CHECK(utf8::is_wellformed(surrogate, surrogate));
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_utf8_to_utf32) {
+  for_each_level([]() {
+      for(std::size_t i = 0; i < 500; ++i) {
+        std::string const s = random_utf8(random(300), i % 2);
+        std::deque<char8_t> const l(s.begin(), s.end());
+        BOOST_CHECK(utf8_to_utf32(s) == utf8_to_utf32(l.begin(), l.end()));
+      }
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_quick_check_prefilter) {
+  std::string const ascii(100, 'x');
+  for_each_level([&ascii]() {
+      BOOST_CHECK_EQUAL(isNFD(ascii), Yes);
+      BOOST_CHECK_EQUAL(isNFD(ascii + "\xC3\x9C" + ascii), No); // Ü
+      BOOST_CHECK_EQUAL(isNFD(ascii + "a\xCC\x81\xCC\xA3"), No); // acute (230) before dot below (220)
+      BOOST_CHECK_EQUAL(isNFD(ascii + "a\xCC\xA3\xCC\x81" + ascii), Yes);
+      BOOST_CHECK_EQUAL(isNFD(ascii + "a\xCC\x81" + ascii + "\xCC\xA3"), Yes); // ASCII resets the class
+      BOOST_CHECK(is_nfkd(ascii + "\xCC\xA3" + ascii));
+      BOOST_CHECK(not is_nfkd(ascii + "\xC2\xA0")); // NO-BREAK SPACE
+    });
+}
@@ -0,0 +1,100 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#define LIBUNI_STATS
+#include <boost/test/unit_test.hpp>
+#include <libuni/stats.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+#include <libuni/segmentation.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+using namespace libuni::stats;
+
+BOOST_AUTO_TEST_CASE(test_bucket) {
+  BOOST_CHECK_EQUAL(helper::bucket(0), 0);
+  BOOST_CHECK_EQUAL(helper::bucket(1), 1);
+  BOOST_CHECK_EQUAL(helper::bucket(3), 2);
+  BOOST_CHECK_EQUAL(helper::bucket(4), 3);
+  BOOST_CHECK_EQUAL(helper::bucket(~std::uint64_t(0)), buckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_normalization_counters) {
+  reset();
+  libuni::toNFD(std::string("ascii"));
+  libuni::toNFD(std::string("\xC3\x9C")); // Ü
+  libuni::toNFD(std::string("a\xCC\x81\xCC\xA3")); // a + acute (230) + dot below (220)
+  BOOST_CHECK_EQUAL(libuni::isNFC(std::string("abc")), libuni::Yes);
+  BOOST_CHECK_EQUAL(libuni::isNFD(std::string("\xC3\x9C")), libuni::No);
+
+  snapshot const s = get_thread();
+  BOOST_CHECK_EQUAL(s.counters[normalize_unchanged], 1);
+  BOOST_CHECK_EQUAL(s.counters[normalize_decompose], 2);
+  BOOST_CHECK_EQUAL(s.counters[reorder_swaps], 1);
+  BOOST_CHECK_EQUAL(s.counters[quick_check_yes], 1);
+  BOOST_CHECK_EQUAL(s.counters[quick_check_no], 1);
+  BOOST_CHECK_EQUAL(s.histograms[decompose_stack_depth][helper::bucket(2)], 1); // Ü -> U + diaeresis
+}
+
+BOOST_AUTO_TEST_CASE(test_case_and_invalid_counters) {
+  reset();
+  libuni::toUppercase(std::string("aB"));
+  libuni::toUppercase(std::string("a\xC3")); // incomplete sequence
+  snapshot const s = get_thread();
+  BOOST_CHECK_EQUAL(s.counters[case_changed], 2);
+  BOOST_CHECK_EQUAL(s.counters[case_unchanged], 1);
+  BOOST_CHECK_EQUAL(s.counters[invalid_sequence], 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_words_counter) {
+  reset();
+  std::u32string const text = U"hello world";
+  std::u32string::const_iterator word_begin, word_end = text.begin();
+  while(libuni::next_word(word_begin, word_end, text.end())) {
+  }
+  BOOST_CHECK_EQUAL(get_thread().counters[words], 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_threads) {
+  reset();
+  libuni::toNFD(std::string("\xC3\x9C"));
+  std::thread t([]() {
+      libuni::toNFD(std::string("\xC3\x9C"));
+      libuni::toNFD(std::string("\xC3\x9C"));
+      BOOST_CHECK_EQUAL(get_thread().counters[normalize_decompose], 2);
+    });
+  t.join();
+  BOOST_CHECK_EQUAL(get_thread().counters[normalize_decompose], 1);
+  BOOST_CHECK_EQUAL(get().counters[normalize_decompose], 3); // includes the exited thread
+
+  reset();
+  BOOST_CHECK_EQUAL(get().counters[normalize_decompose], 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_reset_while_counting) {
+  reset();
+  std::size_t const n = 100000;
+  std::atomic<bool> done(false);
+  std::thread t([&]() {
+      for(std::size_t i = 0; i < n; ++i) {
+        LIBUNI_STATS_COUNT(words);
+      }
+      done = true;
+      while(done) { // keep the block registered
+      }
+    });
+  while(not done) {
+    reset();
+    BOOST_CHECK_LE(get().counters[words], n);
+  }
+  reset();
+  BOOST_CHECK_EQUAL(get().counters[words], 0);
+  done = false;
+  t.join();
+  BOOST_CHECK_EQUAL(get().counters[words], 0);
+  LIBUNI_STATS_COUNT(words);
+  BOOST_CHECK_EQUAL(get().counters[words], 1);
+  BOOST_CHECK_EQUAL(get_thread().counters[words], 1);
+}
@@ -20,3 +20,23 @@ BOOST_AUTO_TEST_CASE(test_utf16_bytes_required) {
   BOOST_CHECK_EQUAL(libuni::utf16::bytes_required(0x10302), 4);
   BOOST_CHECK_EQUAL(libuni::utf16::bytes_required(0x004D), 2);
 }
+
+BOOST_AUTO_TEST_CASE(test_utf16_supplementary) {
+  // planes above 1 and BMP code points which look like surrogates to a sloppy mask
+  libuni::codepoint_t const cps[] = { 0xF800, 0xFFFD, 0x10000, 0x1F600, 0x10FFFF };
+  std::u16string str;
+  for(std::size_t n = 0; n < sizeof(cps)/sizeof(*cps); ++n) {
+    libuni::utf_trait<std::u16string>::append(str, cps[n]);
+  }
+  BOOST_CHECK_EQUAL(str.size(), 8u);
+  BOOST_CHECK_EQUAL(str[6], 0xDBFF);
+  BOOST_CHECK_EQUAL(str[7], 0xDFFF);
+
+  std::u16string::const_iterator i = str.begin();
+  libuni::codepoint_t cp;
+  std::size_t n = 0;
+  while(libuni::utf16::next_codepoint(i, str.cend(), cp) == libuni::utf_ok) {
+    BOOST_CHECK_EQUAL(cp, cps[n++]);
+  }
+  BOOST_CHECK_EQUAL(n, sizeof(cps)/sizeof(*cps));
+}
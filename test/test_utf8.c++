@@ -66,6 +66,20 @@ BOOST_AUTO_TEST_CASE(test_utf8_is_wellformed_true) {
   libuni::char8_t const *iter = str;
   libuni::char8_t const *const end = str + sizeof(str);
   BOOST_CHECK(libuni::utf8::is_wellformed(iter, end));
+
+  // U+FF0C, U+E000, U+40000 (see Table 3-7)
+  libuni::char8_t const str2[] = {0xEF, 0xBC, 0x8C, 0xEE, 0x80, 0x80, 0xF1, 0x80, 0x80, 0x80};
+  BOOST_CHECK(libuni::utf8::is_wellformed(str2, str2 + sizeof(str2)));
+}
+
+BOOST_AUTO_TEST_CASE(test_utf8_find_illformed) {
+  // A, U+00FC, a truncated U+5927, B
+  libuni::char8_t const str[] = {0x41, 0xC3, 0xBC, 0xE5, 0xA4, 0x42};
+  libuni::char8_t const *const end = str + sizeof(str);
+  BOOST_CHECK_EQUAL(libuni::utf8::find_illformed(str, end), str + 3);
+  BOOST_CHECK_EQUAL(libuni::utf8::find_illformed(str, str + 3), str + 3);
+  BOOST_CHECK_EQUAL(libuni::utf8::find_illformed(str, str + 4), str + 3); // incomplete
+  BOOST_CHECK_EQUAL(libuni::utf8::find_illformed(str + 2, end), str + 2); // continuation byte
 }
 
 BOOST_AUTO_TEST_CASE(test_utf8_bytes_required) {
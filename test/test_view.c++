@@ -0,0 +1,118 @@
+// -*- mode: c++; coding:utf-8; -*-
+
+#include <boost/test/unit_test.hpp>
+#include <libuni/view.hpp>
+
+#include <libuni/utf8.hpp>
+#include <libuni/utf16.hpp>
+#include <libuni/utf32.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace libuni;
+
+namespace {
+  /// The words of s as next_word finds them.
+  std::vector<std::u32string>
+  eager_words(std::u32string const &s) {
+    std::vector<std::u32string> ret;
+    std::u32string::const_iterator b, e = s.begin();
+    while(next_word(b, e, s.end())) {
+      ret.push_back(std::u32string(b, e));
+    }
+    return ret;
+  }
+
+  template<typename Source>
+  std::vector<std::u32string>
+  lazy_words(Source const &source) {
+    std::vector<std::u32string> ret;
+    view::words_view<Source> w = view::words(source);
+    for(auto i = w.begin(); i != w.end(); ++i) {
+      ret.push_back(std::u32string(i->first, i->second));
+    }
+    return ret;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_decoded) {
+  std::string const s = "a\xC3\xA9\xE2\x82\xAC\xF0\x9D\x84\x9E";
+  std::u32string out;
+  auto v = view::decoded(s);
+  for(auto i = v.begin(); i != v.end(); ++i) {
+    out += *i;
+  }
+  BOOST_CHECK(out == U"aé€𝄞");
+  BOOST_CHECK(view::encoded<std::string>(view::decoded(std::u16string(u"aé€𝄞"))) == s);
+  BOOST_CHECK(view::encoded<std::u32string>(view::decoded(std::string())).empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline) {
+  std::string const s = "R\xC3\xA9sum\xC3\xA9 \xEF\xAC\x81le \xE2\x84\xAB";
+  BOOST_CHECK(view::encoded<std::string>(view::nfd(view::decoded(s))) == toNFD(s));
+  BOOST_CHECK(view::encoded<std::string>(view::nfkc(view::decoded(s))) == toNFKC(s));
+  BOOST_CHECK(view::encoded<std::string>(view::uppercased(view::nfc(view::decoded(s)))) ==
+              toUppercase(toNFC(s)));
+  BOOST_CHECK(view::encoded<std::string>(view::lowercased(view::nfkd(view::decoded(s)))) ==
+              toLowercase(toNFKD(s)));
+}
+
+BOOST_AUTO_TEST_CASE(test_words) {
+  std::u32string const s = U"Can't stop\r\nthe 3.14 rocḱs, क्ष アア";
+  BOOST_CHECK(lazy_words(view::decoded(s)) == eager_words(s));
+
+  // long text: the words cross the refills of the buffer
+  std::u32string text;
+  for(std::size_t i = 0; i < 500; ++i) {
+    text += U"word́́ don't 1,000.5 \r\n";
+    text += std::u32string(i % 70, U'x');
+  }
+  BOOST_CHECK(lazy_words(view::decoded(text)) == eager_words(text));
+
+  std::string const utf8 = view::encoded<std::string>(view::decoded(text));
+  BOOST_CHECK(lazy_words(view::lowercased(view::nfkd(view::decoded(utf8)))) ==
+              eager_words(toLowercase(toNFKD(text))));
+  BOOST_CHECK(lazy_words(view::decoded(std::string())).empty());
+}
+
+namespace {
+  /// Counts the allocations made through any of its copies.
+  template<typename T>
+  struct counting_allocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+      typedef counting_allocator<U> other;
+    };
+
+    std::size_t *count;
+
+    explicit counting_allocator(std::size_t *count)
+      : count(count)
+    { }
+
+    template<typename U>
+    counting_allocator(counting_allocator<U> const &rhs)
+      : count(rhs.count)
+    { }
+
+    T *
+    allocate(std::size_t n) {
+      ++*count;
+      return std::allocator<T>::allocate(n);
+    }
+  };
+}
+
+BOOST_AUTO_TEST_CASE(test_words_allocator) {
+  std::u32string const s = U"the words of a text long enough to need more than one block of code points in the buffer";
+  std::size_t count = 0;
+  auto w = view::words(view::decoded(s), counting_allocator<codepoint_t>(&count));
+  std::vector<std::u32string> words;
+  for(auto i = w.begin(); i != w.end(); ++i) {
+    words.push_back(std::u32string(i->first, i->second));
+  }
+  BOOST_CHECK(words == eager_words(s));
+  BOOST_CHECK(count > 0);
+}
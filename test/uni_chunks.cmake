@@ -0,0 +1,43 @@
+# uni_chunks.cmake --- checks that the uni tool (tools/uni.c++) gives the same output for many small
+# chunks as for a single chunk, for every command and input encoding.  Run by ctest:
+#
+#   cmake -DUNI=path/to/uni -DINPUT=file.txt -DWORK=directory -P uni_chunks.cmake
+#
+# The chunk size is odd, so chunks end inside code points and lines (see chunk_end).
+
+set(chunked -j 3 --chunk-bytes 1001)
+
+# Runs uni with the arguments and sets the variable out to its stdout.  Fails on errors.
+function(uni out)
+  execute_process(COMMAND ${UNI} ${ARGN} RESULT_VARIABLE status OUTPUT_VARIABLE stdout ERROR_VARIABLE stderr)
+  if(NOT status EQUAL 0)
+    message(FATAL_ERROR "uni ${ARGN} failed (${status}): ${stderr}")
+  endif()
+  set(${out} "${stdout}" PARENT_SCOPE)
+endfunction()
+
+# Runs uni with the arguments once with one chunk and once chunked and compares the output.
+function(compare name)
+  uni(whole ${ARGN} -o ${WORK}/${name}.whole)
+  uni(parts ${ARGN} ${chunked} -o ${WORK}/${name}.chunked)
+  if(NOT whole STREQUAL parts)
+    message(FATAL_ERROR "uni ${ARGN}: `${whole}' with one chunk but `${parts}' chunked")
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${WORK}/${name}.whole ${WORK}/${name}.chunked
+                  RESULT_VARIABLE different)
+  if(different)
+    message(FATAL_ERROR "uni ${ARGN}: the chunked output differs")
+  endif()
+endfunction()
+
+file(MAKE_DIRECTORY ${WORK})
+foreach(from utf8 utf16 utf32)
+  set(file ${WORK}/input.${from})
+  uni(ignored transcode -t ${from} ${INPUT} -o ${file})
+  foreach(cmd validate nfc nfd nfkc nfkd lower upper words)
+    compare(${cmd}.${from} ${cmd} -f ${from} ${file})
+  endforeach()
+  foreach(to utf8 utf16 utf32)
+    compare(transcode.${from}.${to} transcode -f ${from} -t ${to} ${file})
+  endforeach()
+endforeach()
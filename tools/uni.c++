@@ -0,0 +1,696 @@
+// -*- mode: c++; coding:utf-8; -*-
+/** uni.c++ --- command line tool to validate, transcode and normalize large files
+ *
+ * Copyright (C) 2011 Rüdiger Sonderfeld <ruediger@c-plusplus.de>
+ *
+ * This file is part of libuni.
+ *
+ ** Commentary:
+ * uni COMMAND [OPTIONS] [FILE...]
+ *
+ *   validate           report the offset of the first ill-formed sequence of every file
+ *   transcode          convert the encoding (-f, -t)
+ *   nfc, nfd, nfkc,    normalize
+ *   nfkd
+ *   lower, upper       map the case (simple case mapping, see case.hpp)
+ *   words              count the words (segments starting with a letter, number or Katakana)
+ *
+ * Files are mapped into memory (stdin, "-" or pipes are read) and split into chunks which are
+ * processed by a pool of threads.  The output of every round of chunks is written in order with one
+ * write(2) per chunk.  UTF-8 is validated in place and only copied for the commands which transform
+ * it (transcoding UTF-8 to UTF-8 writes the mapped input).  Chunks end at code point boundaries, for the normalization and words
+ * commands after a line feed: no normalization or word boundary rule looks across a line feed, so
+ * the result is the same as for the whole file.  A line longer than a chunk makes a larger chunk.
+ *
+ * UTF-16 and UTF-32 are read and written in the byte order of the machine without a BOM.
+ */
+#include <libuni/utf8.hpp>
+#include <libuni/utf16.hpp>
+#include <libuni/utf32.hpp>
+#include <libuni/utf_convert.hpp>
+#include <libuni/normalization.hpp>
+#include <libuni/case.hpp>
+#include <libuni/segmentation.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+  enum command {
+    validate,
+    transcode,
+    nfc,
+    nfd,
+    nfkc,
+    nfkd,
+    lower,
+    upper,
+    words
+  };
+
+  enum encoding {
+    utf8 = 1,  // = size of a code unit
+    utf16 = 2,
+    utf32 = 4
+  };
+
+  struct options {
+    command cmd;
+    encoding from;
+    encoding to;
+    unsigned threads;
+    std::size_t chunk_size;
+    bool verbose;
+    std::string output;
+
+    options()
+      : cmd(validate), from(utf8), to(utf8), threads(std::thread::hardware_concurrency()),
+        chunk_size(8u << 20), verbose(false)
+    { }
+  };
+
+  std::size_t const npos = std::size_t(-1);
+
+  bool
+  parse_command(std::string const &name, command &cmd) {
+    static char const *const names[] = {
+      "validate", "transcode", "nfc", "nfd", "nfkc", "nfkd", "lower", "upper", "words"
+    };
+    for(std::size_t i = 0; i < sizeof(names)/sizeof(*names); ++i) {
+      if(name == names[i]) {
+        cmd = command(i);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool
+  parse_encoding(std::string const &name, encoding &enc) {
+    if(name == "utf8" or name == "UTF-8" or name == "utf-8") {
+      enc = utf8;
+    }
+    else if(name == "utf16" or name == "UTF-16" or name == "utf-16") {
+      enc = utf16;
+    }
+    else if(name == "utf32" or name == "UTF-32" or name == "utf-32") {
+      enc = utf32;
+    }
+    else {
+      return false;
+    }
+    return true;
+  }
+
+  char const *
+  encoding_name(encoding enc) {
+    return enc == utf8 ? "UTF-8" : enc == utf16 ? "UTF-16" : "UTF-32";
+  }
+
+  /// The contents of a file, mapped if possible.
+  class input {
+    char const *data_;
+    std::size_t size_;
+    void *map;
+    std::string buffer;
+
+    input(input const&);
+    input &operator=(input const&);
+
+    bool
+    read_all(int fd) {
+      char tmp[1 << 16];
+      for(;;) {
+        ssize_t const n = ::read(fd, tmp, sizeof(tmp));
+        if(n == 0) {
+          break;
+        }
+        else if(n < 0) {
+          if(errno == EINTR) {
+            continue;
+          }
+          return false;
+        }
+        buffer.append(tmp, n);
+      }
+      data_ = buffer.data();
+      size_ = buffer.size();
+      return true;
+    }
+
+  public:
+    input()
+      : data_(0x0), size_(0), map(MAP_FAILED)
+    { }
+
+    ~input() {
+      if(map != MAP_FAILED) {
+        ::munmap(map, size_);
+      }
+    }
+
+    bool
+    open(std::string const &path) {
+      if(path == "-") {
+        return read_all(STDIN_FILENO);
+      }
+      int const fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0) {
+        return false;
+      }
+      struct stat st;
+      bool ok = ::fstat(fd, &st) == 0;
+      if(ok and S_ISREG(st.st_mode)) {
+        size_ = st.st_size;
+        if(size_ != 0) {
+          map = ::mmap(0x0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+          ok = map != MAP_FAILED;
+          if(ok) {
+            ::madvise(map, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<char const*>(map);
+          }
+        }
+      }
+      else if(ok) { // pipes etc.
+        ok = read_all(fd);
+      }
+      ::close(fd);
+      return ok;
+    }
+
+    char const *
+    data() const {
+      return data_;
+    }
+
+    std::size_t
+    size() const {
+      return size_;
+    }
+  };
+
+  /// Writes everything to fd.
+  bool
+  write_all(int fd, char const *p, std::size_t n) {
+    while(n != 0) {
+      ssize_t const w = ::write(fd, p, n);
+      if(w < 0) {
+        if(errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      p += w;
+      n -= w;
+    }
+    return true;
+  }
+
+  bool
+  is_line_feed(char const *p, encoding enc) {
+    switch(enc) {
+    case utf8:
+      return *p == '\n';
+    case utf16: {
+      char16_t u;
+      std::memcpy(&u, p, sizeof(u));
+      return u == 0x0A;
+    }
+    case utf32: {
+      char32_t u;
+      std::memcpy(&u, p, sizeof(u));
+      return u == 0x0A;
+    }
+    }
+    return false;
+  }
+
+  /// Moves pos (aligned to a code unit) back to the beginning of the code point it points into.
+  std::size_t
+  codepoint_boundary(char const *data, std::size_t size, std::size_t pos, encoding enc) {
+    if(enc == utf8) {
+      std::size_t p = pos;
+      while(pos - p < 3 and p > 0 and (data[p] & 0xC0) == 0x80) {
+        --p;
+      }
+      if((data[p] & 0xC0) == 0x80) { // not well-formed anyway: the first error has to be before pos
+        while(pos < size and (data[pos] & 0xC0) == 0x80) {
+          ++pos;
+        }
+        return pos;
+      }
+      return p;
+    }
+    else if(enc == utf16) {
+      char16_t u;
+      std::memcpy(&u, data + pos, sizeof(u));
+      return (u & 0xFC00) == 0xDC00 ? pos - 2 : pos;
+    }
+    return pos;
+  }
+
+  /// Returns the end of the chunk starting at begin.
+  std::size_t
+  chunk_end(char const *data, std::size_t size, std::size_t begin, options const &opt) {
+    std::size_t pos = begin + opt.chunk_size;
+    if(pos >= size) {
+      return size;
+    }
+    pos -= pos % opt.from;
+    bool const lines = opt.cmd != validate and opt.cmd != transcode and opt.cmd != lower and
+      opt.cmd != upper;
+    if(not lines) {
+      std::size_t const end = codepoint_boundary(data, size, pos, opt.from);
+      return end > begin ? end : size;
+    }
+    if(opt.from == utf8) {
+      void const *const lf = std::memchr(data + pos, '\n', size - pos);
+      return lf ? static_cast<char const*>(lf) - data + 1 : size;
+    }
+    for(; pos + opt.from <= size; pos += opt.from) {
+      if(is_line_feed(data + pos, opt.from)) {
+        return pos + opt.from;
+      }
+    }
+    return size;
+  }
+
+  struct chunk_result {
+    std::string output;
+    bool unchanged; // the output is the chunk itself
+    std::size_t count;
+    std::size_t error; // offset of the first ill-formed sequence in the chunk or npos
+
+    chunk_result()
+      : unchanged(false), count(0), error(npos)
+    { }
+  };
+
+  /// Code units of [p, p + n) as String (copied: the data might not be aligned).
+  template<typename String>
+  String
+  code_units(char const *p, std::size_t n) {
+    String ret(n / sizeof(typename String::value_type), 0);
+    if(not ret.empty()) {
+      std::memcpy(&ret[0], p, n);
+    }
+    return ret;
+  }
+
+  /// Returns the offset of the first ill-formed sequence in the UTF-8 [p, p + n) or npos.
+  std::size_t
+  find_illformed(char const *p, std::size_t n) {
+    libuni::char8_t const *const begin = reinterpret_cast<libuni::char8_t const*>(p);
+    libuni::char8_t const *const end = begin + n;
+    if(libuni::utf8::is_wellformed(begin, end)) { // fast path
+      return npos;
+    }
+    return libuni::utf8::find_illformed(begin, end) - begin;
+  }
+
+  /// Returns the offset (in code units) of the first ill-formed sequence in s or npos.
+  template<typename String>
+  std::size_t
+  find_illformed(String const &s) {
+    typedef typename String::const_iterator iterator_t;
+    iterator_t const end = s.end();
+    iterator_t i = s.begin();
+    libuni::codepoint_t cp;
+    libuni::utf_status status;
+    while((status = libuni::utf_trait<String>::next_codepoint(i, end, cp)) == libuni::utf_ok) {
+    }
+    return status == libuni::end_of_string ? npos : i - s.begin();
+  }
+
+  std::size_t
+  count_words(std::u32string const &s) {
+    using namespace libuni::break_property;
+    std::size_t n = 0;
+    std::u32string::const_iterator word_begin, word_end = s.begin();
+    while(libuni::next_word(word_begin, word_end, s.end())) {
+      unsigned const p = libuni::helper::get_word_breaks(*word_begin);
+      if(p == ALetter or p == Numeric or p == Katakana or p == ExtendNumLet) {
+        ++n;
+      }
+    }
+    return n;
+  }
+
+  void
+  append_bytes(std::string &out, std::string const &s) {
+    out.append(s);
+  }
+
+  template<typename String>
+  void
+  append_bytes(std::string &out, String const &s) {
+    out.append(reinterpret_cast<char const*>(s.data()), s.size() * sizeof(typename String::value_type));
+  }
+
+  /// Appends the code points of [i, end) (code units like those of String) encoded as enc to out.
+  template<typename String, typename Iterator>
+  void
+  encode(std::string &out, Iterator i, Iterator end, encoding enc) {
+    libuni::codepoint_t cp;
+    std::string u8;
+    std::u16string u16;
+    std::u32string u32;
+    while(libuni::utf_trait<String>::next_codepoint(i, end, cp) == libuni::utf_ok) {
+      switch(enc) {
+      case utf8:
+        libuni::utf_trait<std::string>::append(u8, cp);
+        break;
+      case utf16:
+        libuni::utf_trait<std::u16string>::append(u16, cp);
+        break;
+      case utf32:
+        u32.push_back(cp);
+        break;
+      }
+    }
+    append_bytes(out, u8);
+    append_bytes(out, u16);
+    append_bytes(out, u32);
+  }
+
+  /// Appends s encoded as enc to out.
+  template<typename String>
+  void
+  encode(std::string &out, String const &s, encoding enc) {
+    if(enc == encoding(sizeof(typename String::value_type))) {
+      append_bytes(out, s);
+    }
+    else {
+      encode<String>(out, s.begin(), s.end(), enc);
+    }
+  }
+
+  /// UTF-8 to UTF-8 moves s to out (which is empty).
+  void
+  encode(std::string &out, std::string &&s, encoding enc) {
+    if(enc == utf8) {
+      out = std::move(s);
+    }
+    else {
+      encode(out, static_cast<std::string const&>(s), enc);
+    }
+  }
+
+  std::u32string
+  to_utf32(std::string const &s) {
+    return libuni::utf8_to_utf32(s);
+  }
+
+  std::u32string
+  to_utf32(std::u16string const &s) {
+    std::u32string ret;
+    ret.reserve(s.size());
+    std::u16string::const_iterator i = s.begin();
+    libuni::codepoint_t cp;
+    while(libuni::utf16::next_codepoint(i, s.cend(), cp) == libuni::utf_ok) {
+      ret.push_back(cp);
+    }
+    return ret;
+  }
+
+  std::u32string const &
+  to_utf32(std::u32string const &s) {
+    return s;
+  }
+
+  /// Transforms the well-formed chunk in.  It is moved through the library: normalized input is not copied again.
+  template<typename String>
+  void
+  transform(String in, options const &opt, chunk_result &result) {
+    switch(opt.cmd) {
+    case validate:
+      break;
+    case transcode:
+      encode(result.output, std::move(in), opt.to);
+      break;
+    case nfc:
+      encode(result.output, libuni::toNFC(std::move(in)), opt.to);
+      break;
+    case nfd:
+      encode(result.output, libuni::toNFD(std::move(in)), opt.to);
+      break;
+    case nfkc:
+      encode(result.output, libuni::toNFKC(std::move(in)), opt.to);
+      break;
+    case nfkd:
+      encode(result.output, libuni::toNFKD(std::move(in)), opt.to);
+      break;
+    case lower:
+      encode(result.output, libuni::toLowercase(std::move(in)), opt.to);
+      break;
+    case upper:
+      encode(result.output, libuni::toUppercase(std::move(in)), opt.to);
+      break;
+    case words:
+      result.count = count_words(to_utf32(in));
+      break;
+    }
+  }
+
+  /// Validates the chunk in (copied from the input, see code_units) and transforms it.
+  template<typename String>
+  void
+  process(String in, options const &opt, chunk_result &result) {
+    result.error = find_illformed(in);
+    if(result.error != npos) {
+      result.error *= sizeof(typename String::value_type);
+      return;
+    }
+    transform(std::move(in), opt, result);
+  }
+
+  /// UTF-8 is validated in place, only the transformations get a copy.
+  void
+  process_utf8(char const *p, std::size_t n, options const &opt, chunk_result &result) {
+    result.error = find_illformed(p, n);
+    if(result.error != npos) {
+      return;
+    }
+    switch(opt.cmd) {
+    case validate:
+      break;
+    case transcode:
+      if(opt.to == utf8) {
+        result.unchanged = true;
+      }
+      else {
+        encode<std::string>(result.output, p, p + n, opt.to);
+      }
+      break;
+    case words:
+      result.count = count_words(libuni::utf8_to_utf32(p, p + n));
+      break;
+    default:
+      transform(std::string(p, n), opt, result);
+      break;
+    }
+  }
+
+  void
+  process_chunk(char const *p, std::size_t n, options const &opt, chunk_result &result) {
+    switch(opt.from) {
+    case utf8:
+      process_utf8(p, n, opt, result);
+      break;
+    case utf16:
+      process(code_units<std::u16string>(p, n), opt, result);
+      break;
+    case utf32:
+      process(code_units<std::u32string>(p, n), opt, result);
+      break;
+    }
+    if(result.error == npos and n % opt.from != 0) { // trailing bytes
+      result.error = n - n % opt.from;
+    }
+  }
+
+  /** Processes the file in rounds of opt.threads chunks and writes the output to fd.  Returns false
+   * on errors (after reporting them).
+   */
+  bool
+  run(std::string const &name, input const &in, options const &opt, int fd, std::size_t &count) {
+    char const *const data = in.data();
+    std::size_t const size = in.size();
+    std::size_t begin = 0;
+    while(begin < size) {
+      std::vector<std::size_t> bounds(1, begin);
+      while(bounds.size() <= opt.threads and bounds.back() < size) {
+        bounds.push_back(chunk_end(data, size, bounds.back(), opt));
+      }
+      std::size_t const chunks = bounds.size() - 1;
+      std::vector<chunk_result> results(chunks);
+      std::vector<std::thread> pool;
+      for(std::size_t i = 1; i < chunks; ++i) {
+        pool.push_back(std::thread(process_chunk, data + bounds[i], bounds[i + 1] - bounds[i],
+                                   std::cref(opt), std::ref(results[i])));
+      }
+      process_chunk(data + bounds[0], bounds[1] - bounds[0], opt, results[0]);
+      std::for_each(pool.begin(), pool.end(), [](std::thread &t) { t.join(); });
+
+      for(std::size_t i = 0; i < chunks; ++i) {
+        if(results[i].error != npos) {
+          std::cerr << name << ": ill-formed " << encoding_name(opt.from) << " at byte "
+                    << bounds[i] + results[i].error << '\n';
+          return false;
+        }
+        count += results[i].count;
+        std::string const &output = results[i].output;
+        bool const ok = results[i].unchanged ?
+          write_all(fd, data + bounds[i], bounds[i + 1] - bounds[i]) :
+          output.empty() or write_all(fd, output.data(), output.size());
+        if(not ok) {
+          std::cerr << "uni: write failed: " << std::strerror(errno) << '\n';
+          return false;
+        }
+      }
+      begin = bounds.back();
+    }
+    return true;
+  }
+
+  void
+  usage(char const *name) {
+    std::cerr <<
+      "Usage: " << name << " COMMAND [OPTIONS] [FILE...]\n"
+      "Commands:\n"
+      "  validate         check that the files are well-formed\n"
+      "  transcode        convert the encoding (see -f and -t)\n"
+      "  nfc, nfd, nfkc, nfkd\n"
+      "                   normalize\n"
+      "  lower, upper     map the case\n"
+      "  words            count the words\n"
+      "Options:\n"
+      "  -f, --from ENC   encoding of the input: utf8 (default), utf16 or utf32\n"
+      "  -t, --to ENC     encoding of the output (default: the input encoding)\n"
+      "  -o FILE          write the output to FILE instead of stdout\n"
+      "  -j N             use N threads (default: number of CPUs)\n"
+      "  --chunk-size N   size of the chunks in MiB (default: 8)\n"
+      "  --chunk-bytes N  size of the chunks in bytes (at least 4)\n"
+      "  -v, --verbose    report the throughput on stderr\n"
+      "Without a FILE (or with -) stdin is read.  UTF-16/UTF-32 use the byte order of the machine.\n";
+  }
+}
+
+int
+main(int argc, char **argv) {
+  options opt;
+  if(argc < 2 or not parse_command(argv[1], opt.cmd)) {
+    usage(argv[0]);
+    return argc >= 2 and (std::string(argv[1]) == "--help" or std::string(argv[1]) == "-h") ? 0 : 1;
+  }
+  bool to = false;
+  std::vector<std::string> files;
+  for(int i = 2; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if(i + 1 < argc and (arg == "-f" or arg == "--from")) {
+      if(not parse_encoding(argv[++i], opt.from)) {
+        std::cerr << "uni: unknown encoding `" << argv[i] << "'\n";
+        return 1;
+      }
+    }
+    else if(i + 1 < argc and (arg == "-t" or arg == "--to")) {
+      if(not parse_encoding(argv[++i], opt.to)) {
+        std::cerr << "uni: unknown encoding `" << argv[i] << "'\n";
+        return 1;
+      }
+      to = true;
+    }
+    else if(i + 1 < argc and arg == "-o") {
+      opt.output = argv[++i];
+    }
+    else if(i + 1 < argc and arg == "-j") {
+      opt.threads = std::strtoul(argv[++i], 0, 10);
+    }
+    else if(i + 1 < argc and arg == "--chunk-size") {
+      opt.chunk_size = std::strtoul(argv[++i], 0, 10) << 20;
+    }
+    else if(i + 1 < argc and arg == "--chunk-bytes") {
+      opt.chunk_size = std::strtoul(argv[++i], 0, 10);
+    }
+    else if(arg == "-v" or arg == "--verbose") {
+      opt.verbose = true;
+    }
+    else if(arg.size() > 1 and arg[0] == '-') {
+      usage(argv[0]);
+      return arg == "--help" or arg == "-h" ? 0 : 1;
+    }
+    else {
+      files.push_back(arg);
+    }
+  }
+  if(not to) {
+    opt.to = opt.from;
+  }
+  if(opt.threads == 0) {
+    opt.threads = 1;
+  }
+  if(opt.chunk_size == 0) {
+    opt.chunk_size = 1u << 20;
+  }
+  opt.chunk_size = std::max<std::size_t>(opt.chunk_size, 4); // a chunk has to hold a code point
+  if(files.empty()) {
+    files.push_back("-");
+  }
+
+  int fd = STDOUT_FILENO;
+  if(not opt.output.empty()) {
+    fd = ::open(opt.output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(fd < 0) {
+      std::cerr << "uni: " << opt.output << ": " << std::strerror(errno) << '\n';
+      return 1;
+    }
+  }
+
+  int status = 0;
+  std::size_t total = 0;
+  std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+  for(std::vector<std::string>::const_iterator f = files.begin(); f != files.end(); ++f) {
+    input in;
+    if(not in.open(*f)) {
+      std::cerr << "uni: " << *f << ": " << std::strerror(errno) << '\n';
+      status = 1;
+      continue;
+    }
+    std::size_t count = 0;
+    if(not run(*f, in, opt, fd, count)) {
+      status = 1;
+      if(opt.cmd != validate) {
+        break;
+      }
+      continue;
+    }
+    total += in.size();
+    if(opt.cmd == words) {
+      std::cout << count << ' ' << *f << '\n';
+    }
+  }
+  if(fd != STDOUT_FILENO and ::close(fd) != 0) {
+    std::cerr << "uni: " << opt.output << ": " << std::strerror(errno) << '\n';
+    status = 1;
+  }
+
+  if(opt.verbose) {
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "uni: " << argv[1] << ": " << total << " bytes in " << seconds << " s ("
+              << (seconds > 0 ? total / seconds / 1e6 : 0) << " MB/s, " << opt.threads << " threads)\n";
+  }
+  return status;
+}